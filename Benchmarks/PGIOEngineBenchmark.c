@@ -0,0 +1,440 @@
+//
+//  PGIOEngineBenchmark.c
+//  PGRingBuffer
+//
+//  Created by Galen Rhodes on 10/16/26.
+//  Copyright © 2020 Project Galen. All rights reserved.
+//
+//  Measures throughput from one ring buffer to another through a pipe and through a Unix domain socketpair, in a
+//  single process, for several chunk sizes. Plain `PGRingBufferWriteToFd`/`PGRingBufferReadFromFd` is compared
+//  with a PGRingBufferIOEngine in fallback mode and, when the kernel allows it, on io_uring. Every byte received
+//  is checked.
+//
+//  `--verify` instead streams randomly sized writes and reads through each transport with each engine, into and
+//  out of small ring buffers that have to grow, checking every byte. It also checks that a read submitted while a
+//  write is in flight on the same ring buffer doesn't move the storage out from under the write, and that reads
+//  into a full overwriting ring buffer only drop the oldest bytes for what they actually read.
+//
+//  Build: cmake -S . -B build && cmake --build build --target PGIOEngineBenchmark
+//  Usage: PGIOEngineBenchmark [--verify[=rounds]] [MiB per run]
+//
+
+#include "PGRingBufferIOEngine.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/socket.h>
+#include <time.h>
+
+#define PG_MAX_CHUNK (64 * 1024)
+
+typedef enum { PG_DIRECT, PG_FALLBACK, PG_ASYNC } PGMode;
+
+static const char *const gModeNames[] = { "direct", "fallback", "io_uring" };
+
+typedef struct {
+    PGRingBufferIOEngine *engine;
+    PGRingBuffer         *out;
+    PGRingBuffer         *in;
+    int                  wfd;
+    int                  rfd;
+    long                 sent;
+    long                 got;
+    bool                 writing;
+    bool                 reading;
+    bool                 ok;
+} PGStream;
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((double)ts.tv_sec + ((double)ts.tv_nsec / 1e9));
+}
+
+static unsigned long gSeed = 88172645463325252UL;
+
+static long rnd(long n) {
+    gSeed ^= (gSeed << 13);
+    gSeed ^= (gSeed >> 7);
+    gSeed ^= (gSeed << 17);
+    return (long)(gSeed % (unsigned long)n);
+}
+
+/*
+ * Byte `i` of the stream. Not a multiple of 256 apart so that bytes delivered out of order are caught.
+ */
+static inline uint8_t streamByte(long i) {
+    return (uint8_t)((i * 7) + (i >> 8));
+}
+
+static void fillChunk(uint8_t *chunk, long at, long length) {
+    for(long i = 0; i < length; ++i) chunk[i] = streamByte(at + i);
+}
+
+static bool checkChunk(const uint8_t *chunk, long at, long length) {
+    for(long i = 0; i < length; ++i) if(chunk[i] != streamByte(at + i)) return false;
+    return true;
+}
+
+/*
+ * Both ends are non-blocking so that the fallback never blocks the only thread. `fds[0]` is read from and
+ * `fds[1]` is written to.
+ */
+static bool openTransport(bool socket, int fds[2]) {
+    if(socket ? (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) : (pipe(fds) != 0)) return false;
+    fcntl(fds[0], F_SETFL, (fcntl(fds[0], F_GETFL) | O_NONBLOCK));
+    fcntl(fds[1], F_SETFL, (fcntl(fds[1], F_GETFL) | O_NONBLOCK));
+    return true;
+}
+
+static void closeTransport(int fds[2]) {
+    close(fds[0]);
+    close(fds[1]);
+}
+
+static PGRingBufferIOEngine *createEngine(PGMode mode) {
+    if(mode == PG_DIRECT) return NULL;
+
+    PGRingBufferIOEngine *engine = PGCreateRingBufferIOEngine(8, (mode == PG_FALLBACK));
+
+    if(engine && (mode == PG_ASYNC) && !PGRingBufferIOEngineIsAsync(engine)) {
+        PGDiscardRingBufferIOEngine(engine);
+        engine = NULL;
+    }
+    return engine;
+}
+
+static inline bool isRetry(long result) {
+    return ((result == -EAGAIN) || (result == -EWOULDBLOCK));
+}
+
+static void onDone(PGRingBuffer *buff, int fd, bool isWrite, long result, void *context) {
+    PGStream *s = context;
+
+    (void)buff;
+    (void)fd;
+    if(isWrite) s->writing = false; else s->reading = false;
+    if(((result < 0) && !isRetry(result)) || ((result == 0) && !isWrite)) s->ok = false;
+}
+
+static void startWrite(PGStream *s, long maxLength) {
+    if(s->engine) {
+        s->writing = PGRingBufferIOEngineSubmitWrite(s->engine, s->out, s->wfd, maxLength, onDone, s);
+        if(!s->writing) s->ok = false;
+    }
+    else if(PGRingBufferWriteToFd(s->out, s->wfd, maxLength) < 0) {
+        onDone(s->out, s->wfd, true, -errno, s);
+    }
+}
+
+static void startRead(PGStream *s, long maxLength) {
+    if(s->engine) {
+        s->reading = PGRingBufferIOEngineSubmitRead(s->engine, s->in, s->rfd, maxLength, onDone, s);
+        if(!s->reading) s->ok = false;
+    }
+    else {
+        long rc = PGRingBufferReadFromFd(s->in, s->rfd, maxLength);
+        onDone(s->in, s->rfd, false, ((rc < 0) ? -errno : rc), s);
+    }
+}
+
+/*
+ * Streams `total` bytes from `s->out` to `s->in`. With `chunk` greater than zero every write and read is that
+ * size. Otherwise the sizes are random.
+ */
+static bool stream(PGStream *s, long total, long chunk, uint8_t *tmp) {
+    while(s->ok && (s->got < total)) {
+        if(!s->writing) {
+            long n = (chunk ? chunk : (1 + rnd(((rnd(8) == 0) ? PG_MAX_CHUNK : 512))));
+
+            if(n > (total - s->sent)) n = (total - s->sent);
+
+            // Appending could resize the ring buffer so it's only done while nothing is writing out of it.
+            if((n > 0) && (PGRingBufferCount(s->out) < PG_MAX_CHUNK)) {
+                fillChunk(tmp, s->sent, n);
+                if(!PGAppendToRingBuffer(s->out, tmp, n)) return false;
+                s->sent += n;
+            }
+            if(PGRingBufferCount(s->out) > 0) startWrite(s, (chunk ? chunk : rnd(2 * PG_MAX_CHUNK)));
+        }
+
+        if(!s->reading) startRead(s, (chunk ? chunk : (1 + rnd(2 * PG_MAX_CHUNK))));
+
+        if(s->engine && (PGRingBufferIOEngineComplete(s->engine, 1) < 0)) return false;
+
+        if(!s->reading) {
+            PGRingBufferSpan spans[2];
+            long             cc = PGPeekSpansFromRingBuffer(s->in, spans);
+
+            if(!checkChunk(spans[0].bytes, s->got, spans[0].length) || !checkChunk(spans[1].bytes, (s->got + spans[0].length), spans[1].length)) return false;
+            PGRingBufferConsume(s->in, cc);
+            s->got += cc;
+        }
+    }
+
+    // The last write may have been read before it was reported.
+    while(s->engine && (PGRingBufferIOEngineInFlight(s->engine) > 0)) {
+        if(PGRingBufferIOEngineComplete(s->engine, 1) < 0) return false;
+    }
+
+    return (s->ok && (s->got == total) && (PGRingBufferCount(s->out) == 0));
+}
+
+static double runStream(PGMode mode, bool socket, long chunk, long total, uint8_t *tmp) {
+    PGStream s = { createEngine(mode), PGCreateRingBufferPow2(PG_MAX_CHUNK * 4), PGCreateRingBufferPow2(PG_MAX_CHUNK * 4), -1, -1, 0, 0, false, false, true };
+    int      fds[2];
+    double   secs = -1;
+
+    if(((mode == PG_DIRECT) || s.engine) && openTransport(socket, fds)) {
+        s.rfd = fds[0];
+        s.wfd = fds[1];
+        if(s.engine) {
+            PGRingBufferIOEngineRegister(s.engine, s.out);
+            PGRingBufferIOEngineRegister(s.engine, s.in);
+        }
+
+        double start = now();
+        bool   ok    = stream(&s, total, chunk, tmp);
+
+        secs = (now() - start);
+        if(!ok) {
+            fprintf(stderr, "%s %s chunk=%ld: bytes lost or corrupted\n", gModeNames[mode], (socket ? "socketpair" : "pipe"), chunk);
+            exit(1);
+        }
+        if(s.engine) {
+            PGRingBufferIOEngineUnregister(s.engine, s.out);
+            PGRingBufferIOEngineUnregister(s.engine, s.in);
+        }
+        closeTransport(fds);
+    }
+
+    PGDiscardRingBufferIOEngine(s.engine);
+    PGDiscardRingBuffer(s.out);
+    PGDiscardRingBuffer(s.in);
+    return secs;
+}
+
+// ---------------------------------------------------------------------------------------------------------------
+// --verify
+// ---------------------------------------------------------------------------------------------------------------
+
+static bool fail(PGMode mode, bool socket, const char *what) {
+    fprintf(stderr, "verify: FAILED (%s, %s): %s\n", gModeNames[mode], (socket ? "socketpair" : "pipe"), what);
+    return false;
+}
+
+static bool verifyStream(PGMode mode, bool socket, long rounds, uint8_t *tmp) {
+    const int flags[] = { PG_RINGBUFFER_DEFAULT, PG_RINGBUFFER_POW2, PG_RINGBUFFER_MIRRORED };
+
+    for(long r = 0; r < rounds; ++r) {
+        PGStream s = { createEngine(mode), PGCreateRingBufferWithFlags(rnd(64), flags[rnd(3)]), PGCreateRingBufferWithFlags(rnd(64), flags[rnd(3)]), -1, -1, 0, 0, false, false, true };
+        int      fds[2];
+        bool     ok;
+
+        if(!openTransport(socket, fds)) return fail(mode, socket, "transport");
+        s.rfd = fds[0];
+        s.wfd = fds[1];
+        if(s.engine && rnd(2)) {
+            PGRingBufferIOEngineRegister(s.engine, s.out);
+            PGRingBufferIOEngineRegister(s.engine, s.in);
+        }
+
+        ok = stream(&s, (1 + rnd(1024 * 1024)), 0, tmp);
+
+        if(s.engine) {
+            // Nothing can be left in flight once every byte has arrived.
+            if(PGRingBufferIOEngineInFlight(s.engine) != 0) ok = false;
+            PGRingBufferIOEngineUnregister(s.engine, s.out);
+            PGRingBufferIOEngineUnregister(s.engine, s.in);
+        }
+        PGDiscardRingBufferIOEngine(s.engine);
+        PGDiscardRingBuffer(s.out);
+        PGDiscardRingBuffer(s.in);
+        closeTransport(fds);
+        if(!ok) return fail(mode, socket, "stream");
+    }
+
+    return true;
+}
+
+/*
+ * A write is queued from a ring buffer and then a read much bigger than the free space is queued into the same
+ * ring buffer. If the read were allowed to resize the ring buffer then the write would go out from freed memory,
+ * which is scribbled on here before the write is started.
+ */
+static bool verifyReadDuringWrite(PGMode mode, bool socket) {
+    PGRingBufferIOEngine *engine = createEngine(mode);
+    PGRingBuffer         *buff   = PGCreateRingBuffer(64);
+    void                 *junk[16];
+    uint8_t              data[256];
+    int                  wfds[2];
+    int                  rfds[2];
+    long                 moved[2] = { 0, 0 };
+    bool                 ok       = true;
+
+    if(!openTransport(socket, wfds)) return fail(mode, socket, "transport");
+    if(!openTransport(socket, rfds)) return fail(mode, socket, "transport");
+
+    fillChunk(data, 0, 40);
+    PGAppendToRingBuffer(buff, data, 40);
+    fillChunk(data, 1000, sizeof(data));
+    if(write(rfds[1], data, sizeof(data)) != sizeof(data)) ok = fail(mode, socket, "source");
+
+    if(!PGRingBufferIOEngineSubmitWrite(engine, buff, wfds[1], 0, NULL, NULL)) ok = fail(mode, socket, "submit write");
+    if(!PGRingBufferIOEngineSubmitRead(engine, buff, rfds[0], (1 << 20), NULL, NULL)) ok = fail(mode, socket, "submit read");
+
+    // Anything the read freed would be handed straight back out here.
+    for(int i = 0; i < 16; ++i) memset((junk[i] = malloc(64)), 'J', 64);
+
+    while(ok && (PGRingBufferIOEngineInFlight(engine) > 0)) {
+        if(PGRingBufferIOEngineComplete(engine, 1) < 0) ok = fail(mode, socket, "complete");
+    }
+
+    for(long r; ok && (moved[0] < 40) && ((r = read(wfds[0], (data + moved[0]), (size_t)(40 - moved[0]))) > 0);) moved[0] += r;
+    if(ok && ((moved[0] != 40) || !checkChunk(data, 0, 40))) ok = fail(mode, socket, "write sent freed memory");
+
+    moved[1] = PGReadFromRingBuffer(buff, data, sizeof(data));
+    if(ok && ((moved[1] == 0) || !checkChunk(data, 1000, moved[1]))) ok = fail(mode, socket, "read");
+
+    for(int i = 0; i < 16; ++i) free(junk[i]);
+    closeTransport(wfds);
+    closeTransport(rfds);
+    PGDiscardRingBuffer(buff);
+    PGDiscardRingBufferIOEngine(engine);
+    return ok;
+}
+
+/*
+ * Reads into a full PG_RINGBUFFER_OVERWRITE ring buffer. A read that fails mustn't drop anything, a plain read
+ * only drops as many of the oldest bytes as it reads, and an engine only reads into the room that's free.
+ */
+static bool verifyOverwrite(PGMode mode, bool socket) {
+    PGRingBufferIOEngine *engine = ((mode == PG_DIRECT) ? NULL : createEngine(mode));
+    PGRingBuffer         *buff   = PGCreateRingBufferWithFlags(256, PG_RINGBUFFER_OVERWRITE);
+    long                 cap     = PGRingBufferCapacity(buff);
+    uint8_t              data[512];
+    int                  fds[2];
+    bool                 ok      = true;
+
+    if(!openTransport(socket, fds)) return fail(mode, socket, "transport");
+    fcntl(fds[0], F_SETFL, (fcntl(fds[0], F_GETFL) | O_NONBLOCK));
+
+    fillChunk(data, 0, cap);
+    PGAppendToRingBuffer(buff, data, cap);
+
+    if(engine == NULL) {
+        if((PGRingBufferReadFromFd(buff, fds[0], (1 << 20)) != -1) || (errno != EAGAIN)) ok = fail(mode, socket, "read with nothing to read");
+        if(ok && ((PGRingBufferCount(buff) != cap) || (PGRingBufferDroppedBytes(buff) != 0))) ok = fail(mode, socket, "failed read dropped bytes");
+    }
+    else if(PGRingBufferIOEngineSubmitRead(engine, buff, fds[0], (1 << 20), NULL, NULL)) {
+        ok = fail(mode, socket, "read queued with no room");
+    }
+    else {
+        PGRingBufferConsume(buff, 100);
+    }
+
+    fillChunk(data, cap, 100);
+    if(ok && (write(fds[1], data, 100) != 100)) ok = fail(mode, socket, "source");
+
+    if(ok && (engine == NULL)) {
+        if(PGRingBufferReadFromFd(buff, fds[0], (1 << 20)) != 100) ok = fail(mode, socket, "read");
+        else if(PGRingBufferDroppedBytes(buff) != 100) ok = fail(mode, socket, "dropped bytes");
+    }
+    else if(ok) {
+        if(!PGRingBufferIOEngineSubmitRead(engine, buff, fds[0], (1 << 20), NULL, NULL)) ok = fail(mode, socket, "submit read");
+        while(ok && (PGRingBufferIOEngineInFlight(engine) > 0)) {
+            if(PGRingBufferIOEngineComplete(engine, 1) < 0) ok = fail(mode, socket, "complete");
+        }
+    }
+
+    if(ok && ((PGPeekFromRingBuffer(buff, data, sizeof(data)) != cap) || !checkChunk(data, 100, cap))) ok = fail(mode, socket, "contents");
+
+    closeTransport(fds);
+    PGDiscardRingBuffer(buff);
+    PGDiscardRingBufferIOEngine(engine);
+    return ok;
+}
+
+static int verify(long rounds) {
+    uint8_t *tmp = malloc(PG_MAX_CHUNK);
+    bool    ok   = true;
+
+    // Rounding a negative size up to a power of two used to never finish.
+    if((PGCreateRingBufferIOEngine(-1, true) != NULL) || (errno != EINVAL)) {
+        fprintf(stderr, "verify: FAILED: created an engine with -1 entries\n");
+        ok = false;
+    }
+
+    for(PGMode mode = PG_DIRECT; mode <= PG_ASYNC; ++mode) {
+        PGRingBufferIOEngine *engine = createEngine(mode);
+
+        if((mode == PG_ASYNC) && (engine == NULL)) {
+            printf("verify %-8s io_uring is not available, skipped\n", gModeNames[mode]);
+            continue;
+        }
+        PGDiscardRingBufferIOEngine(engine);
+
+        for(int socket = 0; socket < 2; ++socket) {
+            bool r = (verifyStream(mode, socket, rounds, tmp) && ((mode == PG_DIRECT) || verifyReadDuringWrite(mode, socket)) && verifyOverwrite(mode, socket));
+
+            printf("verify %-8s %-10s rounds=%-6ld %s\n", gModeNames[mode], (socket ? "socketpair" : "pipe"), rounds, (r ? "ok" : "FAILED"));
+            ok = (ok && r);
+        }
+    }
+
+    free(tmp);
+    return (ok ? 0 : 1);
+}
+
+// ---------------------------------------------------------------------------------------------------------------
+
+/*
+ * Parses a whole number from 1 to `max`. Returns zero if `a` isn't one.
+ */
+static long positiveArg(const char *a, long max) {
+    char *end = NULL;
+    long v;
+
+    errno = 0;
+    v     = strtol(a, &end, 10);
+    return (((errno == 0) && (end != a) && (*end == 0) && (v > 0) && (v <= max)) ? v : 0);
+}
+
+int main(int argc, const char *argv[]) {
+    long mib    = 64;
+    long rounds = 0;
+    bool ok     = true;
+
+    for(int i = 1; ok && (i < argc); ++i) {
+        if(strcmp(argv[i], "--verify") == 0) rounds = 50;
+        else if(strncmp(argv[i], "--verify=", 9) == 0) ok = ((rounds = positiveArg((argv[i] + 9), LONG_MAX)) > 0);
+        else ok = ((mib = positiveArg(argv[i], (1L << 20))) > 0);
+    }
+
+    if(!ok) {
+        fprintf(stderr, "usage: %s [--verify[=rounds]] [MiB per run]\n", argv[0]);
+        return 2;
+    }
+    if(rounds > 0) return verify(rounds);
+
+    long total = (mib * 1024 * 1024);
+
+    const long chunks[] = { 512, 4096, 16384, PG_MAX_CHUNK };
+    uint8_t    *tmp     = malloc(PG_MAX_CHUNK);
+
+    for(int socket = 0; socket < 2; ++socket) {
+        for(size_t c = 0; c < (sizeof(chunks) / sizeof(chunks[0])); ++c) {
+            printf("%-10s chunk=%-7ld", (socket ? "socketpair" : "pipe"), chunks[c]);
+            for(PGMode mode = PG_DIRECT; mode <= PG_ASYNC; ++mode) {
+                double secs = runStream(mode, socket, chunks[c], total, tmp);
+
+                if(secs < 0) printf("   %s %10s     ", gModeNames[mode], "n/a");
+                else printf("   %s %10.2f MB/s", gModeNames[mode], ((double)total / secs / 1e6));
+            }
+            printf("\n");
+        }
+    }
+
+    free(tmp);
+    return 0;
+}
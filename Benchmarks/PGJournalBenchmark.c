@@ -0,0 +1,418 @@
+//
+//  PGJournalBenchmark.c
+//  PGRingBuffer
+//
+//  Created by Galen Rhodes on 10/16/26.
+//  Copyright © 2020 Project Galen. All rights reserved.
+//
+//  Measures how many records a second a PGRingBufferJournal takes for several record sizes when a commit is done
+//  after every record and when commits are grouped. The records are consumed as they go so the journal wraps.
+//
+//  `--verify` instead crashes the journal on purpose. Each round forks a child that opens the journal, does a random
+//  mix of appends, reads, consumes and commits, and then either closes it or just exits without committing, now and
+//  then after tearing one of the records it didn't commit. Another child then opens it again and checks that exactly
+//  the records that should have survived are there, in order, with the right bytes. The case that needs the
+//  generation numbers - a torn record followed by one that the next record appended after the crash ends right in
+//  front of - is checked on its own first, along with the file lock and a file that isn't a journal.
+//
+//  Build: cmake -S . -B build && cmake --build build --target PGJournalBenchmark
+//  Usage: PGJournalBenchmark [--verify[=rounds]] [records per run]
+//
+
+#include "PGRingBufferJournal.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/wait.h>
+#include <time.h>
+
+#define PG_MAX_RECORD (4096)
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((double)ts.tv_sec + ((double)ts.tv_nsec / 1e9));
+}
+
+static unsigned long gSeed = 88172645463325252UL;
+
+static long rnd(long n) {
+    gSeed ^= (gSeed << 13);
+    gSeed ^= (gSeed >> 7);
+    gSeed ^= (gSeed << 17);
+    return (long)(gSeed % (unsigned long)n);
+}
+
+static void journalPath(char *path, size_t size) {
+    const char *dir = getenv("TMPDIR");
+    snprintf(path, size, "%s/PGJournalBenchmark.%ld", ((dir && *dir) ? dir : "/tmp"), (long)getpid());
+}
+
+// ---------------------------------------------------------------------------------------------------------------
+
+static double runJournal(const char *path, long recordSize, long group, long records) {
+    uint8_t record[PG_MAX_RECORD];
+    uint8_t dest[PG_MAX_RECORD];
+
+    unlink(path);
+    memset(record, 'R', sizeof(record));
+
+    PGRingBufferJournal *buff = PGOpenRingBufferJournal(path, (1 << 24));
+    if(buff == NULL) {
+        perror("PGOpenRingBufferJournal");
+        exit(1);
+    }
+
+    double start = now();
+
+    for(long i = 0; i < records; ++i) {
+        if(!PGAppendToRingBufferJournal(buff, record, recordSize)) {
+            fprintf(stderr, "PGAppendToRingBufferJournal: journal full\n");
+            exit(1);
+        }
+        // The consumption is made durable by the next commit, which frees the room for the group after.
+        if(((i + 1) % group) == 0) {
+            PGCommitRingBufferJournal(buff);
+            while(PGReadRecordFromRingBufferJournal(buff, dest, sizeof(dest)) >= 0) {}
+        }
+    }
+
+    PGCloseRingBufferJournal(buff);
+    double t = (now() - start);
+    unlink(path);
+    return t;
+}
+
+// ---------------------------------------------------------------------------------------------------------------
+// --verify
+
+#define PG_VERIFY_CAPACITY (8192)
+
+/*
+ * Record `seq` is always the same length and the same bytes, and starts with its own number, so whoever opens the
+ * journal can tell exactly which records it got. Most are short and only a few lengths are used so that records
+ * written after a crash keep ending exactly where older ones begin.
+ */
+static long recordLength(long seq) {
+    unsigned long h = ((unsigned long)seq * 0x9e3779b97f4a7c15UL);
+
+    h ^= (h >> 29);
+    return (((h % 16) == 0) ? (8 + (long)((h >> 8) % 1000)) : (8 + (4 * (long)((h >> 8) % 6))));
+}
+
+static void makeRecord(long seq, uint8_t *record) {
+    int64_t s = seq;
+
+    memcpy(record, &s, sizeof(s));
+    for(long i = 8; i < recordLength(seq); ++i) record[i] = (uint8_t)((seq * 31) + i);
+}
+
+static bool isRecord(long seq, const uint8_t *record, long length) {
+    uint8_t expect[PG_MAX_RECORD];
+
+    if(length != recordLength(seq)) return false;
+    makeRecord(seq, expect);
+    return (memcmp(record, expect, (size_t)length) == 0);
+}
+
+static long framed(long seq) {
+    return (PG_RINGBUFFER_JOURNAL_FRAMING + ((recordLength(seq) + 7) & ~7L));
+}
+
+static bool fail(long round, const char *what) {
+    fprintf(stderr, "verify: FAILED in round %ld: %s\n", round, what);
+    return false;
+}
+
+/*
+ * Runs `fn` in a child process and returns its exit status. The child never commits or closes anything on the way
+ * out so, as far as the journal is concerned, it crashed. Its writes to the mapping are all in the page cache
+ * though, the same as after a process crash.
+ */
+static int inChild(int (*fn)(const char *, long, long, long), const char *path, long a, long b, long c) {
+    int   status = -1;
+    pid_t pid    = fork();
+
+    if(pid == 0) {
+        fflush(stdout);
+        _exit(fn(path, a, b, c));
+    }
+    if((pid < 0) || (waitpid(pid, &status, 0) != pid) || !WIFEXITED(status)) return -1;
+    return WEXITSTATUS(status);
+}
+
+/*
+ * Checks that the journal holds exactly the records `first` up to, but not including, `next`. Run in a child so
+ * that reading them doesn't consume them.
+ */
+static int checkRecords(const char *path, long first, long next, long unused) {
+    PGRingBufferJournal *buff = PGOpenRingBufferJournal(path, PG_VERIFY_CAPACITY);
+    uint8_t             dest[PG_MAX_RECORD];
+
+    (void)unused;
+    if(buff == NULL) return 10;
+
+    for(long seq = first; seq < next; ++seq) {
+        long l = PGReadRecordFromRingBufferJournal(buff, dest, sizeof(dest));
+        if((l < 0) || !isRecord(seq, dest, l)) return 11;
+    }
+    if(PGReadRecordFromRingBufferJournal(buff, dest, sizeof(dest)) >= 0) return 12;
+    if(PGRingBufferJournalCount(buff) != 0) return 13;
+    return 0;
+}
+
+/*
+ * Opens the journal, which holds the records `first` to `next - 1`, and does up to 200 random operations on it.
+ * Then it closes the journal, or just exits, now and then after tearing one of the records it didn't commit. What
+ * should survive is written to `report` as two longs: the first and the next sequence numbers.
+ */
+static int workRecords(const char *path, long first, long next, long report) {
+    PGRingBufferJournal *buff = PGOpenRingBufferJournal(path, PG_VERIFY_CAPACITY);
+    uint8_t             record[PG_MAX_RECORD];
+    long                head      = first;  // The next record to be read.
+    long                synced    = first;  // The head as of the last commit.
+    long                committed = next;   // The tail as of the last commit.
+    long                out[2];
+    long                ops       = (1 + rnd(200));
+
+    if(buff == NULL) return 20;
+
+    // Only one process at a time.
+    if((PGOpenRingBufferJournal(path, PG_VERIFY_CAPACITY) != NULL) || (errno != EWOULDBLOCK)) return 21;
+
+    for(long i = 0; i < ops; ++i) {
+        switch(rnd(6)) {
+            case 0:
+            case 1:
+            case 2: {
+                bool room = (framed(next) <= PGRingBufferJournalRemaining(buff));
+
+                makeRecord(next, record);
+                if(PGAppendToRingBufferJournal(buff, record, recordLength(next)) != room) return 22;
+                if(room) ++next;
+                break;
+            }
+            case 3: {
+                long l = PGReadRecordFromRingBufferJournal(buff, record, sizeof(record));
+
+                if((l >= 0) != (head < next)) return 23;
+                if((l >= 0) && !isRecord(head++, record, l)) return 24;
+                break;
+            }
+            case 4: {
+                long n = rnd(4);
+                long c = PGRingBufferJournalConsume(buff, n);
+
+                if(c != (((next - head) < n) ? (next - head) : n)) return 25;
+                head += c;
+                break;
+            }
+            default:
+                if(!PGCommitRingBufferJournal(buff)) return 26;
+                synced    = head;
+                committed = next;
+                break;
+        }
+    }
+
+    switch(rnd(4)) {
+        case 0:
+            if(!PGCloseRingBufferJournal(buff)) return 27;
+            out[0] = head;
+            out[1] = next;
+            break;
+        case 1:
+            // Tear one of the records appended since the last commit, and not read yet, by flipping a byte its
+            // checksum covers. It and everything after it are lost.
+            if(((head > committed) ? head : committed) < next) {
+                PGRingBufferSpan span;
+                long             from = ((head > committed) ? head : committed);
+                long             torn = (from + rnd(next - from));
+                long             at   = 0;
+
+                if(PGPeekRecordFromRingBufferJournal(buff, &span) < 0) return 28;
+                for(long seq = head; seq < torn; ++seq) at += framed(seq);
+                (span.bytes - PG_RINGBUFFER_JOURNAL_FRAMING + at)[rnd(PG_RINGBUFFER_JOURNAL_FRAMING + recordLength(torn))] ^= (uint8_t)(1 + rnd(255));
+                next = torn;
+            }
+            // Fall through.
+        default:
+            out[0] = synced;
+            out[1] = next;
+            break;
+    }
+
+    return ((write((int)report, out, sizeof(out)) == sizeof(out)) ? 0 : 29);
+}
+
+/*
+ * Appends two records and then tears the first without committing, so the crash leaves a good record behind a
+ * torn one.
+ */
+static int tornPair(const char *path, long length1, long length2, long unused) {
+    PGRingBufferJournal *buff = PGOpenRingBufferJournal(path, PG_VERIFY_CAPACITY);
+    PGRingBufferSpan    span;
+    uint8_t             record[PG_MAX_RECORD];
+
+    (void)unused;
+    if(buff == NULL) return 30;
+    memset(record, 'A', (size_t)length1);
+    if(!PGAppendToRingBufferJournal(buff, record, length1)) return 31;
+    memset(record, 'B', (size_t)length2);
+    if(!PGAppendToRingBufferJournal(buff, record, length2)) return 32;
+    if(PGPeekRecordFromRingBufferJournal(buff, &span) != length1) return 33;
+    span.bytes[0] ^= 0xff;
+    return 0;
+}
+
+/*
+ * Checks that the journal is empty and then appends one record without committing.
+ */
+static int appendOne(const char *path, long length, long unused1, long unused2) {
+    PGRingBufferJournal *buff = PGOpenRingBufferJournal(path, PG_VERIFY_CAPACITY);
+    uint8_t             record[PG_MAX_RECORD];
+
+    (void)unused1;
+    (void)unused2;
+    if(buff == NULL) return 40;
+    if(PGRingBufferJournalCount(buff) != 0) return 41;
+    memset(record, 'C', (size_t)length);
+    return (PGAppendToRingBufferJournal(buff, record, length) ? 0 : 42);
+}
+
+/*
+ * The record appended after the torn one ends exactly where the good record behind the torn one begins. Its
+ * position and checksum are both still right so only its generation gives it away.
+ */
+static bool verifyStaleRecord(const char *path) {
+    uint8_t dest[PG_MAX_RECORD];
+    bool    ok = true;
+
+    unlink(path);
+    if(inChild(tornPair, path, 100, 20, 0) != 0) return fail(0, "torn pair");
+    if(inChild(appendOne, path, 100, 0, 0) != 0) return fail(0, "append after the torn record");
+
+    PGRingBufferJournal *buff = PGOpenRingBufferJournal(path, PG_VERIFY_CAPACITY);
+
+    if(buff == NULL) return fail(0, "reopen");
+    if((PGReadRecordFromRingBufferJournal(buff, dest, sizeof(dest)) != 100) || (dest[0] != 'C')) ok = fail(0, "the record after the torn one");
+    if(ok && (PGReadRecordFromRingBufferJournal(buff, dest, sizeof(dest)) >= 0)) ok = fail(0, "stale record recovered");
+    PGCloseRingBufferJournal(buff);
+    return ok;
+}
+
+static bool verifyOpenErrors(const char *path) {
+    bool ok = true;
+    int  fd;
+
+    unlink(path);
+    PGRingBufferJournal *buff = PGOpenRingBufferJournal(path, PG_VERIFY_CAPACITY);
+
+    if(buff == NULL) return fail(0, "create");
+    if((PGOpenRingBufferJournal(path, PG_VERIFY_CAPACITY) != NULL) || (errno != EWOULDBLOCK)) ok = fail(0, "opened twice");
+    PGCloseRingBufferJournal(buff);
+
+    // Not a journal at all.
+    if(ok && ((fd = open(path, (O_WRONLY | O_TRUNC))) >= 0)) {
+        ok = (write(fd, "not a journal, just some text that's long enough", 48) == 48);
+        close(fd);
+        if(ok && ((PGOpenRingBufferJournal(path, PG_VERIFY_CAPACITY) != NULL) || (errno != EPROTO))) ok = fail(0, "opened a file that isn't a journal");
+    }
+
+    unlink(path);
+    return ok;
+}
+
+static int verify(long rounds) {
+    char path[256];
+    long first = 0;
+    long next  = 0;
+    bool ok;
+
+    journalPath(path, sizeof(path));
+    ok = (verifyStaleRecord(path) && verifyOpenErrors(path));
+
+    for(long round = 1; ok && (round <= rounds); ++round) {
+        int  fds[2];
+        long got[2];
+        int  r;
+
+        if(pipe(fds) != 0) return 1;
+
+        // The child gets its own stream of random numbers rather than the same one as the last child.
+        gSeed = (unsigned long)(1 + rnd(LONG_MAX));
+
+        r = inChild(workRecords, path, first, next, fds[1]);
+        if(r != 0) {
+            fprintf(stderr, "verify: child exited with %d\n", r);
+            ok = fail(round, "work");
+        }
+        else if(read(fds[0], got, sizeof(got)) != sizeof(got)) {
+            ok = fail(round, "report");
+        }
+        else {
+            first = got[0];
+            next  = got[1];
+            if((r = inChild(checkRecords, path, first, next, 0)) != 0) {
+                fprintf(stderr, "verify: child exited with %d\n", r);
+                ok = fail(round, "recovered records");
+            }
+        }
+
+        close(fds[0]);
+        close(fds[1]);
+    }
+
+    unlink(path);
+    printf("verify journal rounds=%-6ld records=%-8ld %s\n", rounds, next, (ok ? "ok" : "FAILED"));
+    return (ok ? 0 : 1);
+}
+
+// ---------------------------------------------------------------------------------------------------------------
+
+/*
+ * Parses a whole number from 1 to `max`. Returns zero if `a` isn't one.
+ */
+static long positiveArg(const char *a, long max) {
+    char *end = NULL;
+    long v;
+
+    errno = 0;
+    v     = strtol(a, &end, 10);
+    return (((errno == 0) && (end != a) && (*end == 0) && (v > 0) && (v <= max)) ? v : 0);
+}
+
+int main(int argc, const char *argv[]) {
+    long records = 10000;
+    long rounds  = 0;
+    bool ok      = true;
+    char path[256];
+
+    // The byte count for the biggest records mustn't overflow.
+    for(int i = 1; ok && (i < argc); ++i) {
+        if(strcmp(argv[i], "--verify") == 0) rounds = 2000;
+        else if(strncmp(argv[i], "--verify=", 9) == 0) ok = ((rounds = positiveArg((argv[i] + 9), LONG_MAX)) > 0);
+        else ok = ((records = positiveArg(argv[i], (1L << 40))) > 0);
+    }
+
+    if(!ok) {
+        fprintf(stderr, "usage: %s [--verify[=rounds]] [records per run]\n", argv[0]);
+        return 2;
+    }
+    if(rounds > 0) return verify(rounds);
+
+    long sizes[]  = { 16, 256, PG_MAX_RECORD };
+    long groups[] = { 1, 16, 256 };
+
+    journalPath(path, sizeof(path));
+
+    for(size_t i = 0; i < (sizeof(sizes) / sizeof(sizes[0])); ++i) {
+        for(size_t j = 0; j < (sizeof(groups) / sizeof(groups[0])); ++j) {
+            double t = runJournal(path, sizes[i], groups[j], records);
+
+            printf("record=%-6ld commit every %-4ld %12.0f records/s %10.2f MB/s\n", sizes[i], groups[j], ((double)records / t), ((double)(records * sizes[i]) / t / 1e6));
+        }
+    }
+
+    return 0;
+}
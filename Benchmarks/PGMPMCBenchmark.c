@@ -0,0 +1,168 @@
+//
+//  PGMPMCBenchmark.c
+//  PGRingBuffer
+//
+//  Created by Galen Rhodes on 10/16/26.
+//  Copyright © 2020 Project Galen. All rights reserved.
+//
+//  Measures record throughput under contention for 1 to N producer threads and the same number of consumer
+//  threads. The lock-free PGMPMCRingBuffer is compared against a PGRingBuffer guarded by a mutex with a length
+//  prefix in front of each record, which is what callers had to do before.
+//
+//  Build: cmake -S . -B build && cmake --build build --target PGMPMCBenchmark
+//  Usage: PGMPMCBenchmark [max threads] [records per producer]
+//
+
+#include "PGMPMCRingBuffer.h"
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <time.h>
+
+#define PG_MAX_RECORD (256)
+
+typedef struct {
+    bool (*push)(void *q, const void *src, long length);
+    bool (*pop)(void *q, void *dest, long maxLength, long *length);
+    void *q;
+    long records;
+    _Atomic long *remaining;
+    _Atomic long *bytes;
+} PGBenchArgs;
+
+typedef struct {
+    pthread_mutex_t lock;
+    PGRingBuffer    *buff;
+    long            limit;
+} PGLockedQueue;
+
+static bool lockedPush(void *q, const void *src, long length) {
+    PGLockedQueue *lq = q;
+    bool          ok  = false;
+
+    pthread_mutex_lock(&lq->lock);
+    if(PGRingBufferCount(lq->buff) + length + (long)sizeof(long) <= lq->limit) {
+        ok = (PGAppendToRingBuffer(lq->buff, &length, sizeof(long)) && PGAppendToRingBuffer(lq->buff, src, length));
+    }
+    pthread_mutex_unlock(&lq->lock);
+    return ok;
+}
+
+static bool lockedPop(void *q, void *dest, long maxLength, long *length) {
+    PGLockedQueue *lq = q;
+    bool          ok  = false;
+
+    pthread_mutex_lock(&lq->lock);
+    if(PGPeekFromRingBuffer(lq->buff, length, sizeof(long)) == sizeof(long) && *length <= maxLength) {
+        PGRingBufferConsume(lq->buff, sizeof(long));
+        ok = (PGReadFromRingBuffer(lq->buff, dest, *length) == *length);
+    }
+    pthread_mutex_unlock(&lq->lock);
+    return ok;
+}
+
+static bool mpmcPush(void *q, const void *src, long length) {
+    return PGAppendRecordToMPMCRingBuffer(q, src, length);
+}
+
+static bool mpmcPop(void *q, void *dest, long maxLength, long *length) {
+    return PGReadRecordFromMPMCRingBuffer(q, dest, maxLength, length);
+}
+
+static void *producer(void *p) {
+    PGBenchArgs *args = p;
+    uint8_t     rec[PG_MAX_RECORD];
+
+    memset(rec, 0x5a, sizeof(rec));
+    for(long i = 0; i < args->records; ++i) {
+        long length = (16 + ((i * 37) % (PG_MAX_RECORD - 16)));
+        while(!args->push(args->q, rec, length)) sched_yield();
+    }
+    return NULL;
+}
+
+static void *consumer(void *p) {
+    PGBenchArgs *args = p;
+    uint8_t     rec[PG_MAX_RECORD];
+    long        bytes = 0;
+    long        length;
+
+    while(atomic_load(args->remaining) > 0) {
+        if(args->pop(args->q, rec, sizeof(rec), &length)) {
+            atomic_fetch_sub(args->remaining, 1);
+            bytes += length;
+        }
+        else {
+            sched_yield();
+        }
+    }
+    atomic_fetch_add(args->bytes, bytes);
+    return NULL;
+}
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((double)ts.tv_sec + ((double)ts.tv_nsec / 1e9));
+}
+
+static void run(const char *name, PGBenchArgs *proto, int threads) {
+    pthread_t     tids[threads * 2];
+    PGBenchArgs   args      = *proto;
+    _Atomic long  remaining = (proto->records * threads);
+    _Atomic long  bytes     = 0;
+
+    args.remaining = &remaining;
+    args.bytes     = &bytes;
+
+    double start = now();
+    for(int i = 0; i < threads; ++i) {
+        pthread_create(&tids[i], NULL, producer, &args);
+        pthread_create(&tids[threads + i], NULL, consumer, &args);
+    }
+    for(int i = 0; i < (threads * 2); ++i) pthread_join(tids[i], NULL);
+    double secs = (now() - start);
+
+    printf("%-8s threads=%-3d records=%-10ld %10.3f Mrec/s %10.2f MB/s\n", name, threads, (proto->records * threads), (((double)proto->records * threads) / secs / 1e6), ((double)atomic_load(&bytes) / secs / 1e6));
+}
+
+/*
+ * Parses a whole number from 1 to `max`. Returns zero if `a` isn't one.
+ */
+static long positiveArg(const char *a, long max) {
+    char *end = NULL;
+    long v;
+
+    errno = 0;
+    v     = strtol(a, &end, 10);
+    return (((errno == 0) && (end != a) && (*end == 0) && (v > 0) && (v <= max)) ? v : 0);
+}
+
+int main(int argc, const char *argv[]) {
+    // The thread ids are on the stack and the total number of records mustn't overflow.
+    int  maxThreads = (int)((argc > 1) ? positiveArg(argv[1], 1024) : sysconf(_SC_NPROCESSORS_ONLN));
+    long records    = ((argc > 2) ? positiveArg(argv[2], (1L << 40)) : 1000000);
+
+    if((argc > 3) || (maxThreads == 0) || (records == 0)) {
+        fprintf(stderr, "usage: %s [max threads] [records per producer]\n", argv[0]);
+        return 2;
+    }
+    if(maxThreads < 1) maxThreads = 1;
+
+    for(int threads = 1; threads <= maxThreads; ++threads) {
+        PGMPMCRingBuffer *mq   = PGCreateMPMCRingBuffer((1 << 20), 64);
+        PGBenchArgs      margs = { mpmcPush, mpmcPop, mq, records, NULL, NULL };
+
+        run("mpmc", &margs, threads);
+        PGDiscardMPMCRingBuffer(mq);
+
+        PGLockedQueue lq    = { PTHREAD_MUTEX_INITIALIZER, PGCreateRingBuffer(1 << 20), (1 << 20) };
+        PGBenchArgs   largs = { lockedPush, lockedPop, &lq, records, NULL, NULL };
+
+        run("mutex", &largs, threads);
+        PGDiscardRingBuffer(lq.buff);
+    }
+
+    return 0;
+}
@@ -0,0 +1,1275 @@
+//
+//  PGRingBufferBenchmark.c
+//  PGRingBuffer
+//
+//  Created by Galen Rhodes on 10/16/26.
+//  Copyright © 2020 Project Galen. All rights reserved.
+//
+//  Benchmarks the basic PGRingBuffer operations across buffer sizes, chunk sizes, and with the bytes being worked
+//  on either unwrapped or straddling the end of the storage. Each case is repeated until it has run for at least
+//  the minimum time and is reported in MB/s and ns/op. The head and tail are put back before every operation so
+//  that every operation sees exactly the same state.
+//
+//  `churn` and `poolchurn` create a ring buffer, append a chunk, read it back, and discard it, with `malloc` and
+//  with a PGRingBufferPool. In text format each `poolchurn` case is followed by the pool's hits and misses.
+//
+//  `--verify` instead runs a long random sequence of operations against both a ring buffer and a simple
+//  reference deque and checks that they always agree. Each set of flags is run with the default policy and with
+//  random growth, shrink and maximum capacity policies, and then again with random policies and the ring buffers
+//  coming from a small pool. A PGChunkedRingBuffer is checked against the same reference. Run it after any
+//  optimization.
+//
+//  Build: cmake -S . -B build && cmake --build build --target PGRingBufferBenchmark
+//  Usage: PGRingBufferBenchmark [--format=text|csv|json] [--min-time=ms] [--filter=name] [--pow2] [--mirrored]
+//                               [--quick] [--verify[=iterations]]
+//
+
+#include "PGRingBuffer.h"
+#include "PGRingBufferRecords.h"
+#include "PGChunkedRingBuffer.h"
+#include "PGRingBufferPool.h"
+#include <limits.h>
+#include <time.h>
+
+typedef enum { PG_TEXT, PG_CSV, PG_JSON } PGFormat;
+
+typedef struct {
+    PGRingBuffer *buff;
+    uint8_t      *chunk;
+    long         size;
+    long         chunkSize;
+    bool         wrapped;
+    long         head;
+    long         count;
+} PGBenchCase;
+
+/*
+ * Runs one operation and returns the number of bytes it processed.
+ */
+typedef long (*PGBenchOp)(PGBenchCase *bc);
+
+typedef void (*PGBenchSetup)(PGBenchCase *bc);
+
+typedef struct {
+    const char   *name;
+    PGBenchSetup setup;
+    PGBenchOp    op;
+    bool         perByte;
+} PGBench;
+
+static PGFormat gFormat  = PG_TEXT;
+static double   gMinTime = 0.05;
+static int      gFlags   = PG_RINGBUFFER_DEFAULT;
+static int      gResults = 0;
+
+static PGRingBufferPool *gPool = NULL;
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((double)ts.tv_sec + ((double)ts.tv_nsec / 1e9));
+}
+
+/*
+ * Puts the head and tail back where the case wants them. The contents don't matter.
+ */
+static inline void place(PGBenchCase *bc) {
+    PGRingBuffer *b = bc->buff;
+    b->head = (bc->head % b->size);
+    b->tail = ((bc->head + bc->count) % b->size);
+}
+
+// Setups. Each one picks a head and a count so that the bytes the operation touches are either all in the middle
+// of the storage or split evenly across the end of it.
+
+static void setupAppend(PGBenchCase *bc) {
+    long s  = bc->buff->size;
+    long t  = (bc->wrapped ? (s - (bc->chunkSize / 2)) : (s / 4));
+    bc->count = bc->chunkSize;
+    bc->head  = (t - bc->count);
+}
+
+static void setupRead(PGBenchCase *bc) {
+    long s  = bc->buff->size;
+    bc->head  = (bc->wrapped ? (s - (bc->chunkSize / 2)) : (s / 4));
+    bc->count = (bc->chunkSize * 2);
+}
+
+static void setupPrepend(PGBenchCase *bc) {
+    long s  = bc->buff->size;
+    bc->head  = (bc->wrapped ? (bc->chunkSize / 2) : (s / 2));
+    bc->count = bc->chunkSize;
+}
+
+static void setupWhole(PGBenchCase *bc) {
+    long s  = bc->buff->size;
+    bc->head  = (bc->wrapped ? (s - (bc->chunkSize / 2)) : (s / 4));
+    bc->count = bc->chunkSize;
+}
+
+static void setupRecords(PGBenchCase *bc) {
+    setupAppend(bc);
+    bc->count = 0;
+}
+
+/*
+ * A full overwriting buffer, so every append has to drop as many bytes as it adds.
+ */
+static void setupOverwrite(PGBenchCase *bc) {
+    long s  = bc->buff->size;
+    bc->buff->flags |= PG_RINGBUFFER_OVERWRITE;
+    bc->head  = (bc->wrapped ? (bc->chunkSize / 2) : (s / 4));
+    bc->count = (s - 1);
+}
+
+/*
+ * The searches look for bytes that aren't there so that they always scan the whole count.
+ */
+static void setupSearch(PGBenchCase *bc) {
+    setupWhole(bc);
+    memset(bc->buff->buffer, 'a', (size_t)bc->buff->size);
+}
+
+// Operations.
+
+static long opAppend(PGBenchCase *bc) {
+    place(bc);
+    PGAppendToRingBuffer(bc->buff, bc->chunk, bc->chunkSize);
+    return bc->chunkSize;
+}
+
+static long opRead(PGBenchCase *bc) {
+    place(bc);
+    return PGReadFromRingBuffer(bc->buff, bc->chunk, bc->chunkSize);
+}
+
+static long opReadLast(PGBenchCase *bc) {
+    place(bc);
+    return PGReadLastFromRingBuffer(bc->buff, bc->chunk, bc->chunkSize);
+}
+
+static long opPrepend(PGBenchCase *bc) {
+    place(bc);
+    PGPrependToRingBuffer(bc->buff, bc->chunk, bc->chunkSize);
+    return bc->chunkSize;
+}
+
+static long opPeek(PGBenchCase *bc) {
+    place(bc);
+    return PGPeekFromRingBuffer(bc->buff, bc->chunk, bc->chunkSize);
+}
+
+static long opConsume(PGBenchCase *bc) {
+    place(bc);
+    PGRingBufferConsume(bc->buff, bc->chunkSize);
+    return bc->chunkSize;
+}
+
+static long opGetByte(PGBenchCase *bc) {
+    uint8_t x = 0;
+    place(bc);
+    for(long i = 0; i < bc->chunkSize; ++i) x ^= PGGetByteFromRingBuffer(bc->buff, i);
+    bc->chunk[0] = x;
+    return bc->chunkSize;
+}
+
+static long opSetByte(PGBenchCase *bc) {
+    place(bc);
+    for(long i = 0; i < bc->chunkSize; ++i) PGSetByteOnRingBuffer(bc->buff, i, (uint8_t)i);
+    return bc->chunkSize;
+}
+
+static long opAppendByte(PGBenchCase *bc) {
+    place(bc);
+    for(long i = 0; i < bc->chunkSize; ++i) PGAppendByteToRingBuffer(bc->buff, (uint8_t)i);
+    return bc->chunkSize;
+}
+
+static long opPrependByte(PGBenchCase *bc) {
+    place(bc);
+    for(long i = 0; i < bc->chunkSize; ++i) PGPrependByteToRingBuffer(bc->buff, (uint8_t)i);
+    return bc->chunkSize;
+}
+
+/*
+ * Appends and then reads back the chunk four bytes at a time.
+ */
+static long opWord32(PGBenchCase *bc) {
+    uint32_t x = 0;
+    uint32_t w;
+
+    place(bc);
+    for(long i = 0; i < bc->chunkSize; i += 4) PGAppendWord32ToRingBuffer(bc->buff, (uint32_t)i);
+    for(long i = 0; i < bc->chunkSize; i += 4) if(PGReadWord32FromRingBuffer(bc->buff, &w)) x ^= w;
+    bc->chunk[0] = (uint8_t)x;
+    return bc->chunkSize;
+}
+
+static long opSwap16(PGBenchCase *bc) {
+    place(bc);
+    return (PGSwapRingBufferEndian16(bc->buff) * 2);
+}
+
+static long opSwap32(PGBenchCase *bc) {
+    place(bc);
+    return (PGSwapRingBufferEndian32(bc->buff) * 4);
+}
+
+static long opSwap64(PGBenchCase *bc) {
+    place(bc);
+    return (PGSwapRingBufferEndian64(bc->buff) * 8);
+}
+
+/*
+ * Decoding big endian 32-bit words the old way, with a read and then a swap, and with the fused read.
+ */
+static long opReadSwap32(PGBenchCase *bc) {
+    place(bc);
+    long n = PGReadFromRingBuffer(bc->buff, bc->chunk, bc->chunkSize);
+    PGSwap32(bc->chunk, n);
+    return n;
+}
+
+static long opReadWords32(PGBenchCase *bc) {
+    place(bc);
+    return (PGReadWords32FromRingBuffer(bc->buff, (uint32_t *)bc->chunk, (bc->chunkSize / 4), PGBigEndianByteOrder()) * 4);
+}
+
+static long opFindByte(PGBenchCase *bc) {
+    place(bc);
+    bc->chunk[0] = (uint8_t)PGFindByteInRingBuffer(bc->buff, 0, '\n');
+    return bc->count;
+}
+
+static long opFindAny(PGBenchCase *bc) {
+    place(bc);
+    bc->chunk[0] = (uint8_t)PGFindAnyByteInRingBuffer(bc->buff, 0, (const uint8_t *)"\r\n\t", 3);
+    return bc->count;
+}
+
+static long opFind(PGBenchCase *bc) {
+    place(bc);
+    bc->chunk[0] = (uint8_t)PGFindInRingBuffer(bc->buff, 0, "\r\n\r\n", 4);
+    return bc->count;
+}
+
+#define PG_BENCH_RECORD      (16)
+#define PG_BENCH_MAX_RECORDS (65536 / PG_BENCH_RECORD)
+
+/*
+ * Pushes the chunk as a batch of 16 byte records and then pops them all back out.
+ */
+static long opRecords(PGBenchCase *bc) {
+    static PGRingBufferSpan recs[PG_BENCH_MAX_RECORDS];
+    long                    n = (bc->chunkSize / PG_BENCH_RECORD);
+
+    for(long i = 0; i < n; ++i) {
+        recs[i].bytes  = (bc->chunk + (i * PG_BENCH_RECORD));
+        recs[i].length = PG_BENCH_RECORD;
+    }
+
+    place(bc);
+    PGAppendRecordsToRingBuffer(bc->buff, PG_RECORD_VARINT, recs, n);
+    for(long m = 0, r = 1; (m < n) && (r > 0); m += r) r = PGPopRecordsFromRingBuffer(bc->buff, PG_RECORD_VARINT, recs, PG_BENCH_MAX_RECORDS);
+    return (n * PG_BENCH_RECORD);
+}
+
+static long opDefrag(PGBenchCase *bc) {
+    place(bc);
+    PGDefragRingBuffer(bc->buff);
+    return bc->count;
+}
+
+static long opContiguous(PGBenchCase *bc) {
+    place(bc);
+    PGMakeRingBufferContiguous(bc->buff, bc->count);
+    return bc->count;
+}
+
+/*
+ * Grows a fresh buffer from the case's size to sixteen times that, one chunk at a time.
+ */
+static long opGrow(PGBenchCase *bc) {
+    PGRingBuffer *b     = PGCreateRingBufferWithFlags(bc->size, gFlags);
+    long         target = (bc->size * 16);
+    long         total  = 0;
+
+    while(total < target) {
+        PGAppendToRingBuffer(b, bc->chunk, bc->chunkSize);
+        total += bc->chunkSize;
+    }
+
+    PGDiscardRingBuffer(b);
+    return total;
+}
+
+/*
+ * Same as grow but with a chunked ring buffer whose chunks are the case's size.
+ */
+static long opChunkedGrow(PGBenchCase *bc) {
+    PGChunkedRingBuffer *b     = PGCreateChunkedRingBuffer(bc->size, 0);
+    long                target = (bc->size * 16);
+    long                total  = 0;
+
+    while(total < target) {
+        PGAppendToChunkedRingBuffer(b, bc->chunk, bc->chunkSize);
+        total += bc->chunkSize;
+    }
+
+    PGDiscardChunkedRingBuffer(b);
+    return total;
+}
+
+/*
+ * A short lived ring buffer: created, used once, and discarded. `opPoolChurn` gets its memory from `gPool`.
+ */
+static long churn(PGBenchCase *bc, const PGRingBufferAllocator *allocator) {
+    PGRingBuffer *b = PGCreateRingBufferWithAllocator(bc->size, gFlags, allocator);
+
+    PGAppendToRingBuffer(b, bc->chunk, bc->chunkSize);
+    PGReadFromRingBuffer(b, bc->chunk, bc->chunkSize);
+    PGDiscardRingBuffer(b);
+    return bc->chunkSize;
+}
+
+static long opChurn(PGBenchCase *bc) {
+    return churn(bc, NULL);
+}
+
+static long opPoolChurn(PGBenchCase *bc) {
+    return churn(bc, PGRingBufferPoolAllocator(gPool));
+}
+
+static const PGBench gBenches[] = {
+    { "append",      setupAppend,  opAppend,     false },
+    { "read",        setupRead,    opRead,       false },
+    { "readlast",    setupRead,    opReadLast,   false },
+    { "overwrite",   setupOverwrite, opAppend,   false },
+    { "prepend",     setupPrepend, opPrepend,    false },
+    { "peek",        setupRead,    opPeek,       false },
+    { "consume",     setupRead,    opConsume,    false },
+    { "getbyte",     setupRead,    opGetByte,    true },
+    { "setbyte",     setupRead,    opSetByte,    true },
+    { "appendbyte",  setupAppend,  opAppendByte, true },
+    { "prependbyte", setupPrepend, opPrependByte, true },
+    { "word32",      setupRecords, opWord32,     true },
+    { "swap16",      setupWhole,   opSwap16,     false },
+    { "swap32",      setupWhole,   opSwap32,     false },
+    { "swap64",      setupWhole,   opSwap64,     false },
+    { "readswap32",  setupRead,    opReadSwap32, false },
+    { "readwords32", setupRead,    opReadWords32, false },
+    { "findbyte",    setupSearch,  opFindByte,   false },
+    { "findany",     setupSearch,  opFindAny,    false },
+    { "find",        setupSearch,  opFind,       false },
+    { "records",     setupRecords, opRecords,    false },
+    { "defrag",      setupWhole,   opDefrag,     false },
+    { "contiguous",  setupWhole,   opContiguous, false },
+    { "grow",        NULL,         opGrow,       false },
+    { "chunkedgrow", NULL,         opChunkedGrow, false },
+    { "churn",       NULL,         opChurn,      false },
+    { "poolchurn",   NULL,         opPoolChurn,  false },
+};
+
+static void report(const char *name, long size, long chunk, const char *state, long ops, long bytes, double secs) {
+    double nsPerOp = ((secs * 1e9) / (double)ops);
+    double mbs     = ((double)bytes / secs / 1e6);
+
+    switch(gFormat) {
+        case PG_CSV:
+            if(gResults == 0) printf("bench,size,chunk,state,flags,ops,bytes,seconds,ns_per_op,mb_per_s\n");
+            printf("%s,%ld,%ld,%s,%d,%ld,%ld,%.6f,%.3f,%.3f\n", name, size, chunk, state, gFlags, ops, bytes, secs, nsPerOp, mbs);
+            break;
+        case PG_JSON:
+            printf("%s\n  {\"bench\":\"%s\",\"size\":%ld,\"chunk\":%ld,\"state\":\"%s\",\"flags\":%d,\"ops\":%ld,\"bytes\":%ld,\"seconds\":%.6f,\"ns_per_op\":%.3f,\"mb_per_s\":%.3f}",
+                   ((gResults == 0) ? "[" : ","), name, size, chunk, state, gFlags, ops, bytes, secs, nsPerOp, mbs);
+            break;
+        default:
+            if(gResults == 0) printf("%-12s %10s %8s %-9s %12s %12s\n", "bench", "size", "chunk", "state", "ns/op", "MB/s");
+            printf("%-12s %10ld %8ld %-9s %12.2f %12.2f\n", name, size, chunk, state, nsPerOp, mbs);
+            break;
+    }
+
+    gResults++;
+}
+
+/*
+ * The pool's hits and misses since `before`. Only in text format so that the CSV and JSON rows stay the same.
+ */
+static void reportPool(const PGRingBufferPoolStats *before) {
+    PGRingBufferPoolStats st;
+
+    PGGetRingBufferPoolStats(gPool, &st);
+    long hits   = (st.hits - before->hits);
+    long misses = (st.misses - before->misses);
+
+    if(gFormat == PG_TEXT) printf("%-12s hits=%ld misses=%ld (%.2f%% from the pool)\n", "", hits, misses, ((100.0 * (double)hits) / (double)(((hits + misses) > 0) ? (hits + misses) : 1)));
+}
+
+static void runCase(const PGBench *bench, long size, long chunkSize, bool wrapped, uint8_t *chunk) {
+    PGBenchCase           bc    = { NULL, chunk, size, chunkSize, wrapped, 0, 0 };
+    long                  ops   = 0;
+    long                  bytes = 0;
+    long                  batch = 1;
+    double                secs  = 0;
+    PGRingBufferPoolStats before;
+
+    PGGetRingBufferPoolStats(gPool, &before);
+
+    if(bench->setup) {
+        bc.buff = PGCreateRingBufferWithFlags(size, gFlags);
+        if(bc.buff == NULL) return;
+        bench->setup(&bc);
+    }
+
+    // Warm up (and fault in the pages) before timing anything.
+    for(int i = 0; i < 4; ++i) bench->op(&bc);
+
+    while(secs < gMinTime) {
+        double start = now();
+        for(long i = 0; i < batch; ++i) bytes += bench->op(&bc);
+        secs += (now() - start);
+        ops += batch;
+        if(batch < (1L << 20)) batch *= 2;
+    }
+
+    if(bench->perByte) ops *= chunkSize;
+    report(bench->name, size, chunkSize, (bench->setup ? (wrapped ? "wrapped" : "unwrapped") : "-"), ops, bytes, secs);
+    if(bench->op == opPoolChurn) reportPool(&before);
+
+    if(bc.buff) PGDiscardRingBuffer(bc.buff);
+}
+
+// ---------------------------------------------------------------------------------------------------------------
+// Differential check.
+// ---------------------------------------------------------------------------------------------------------------
+
+#define PG_REF_SIZE (1L << 24)
+
+/*
+ * The reference is a plain array with the live bytes in the middle so that it can grow at either end.
+ */
+typedef struct {
+    uint8_t *bytes;
+    long    head;
+    long    tail;
+    long    dropped;
+} PGRef;
+
+static unsigned long gSeed = 88172645463325252UL;
+
+/*
+ * Where the ring buffers under test get their memory. `NULL` for `malloc`.
+ */
+static const PGRingBufferAllocator *gAllocator = NULL;
+
+static long rnd(long n) {
+    gSeed ^= (gSeed << 13);
+    gSeed ^= (gSeed >> 7);
+    gSeed ^= (gSeed << 17);
+    return (long)(gSeed % (unsigned long)n);
+}
+
+/*
+ * The offset of the first match of the `length` bytes at `pattern`, or of any one of them if `any` is `true`,
+ * starting at or after `offset`.
+ */
+static long refFind(const PGRef *ref, long offset, const uint8_t *pattern, long length, bool any) {
+    long cc = (ref->tail - ref->head);
+
+    for(long i = ((offset < 0) ? 0 : offset); (i + (any ? 1 : length)) <= cc; ++i) {
+        const uint8_t *p = (ref->bytes + ref->head + i);
+        if(any ? (memchr(pattern, *p, (size_t)length) != NULL) : (memcmp(p, pattern, (size_t)length) == 0)) return i;
+    }
+
+    return -1;
+}
+
+/*
+ * Writes a record's length prefix the way PGRingBufferRecords.h describes it and returns its size.
+ */
+static long refPrefix(int format, long length, uint8_t *p) {
+    long i = 0;
+
+    if(format == PG_RECORD_VARINT) {
+        for(; length >= 0x80; length >>= 7) p[i++] = (uint8_t)(length | 0x80);
+        p[i++] = (uint8_t)length;
+    }
+    else {
+        for(; i < format; ++i, length >>= 8) p[i] = (uint8_t)length;
+    }
+
+    return i;
+}
+
+/*
+ * Decodes the record `at` bytes past the head of the reference. Returns its length and sets `*prefix`, -1 if it
+ * isn't all there yet, or -2 if the prefix is corrupt or the record would take up more than `maxSize` bytes.
+ */
+static long refRecord(const PGRef *ref, long at, int format, long maxSize, long *prefix) {
+    const uint8_t *b    = (ref->bytes + ref->head + at);
+    long          avail = (ref->tail - ref->head - at);
+    long          len   = 0;
+    long          p     = 0;
+
+    if(format == PG_RECORD_VARINT) {
+        do {
+            if(p == PG_RECORD_MAX_VARINT) return -2;
+            if(p == avail) return -1;
+            len |= ((long)(b[p] & 0x7f) << (7 * p));
+        } while(b[p++] & 0x80);
+    }
+    else {
+        if(avail < format) return -1;
+        for(; p < format; ++p) len |= ((long)b[p] << (8 * p));
+    }
+
+    if(len > (maxSize - p)) return -2;
+    if((avail - p) < len) return -1;
+    *prefix = p;
+    return len;
+}
+
+/*
+ * The most bytes the ring buffer could ever hold under the policy.
+ */
+static long refMaxSize(const PGRingBuffer *b, const PGRingBufferPolicy *policy, int flags) {
+    long mx = policy->maxCapacity;
+
+    if(flags & PG_RINGBUFFER_OVERWRITE) return PGRingBufferCapacity(b);
+    if((mx <= 0) || (mx > (LONG_MAX / 4))) return (LONG_MAX / 4);
+    if(flags & PG_RINGBUFFER_POW2) {
+        long p = 8;
+        while((p << 1) <= (mx + 1)) p <<= 1;
+        return (p - 1);
+    }
+    return mx;
+}
+
+/*
+ * `flags` is -1 for the chunked ring buffer, which doesn't have any.
+ */
+static bool fail(long it, const char *what, int flags) {
+    if(flags < 0) fprintf(stderr, "verify: FAILED at iteration %ld (chunked): %s\n", it, what);
+    else fprintf(stderr, "verify: FAILED at iteration %ld (flags %d): %s\n", it, flags, what);
+    return false;
+}
+
+/*
+ * A random growth and shrink policy. Half the time there's a maximum capacity, big enough that most operations
+ * still fit.
+ */
+static PGRingBufferPolicy randomPolicy(long maxCapacity) {
+    PGRingBufferPolicy p = { (1.0 + ((double)(1 + rnd(300)) / 100.0)), maxCapacity, ((double)(5 + rnd(45)) / 100.0), (1 + rnd(8)) };
+    return p;
+}
+
+/*
+ * Whether adding `n` bytes to `cc` is allowed to fail under the policy's maximum capacity. Power of two storage
+ * stops at the biggest power of two that fits and mirrored storage at the last whole page that fits, so both can
+ * stop short of the maximum. An overwriting buffer never grows past its capacity.
+ */
+static bool mayFail(const PGRingBuffer *b, const PGRingBufferPolicy *policy, int flags, long cc, long n) {
+    long mx = policy->maxCapacity;
+
+    if(flags & PG_RINGBUFFER_OVERWRITE) return ((cc + n) > PGRingBufferCapacity(b));
+    if(mx <= 0) return false;
+    if(flags & PG_RINGBUFFER_POW2) {
+        long p = 8;
+        while((p << 1) <= (mx + 1)) p <<= 1;
+        mx = (p - 1);
+    }
+    else if(flags & PG_RINGBUFFER_MIRRORED) {
+        mx -= sysconf(_SC_PAGESIZE);
+    }
+    return ((cc + n) > mx);
+}
+
+/*
+ * Makes room for `n` new bytes at the tail of the reference the way an overwriting buffer does: drops the oldest
+ * bytes and, if `n` is more than the capacity, the start of the new ones too. Returns how many of the new bytes
+ * are skipped.
+ */
+static long refOverwrite(const PGRingBuffer *b, int flags, PGRef *ref, long n) {
+    long cap  = PGRingBufferCapacity(b);
+    long skip = ((n > cap) ? (n - cap) : 0);
+    long drop = ((ref->tail - ref->head) + (n - skip) - cap);
+
+    if(!(flags & PG_RINGBUFFER_OVERWRITE)) return 0;
+    if(drop > 0) ref->head += drop;
+    ref->dropped += (((drop > 0) ? drop : 0) + skip);
+    return skip;
+}
+
+#define PG_VERIFY_RECORDS (8)
+
+/*
+ * Appends a batch of records, reads one, or pops a batch. Most of what's in the buffer isn't records at all so
+ * reading them also checks how random bytes are decoded, corrupt and incomplete prefixes included.
+ */
+static bool verifyRecords(long it, int flags, PGRingBuffer *b, PGRef *ref, const PGRingBufferPolicy *pol, uint8_t *tmp) {
+    static const int formats[] = { PG_RECORD_VARINT, PG_RECORD_FIXED16, PG_RECORD_FIXED32 };
+    int              format    = formats[rnd(3)];
+    long             mx        = refMaxSize(b, pol, flags);
+    long             cc        = (ref->tail - ref->head);
+    PGRingBufferSpan recs[PG_VERIFY_RECORDS];
+    long             p;
+
+    switch(rnd(3)) {
+        case 0: {
+            long    k     = rnd(PG_VERIFY_RECORDS + 1);
+            long    total = 0;
+            long    at    = 0;
+            bool    fits  = true;
+            uint8_t prefix[PG_RECORD_MAX_VARINT];
+
+            for(long i = 0; i < k; ++i) {
+                // Now and then one that's too long for a 16-bit prefix.
+                long l = ((rnd(50) == 0) ? (65530 + rnd(16)) : ((rnd(10) == 0) ? rnd(1 << 13) : rnd(200)));
+
+                recs[i].bytes  = (tmp + rnd(1 << 15));
+                recs[i].length = l;
+                total += (refPrefix(format, l, prefix) + l);
+                fits = (fits && ((format != PG_RECORD_FIXED16) || (l <= UINT16_MAX)));
+            }
+            for(long i = 0; i < (1 << 17); ++i) tmp[i] = (uint8_t)rnd(256);
+
+            if(!PGAppendRecordsToRingBuffer(b, format, recs, k)) {
+                if(fits && !mayFail(b, pol, flags, ((flags & PG_RINGBUFFER_OVERWRITE) ? 0 : cc), total)) return fail(it, "append records", flags);
+            }
+            else if(!fits) {
+                return fail(it, "append records too long", flags);
+            }
+            else {
+                // An overwriting buffer drops whole records, or everything if the head isn't records.
+                for(long need = (cc + total - mx); (flags & PG_RINGBUFFER_OVERWRITE) && (at < need);) {
+                    long e = refRecord(ref, at, format, mx, &p);
+                    at = ((e < 0) ? cc : (at + p + e));
+                }
+                ref->head    += at;
+                ref->dropped += at;
+                for(long i = 0; i < k; ++i) {
+                    at = refPrefix(format, recs[i].length, (ref->bytes + ref->tail));
+                    memcpy((ref->bytes + ref->tail + at), recs[i].bytes, (size_t)recs[i].length);
+                    ref->tail += (at + recs[i].length);
+                }
+            }
+            return true;
+        }
+        case 1: {
+            long e   = refRecord(ref, 0, format, mx, &p);
+            long max = ((e > 0) ? (e - rnd(2)) : (1 << 17));
+
+            if(max > (1 << 17)) max = (1 << 17);
+            if(PGNextRecordSize(b, format) != e) return fail(it, "next record size", flags);
+
+            long r = PGReadRecordFromRingBuffer(b, format, tmp, max);
+
+            if(r != (((e >= 0) && (e > max)) ? -1 : e)) return fail(it, "read record", flags);
+            if(r >= 0) {
+                if(memcmp(tmp, (ref->bytes + ref->head + p), (size_t)r)) return fail(it, "read record bytes", flags);
+                ref->head += (p + r);
+            }
+            return true;
+        }
+        default: {
+            long max = (1 + rnd(PG_VERIFY_RECORDS));
+            long n   = PGPopRecordsFromRingBuffer(b, format, recs, max);
+            long e   = refRecord(ref, 0, format, mx, &p);
+            long at  = 0;
+
+            if((e < 0) ? (n != ((e == -2) ? -2 : 0)) : ((n < 1) || (n > max))) return fail(it, "pop records", flags);
+
+            // Pop can stop early rather than move a wrapped record so only the ones it returned are checked.
+            for(long i = 0; i < n; ++i) {
+                e = refRecord(ref, at, format, mx, &p);
+                if((e != recs[i].length) || memcmp(recs[i].bytes, (ref->bytes + ref->head + at + p), (size_t)e)) return fail(it, "pop record bytes", flags);
+                at += (p + e);
+            }
+            ref->head += at;
+            return true;
+        }
+    }
+}
+
+/*
+ * Copies `count` words of `width` bytes, reversing the bytes of each one when `swap` is set.
+ */
+static void refWords(uint8_t *dst, const uint8_t *src, long width, long count, bool swap) {
+    for(long i = 0; i < (width * count); i += width) {
+        for(long j = 0; j < width; ++j) dst[i + j] = src[i + (swap ? (width - 1 - j) : j)];
+    }
+}
+
+/*
+ * Appends or reads 16, 32 or 64 bit words in big or little endian byte order, either as an array or one typed
+ * integer at a time.
+ */
+static bool verifyWords(long it, int flags, PGRingBuffer *b, PGRef *ref, const PGRingBufferPolicy *pol, uint8_t *tmp) {
+    long    w     = (2L << rnd(3));
+    long    order = ((rnd(2) == 0) ? PGBigEndianByteOrder() : PGLittleEndianByteOrder());
+    bool    swap  = (order != PGHostByteOrder());
+    bool    one   = (rnd(4) == 0);
+    bool    huge  = (!one && (rnd(64) == 0));
+    long    k     = (one ? 1 : rnd(1024));
+    long    cc    = (ref->tail - ref->head);
+    uint8_t *dst  = (tmp + (1 << 16));
+
+    if(rnd(2) == 0) {
+        bool r;
+
+        // A count whose length in bytes doesn't fit in a long. For 4 and 8 byte words it wraps to one word.
+        if(huge) k = (((~0UL / (unsigned long)w) < (unsigned long)LONG_MAX) ? (long)((~0UL / (unsigned long)w) + 2) : LONG_MAX);
+
+        if(one) r = ((w == 2) ? PGAppendUInt16ToRingBuffer(b, *(uint16_t *)tmp, order) : ((w == 4) ? PGAppendUInt32ToRingBuffer(b, *(uint32_t *)tmp, order) : PGAppendUInt64ToRingBuffer(b, *(uint64_t *)tmp, order)));
+        else r = ((w == 2) ? PGAppendWords16ToRingBuffer(b, (uint16_t *)tmp, k, order) : ((w == 4) ? PGAppendWords32ToRingBuffer(b, (uint32_t *)tmp, k, order) : PGAppendWords64ToRingBuffer(b, (uint64_t *)tmp, k, order)));
+
+        if(huge) return ((!r && (PGRingBufferCount(b) == cc)) || fail(it, "append words with an overflowing count", flags));
+        if(!r) return (mayFail(b, pol, flags, ((flags & PG_RINGBUFFER_OVERWRITE) ? 0 : cc), (w * k)) || fail(it, "append words", flags));
+        // A single word bigger than an overwriting buffer's capacity only has its last bytes kept.
+        long skip = refOverwrite(b, flags, ref, (w * k));
+
+        refWords(dst, tmp, w, k, swap);
+        memcpy((ref->bytes + ref->tail), (dst + skip), (size_t)((w * k) - skip));
+        ref->tail += ((w * k) - skip);
+    }
+    else {
+        long e = (((cc / w) < k) ? (cc / w) : k);
+        long n;
+
+        if(one) n = (((w == 2) ? PGReadUInt16FromRingBuffer(b, (uint16_t *)tmp, order) : ((w == 4) ? PGReadUInt32FromRingBuffer(b, (uint32_t *)tmp, order) : PGReadUInt64FromRingBuffer(b, (uint64_t *)tmp, order))) ? 1 : 0);
+        else n = ((w == 2) ? PGReadWords16FromRingBuffer(b, (uint16_t *)tmp, k, order) : ((w == 4) ? PGReadWords32FromRingBuffer(b, (uint32_t *)tmp, k, order) : PGReadWords64FromRingBuffer(b, (uint64_t *)tmp, k, order)));
+
+        refWords(dst, (ref->bytes + ref->head), w, e, swap);
+        if((n != e) || memcmp(tmp, dst, (size_t)(w * e))) return fail(it, "read words", flags);
+        ref->head += (w * e);
+    }
+
+    return true;
+}
+
+/*
+ * Moves a second ring buffer onto either end of this one, or splits this one and, half the time, moves the part
+ * that was split off back onto the front. The second buffer usually has the same flags and policy so that the
+ * storage can be traded instead of copied.
+ */
+static bool verifyMoves(long it, int flags, PGRingBuffer **pb, PGRef *ref, const PGRingBufferPolicy *pol, uint8_t *tmp) {
+    PGRingBuffer     *b = *pb;
+    long             cc = (ref->tail - ref->head);
+    long             m  = ((rnd(4) == 0) ? rnd(1 << 16) : rnd(256));
+    int              of = ((rnd(4) == 0) ? PG_RINGBUFFER_DEFAULT : (flags & ~PG_RINGBUFFER_OVERWRITE));
+    PGRingBuffer     *o;
+    PGRingBufferSpan spans[2];
+    bool             r;
+
+    if(rnd(3) == 0) {
+        long at = rnd(cc + 1);
+
+        if((o = PGSplitRingBuffer(b, at)) == NULL) return fail(it, "split", flags);
+        if((PGRingBufferCount(o) != at) || (PGRingBufferCount(b) != (cc - at))) return fail(it, "split count", flags);
+        PGPeekSpansFromRingBuffer(o, spans);
+        if(memcmp(spans[0].bytes, (ref->bytes + ref->head), (size_t)spans[0].length) ||
+           memcmp(spans[1].bytes, (ref->bytes + ref->head + spans[0].length), (size_t)spans[1].length)) return fail(it, "split bytes", flags);
+        ref->head += at;
+
+        if(rnd(2) == 0) {
+            if(!PGMoveRingBufferToFrontOfRingBuffer(b, o)) return fail(it, "move split back", flags);
+            ref->head -= at;
+        }
+        // The part split off becomes the buffer under test now and then.
+        else if(rnd(4) == 0) {
+            ref->tail     = ref->head;
+            ref->head    -= at;
+            ref->dropped  = PGRingBufferDroppedBytes(o);
+            *pb           = o;
+            o             = b;
+        }
+
+        PGDiscardRingBuffer(o);
+        return true;
+    }
+
+    o = PGCreateRingBufferWithAllocator(rnd(64), of, gAllocator);
+    if(of == (flags & ~PG_RINGBUFFER_OVERWRITE)) PGSetRingBufferPolicy(o, pol);
+    PGAppendToRingBuffer(o, tmp, m);
+
+    if(rnd(2) == 0) {
+        if(!(r = PGMoveRingBufferToRingBuffer(b, o)) && !mayFail(b, pol, flags, cc, m)) return fail(it, "move", flags);
+        if(r) {
+            long skip = refOverwrite(b, flags, ref, m);
+            memcpy((ref->bytes + ref->tail), (tmp + skip), (size_t)(m - skip));
+            ref->tail += (m - skip);
+        }
+    }
+    else {
+        if(!(r = PGMoveRingBufferToFrontOfRingBuffer(b, o)) && !mayFail(b, pol, flags, cc, m)) return fail(it, "move to front", flags);
+        if(r) {
+            ref->head -= m;
+            memcpy((ref->bytes + ref->head), tmp, (size_t)m);
+        }
+    }
+
+    if(PGRingBufferCount(o) != (r ? 0 : m)) return fail(it, "moved from", flags);
+    PGDiscardRingBuffer(o);
+    return true;
+}
+
+static bool verifyFlags(int flags, bool policy, long iterations) {
+    PGRingBuffer       *b   = PGCreateRingBufferWithAllocator((((flags & PG_RINGBUFFER_OVERWRITE) && rnd(2)) ? rnd(1 << 20) : rnd(64)), flags, gAllocator);
+    PGRef              ref  = { malloc(PG_REF_SIZE), (PG_REF_SIZE / 2), (PG_REF_SIZE / 2), 0 };
+    uint8_t            *tmp = malloc(1 << 17);
+    PGRingBufferPolicy pol  = (policy ? randomPolicy((rnd(2) == 0) ? 0 : ((1L << 16) + rnd(1L << 20))) : PG_RINGBUFFER_DEFAULT_POLICY);
+    bool               ok   = true;
+
+    PGSetRingBufferPolicy(b, &pol);
+
+    for(long it = 0; ok && (it < iterations); ++it) {
+        long cc = (ref.tail - ref.head);
+        long n  = ((rnd(20) == 0) ? rnd(1 << 16) : rnd(64));
+        long e  = ((n < cc) ? n : cc);
+
+        // Keep the reference well away from the ends of its array. A batch of records can add up to half a MB.
+        if((ref.head < (1 << 17)) || (ref.tail > (PG_REF_SIZE - (1 << 20))) || (cc > (1 << 22))) {
+            PGClearRingBuffer(b, (rnd(2) == 0));
+            ref.head = ref.tail = (PG_REF_SIZE / 2);
+            continue;
+        }
+
+        for(long i = 0; i < n; ++i) tmp[i] = (uint8_t)rnd(256);
+
+        switch(rnd(20)) {
+            case 0:
+            case 1:
+                if(!PGAppendToRingBuffer(b, tmp, n)) {
+                    if(!mayFail(b, &pol, flags, cc, n)) return fail(it, "append", flags);
+                    break;
+                }
+                e = refOverwrite(b, flags, &ref, n);
+                memcpy(ref.bytes + ref.tail, (tmp + e), (size_t)(n - e));
+                ref.tail += (n - e);
+                break;
+            case 2:
+                if(PGReadFromRingBuffer(b, tmp, n) != e || memcmp(tmp, ref.bytes + ref.head, (size_t)e)) ok = fail(it, "read", flags);
+                ref.head += e;
+                break;
+            case 3:
+                if(!PGPrependToRingBuffer(b, tmp, n)) {
+                    if(!mayFail(b, &pol, flags, cc, n)) return fail(it, "prepend", flags);
+                    break;
+                }
+                ref.head -= n;
+                memcpy(ref.bytes + ref.head, tmp, (size_t)n);
+                break;
+            case 4:
+                if(PGPeekFromRingBuffer(b, tmp, n) != e || memcmp(tmp, ref.bytes + ref.head, (size_t)e)) ok = fail(it, "peek", flags);
+                break;
+            case 5:
+                if(PGReadLastFromRingBuffer(b, tmp, n) != e || memcmp(tmp, ref.bytes + ref.tail - e, (size_t)e)) ok = fail(it, "read last", flags);
+                ref.tail -= e;
+                break;
+            case 6:
+                PGRingBufferConsume(b, n);
+                ref.head += e;
+                break;
+            case 7:
+                if(!PGAppendByteToRingBuffer(b, tmp[0])) {
+                    if(!mayFail(b, &pol, flags, cc, 1)) return fail(it, "append byte", flags);
+                    break;
+                }
+                refOverwrite(b, flags, &ref, 1);
+                ref.bytes[ref.tail++] = tmp[0];
+                break;
+            case 8:
+                if(!PGPrependByteToRingBuffer(b, tmp[0])) {
+                    if(!mayFail(b, &pol, flags, cc, 1)) return fail(it, "prepend byte", flags);
+                    break;
+                }
+                ref.bytes[--ref.head] = tmp[0];
+                break;
+            case 9:
+                if(cc) {
+                    long o = rnd(cc);
+                    PGSetByteOnRingBuffer(b, o, tmp[0]);
+                    ref.bytes[ref.head + o] = tmp[0];
+                    if(PGGetByteFromRingBuffer(b, o) != tmp[0]) ok = fail(it, "get byte", flags);
+                }
+                break;
+            case 10: {
+                long w   = (2L << rnd(3));
+                long ws  = ((w == 2) ? PGSwapRingBufferEndian16(b) : ((w == 4) ? PGSwapRingBufferEndian32(b) : PGSwapRingBufferEndian64(b)));
+                if(ws != (cc / w)) ok = fail(it, "swap count", flags);
+                for(long i = 0; i < ws; ++i) {
+                    uint8_t *p = (ref.bytes + ref.head + (i * w));
+                    for(long j = 0; j < (w / 2); ++j) {
+                        uint8_t t = p[j];
+                        p[j] = p[w - 1 - j];
+                        p[w - 1 - j] = t;
+                    }
+                }
+                break;
+            }
+            case 11:
+                if(rnd(10) == 0) {
+                    long    sz;
+                    uint8_t *p = PGGetRingBufferBuffer(b, &sz);
+                    if(sz != cc || memcmp(p, ref.bytes + ref.head, (size_t)cc)) ok = fail(it, "defrag", flags);
+                }
+                break;
+            case 12: {
+                uint8_t *p = PGMakeRingBufferContiguous(b, n);
+                if(memcmp(p, ref.bytes + ref.head, (size_t)e)) ok = fail(it, "contiguous", flags);
+                break;
+            }
+            case 13: {
+                PGRingBufferSpan spans[2];
+                long             l = PGRingBufferReserve(b, n, spans);
+                long             k = 0;
+                long             m = ((rnd(4) == 0) ? rnd(l + 1) : l);
+
+                if(flags & PG_RINGBUFFER_OVERWRITE) {
+                    if(l != ((n < PGRingBufferCapacity(b)) ? n : PGRingBufferCapacity(b))) return fail(it, "reserve", flags);
+                }
+                else if((l != n) && ((l != PGRingBufferRemaining(b)) || !mayFail(b, &pol, flags, cc, n))) {
+                    return fail(it, "reserve", flags);
+                }
+                // Now and then only part of it is written and committed. An overwriting buffer only drops what that
+                // needs, and the spans run over its oldest bytes, so nothing past that is written.
+                for(int s = 0; s < 2; ++s) for(long i = 0; (i < spans[s].length) && (k < m); ++i) spans[s].bytes[i] = tmp[k++];
+                PGRingBufferCommit(b, m);
+                refOverwrite(b, flags, &ref, m);
+                memcpy(ref.bytes + ref.tail, tmp, (size_t)m);
+                ref.tail += m;
+                break;
+            }
+            case 14: {
+                // Only the last few KB are searched so that the reference's slow search doesn't take over.
+                long    o  = (cc - rnd(1 << 14));
+                long    s  = ((o < 0) ? 0 : o);
+                long    pl = (1 + rnd(16));
+                uint8_t *p = tmp;
+
+                // Half the time the pattern comes from the contents so that there's something to find.
+                if((s < cc) && (rnd(2) == 0)) {
+                    long at = (s + rnd(cc - s));
+                    if(pl > (cc - at)) pl = (cc - at);
+                    p = (ref.bytes + ref.head + at);
+                }
+                if(PGFindByteInRingBuffer(b, o, p[0]) != refFind(&ref, o, p, 1, false)) ok = fail(it, "find byte", flags);
+                else if(PGFindAnyByteInRingBuffer(b, o, p, pl) != refFind(&ref, o, p, pl, true)) ok = fail(it, "find any byte", flags);
+                else if(PGFindInRingBuffer(b, o, p, pl) != refFind(&ref, o, p, pl, false)) ok = fail(it, "find", flags);
+                break;
+            }
+            case 15:
+                if(!verifyRecords(it, flags, b, &ref, &pol, tmp)) return false;
+                break;
+            case 16:
+                // A few single words, in host byte order, appended or read one at a time.
+                for(long k = rnd(8), w = (2L << rnd(3)), add = rnd(2); ok && (k > 0); --k, cc = (ref.tail - ref.head)) {
+                    union { uint16_t w16; uint32_t w32; uint64_t w64; } v;
+                    bool r;
+
+                    if(add) {
+                        memcpy(&v, (tmp + k), (size_t)w);
+                        r = ((w == 2) ? PGAppendWord16ToRingBuffer(b, v.w16) : ((w == 4) ? PGAppendWord32ToRingBuffer(b, v.w32) : PGAppendWord64ToRingBuffer(b, v.w64)));
+                        if(!r && !mayFail(b, &pol, flags, cc, w)) return fail(it, "append word", flags);
+                        if(r) {
+                            long skip = refOverwrite(b, flags, &ref, w);
+                            memcpy((ref.bytes + ref.tail), ((uint8_t *)&v + skip), (size_t)(w - skip));
+                            ref.tail += (w - skip);
+                        }
+                    }
+                    else {
+                        r = ((w == 2) ? PGReadWord16FromRingBuffer(b, &v.w16) : ((w == 4) ? PGReadWord32FromRingBuffer(b, &v.w32) : PGReadWord64FromRingBuffer(b, &v.w64)));
+                        if((r != (cc >= w)) || (r && memcmp(&v, (ref.bytes + ref.head), (size_t)w))) ok = fail(it, "read word", flags);
+                        if(r) ref.head += w;
+                    }
+                }
+                break;
+            case 17:
+                if(!verifyWords(it, flags, b, &ref, &pol, tmp)) return false;
+                break;
+            case 18:
+                if(!verifyMoves(it, flags, &b, &ref, &pol, tmp)) return false;
+                break;
+            default:
+                if(rnd(50) == 0) {
+                    PGShrinkRingBuffer(b);
+                }
+                else if(policy && (rnd(64) == 0)) {
+                    // Drain most of it in small reads so that the shrink policy sees it under used several times
+                    // in a row.
+                    for(long k = 0; ok && (k < 16); ++k) {
+                        long m = (1 + rnd(1 << 16));
+                        if(m > (ref.tail - ref.head)) m = (ref.tail - ref.head);
+                        if(PGReadFromRingBuffer(b, tmp, m) != m || memcmp(tmp, ref.bytes + ref.head, (size_t)m)) ok = fail(it, "drain", flags);
+                        ref.head += m;
+                    }
+                }
+                else if(policy && (rnd(50) == 0)) {
+                    // Change how it grows and shrinks part way through but keep the same maximum.
+                    pol = randomPolicy(pol.maxCapacity);
+                    PGSetRingBufferPolicy(b, &pol);
+                }
+                break;
+        }
+
+        cc = (ref.tail - ref.head);
+        if(ok && PGRingBufferCount(b) != cc) ok = fail(it, "count", flags);
+        if(ok && (PGRingBufferDroppedBytes(b) != ref.dropped)) ok = fail(it, "dropped bytes", flags);
+        if(ok && (pol.maxCapacity > 0) && !(flags & PG_RINGBUFFER_OVERWRITE) && (PGRingBufferCapacity(b) > pol.maxCapacity)) ok = fail(it, "maximum capacity", flags);
+        if(ok && (rnd(100) == 0)) {
+            PGRingBufferSpan spans[2];
+            PGPeekSpansFromRingBuffer(b, spans);
+            if(memcmp(spans[0].bytes, ref.bytes + ref.head, (size_t)spans[0].length) ||
+               memcmp(spans[1].bytes, ref.bytes + ref.head + spans[0].length, (size_t)spans[1].length)) ok = fail(it, "contents", flags);
+        }
+    }
+
+    PGDiscardRingBuffer(b);
+    free(ref.bytes);
+    free(tmp);
+    return ok;
+}
+
+/*
+ * Runs a PGChunkedRingBuffer with small chunks against the reference. Half of the lengths are within a byte of a
+ * whole number of chunks so that reads and consumes keep ending right at, or right next to, the end of a chunk,
+ * which is where emptied chunks become spares or are freed. Now and then the buffer is cleared or replaced by one
+ * with a different chunk size and number of spares.
+ */
+static bool verifyChunked(long iterations) {
+    PGChunkedRingBuffer *b    = NULL;
+    long                cs    = 0;
+    long                spare = 0;
+    long                limit = 0;  // The most spare chunks there can be. Only a clear that keeps them raises it.
+    PGRef               ref   = { malloc(PG_REF_SIZE), 0, 0, 0 };
+    uint8_t             *tmp  = malloc(1 << 17);
+    bool                ok    = true;
+
+    for(long it = 0; ok && (it < iterations); ++it) {
+        if(b == NULL) {
+            spare = limit = rnd(4);
+            b     = PGCreateChunkedRingBufferWithAllocator((64L << rnd(3)), spare, gAllocator);
+            cs    = PGChunkedRingBufferChunkSize(b);
+            ref.head = ref.tail = 0;
+        }
+
+        long cc = (ref.tail - ref.head);
+        long n  = ((rnd(2) == 0) ? ((rnd(4) * cs) + rnd(3) - 1) : ((rnd(20) == 0) ? rnd(1 << 16) : rnd(64)));
+        long e;
+
+        if(n < 0) n = 0;
+        e = ((n < cc) ? n : cc);
+
+        if((ref.tail > (PG_REF_SIZE - (1 << 17))) || (rnd(2000) == 0)) {
+            bool keep = (rnd(2) == 0);
+
+            if(rnd(3) == 0) {
+                PGDiscardChunkedRingBuffer(b);
+                b = NULL;
+                continue;
+            }
+
+            PGClearChunkedRingBuffer(b, keep);
+            if(keep && (((PGChunkedRingBufferCapacity(b) / cs) - 1) > limit)) limit = ((PGChunkedRingBufferCapacity(b) / cs) - 1);
+            if(!keep && (PGChunkedRingBufferCapacity(b) != cs)) ok = fail(it, "chunked clear", -1);
+            if(!keep) limit = spare;
+            ref.head = ref.tail = 0;
+            continue;
+        }
+
+        for(long i = 0; i < n; ++i) tmp[i] = (uint8_t)rnd(256);
+
+        switch(rnd(8)) {
+            case 0:
+            case 1:
+                if(!PGAppendToChunkedRingBuffer(b, tmp, n)) ok = fail(it, "chunked append", -1);
+                memcpy((ref.bytes + ref.tail), tmp, (size_t)n);
+                ref.tail += n;
+                break;
+            case 2:
+                if((PGReadFromChunkedRingBuffer(b, tmp, n) != e) || memcmp(tmp, (ref.bytes + ref.head), (size_t)e)) ok = fail(it, "chunked read", -1);
+                ref.head += e;
+                break;
+            case 3:
+                if((PGPeekFromChunkedRingBuffer(b, tmp, n) != e) || memcmp(tmp, (ref.bytes + ref.head), (size_t)e)) ok = fail(it, "chunked peek", -1);
+                break;
+            case 4:
+                PGChunkedRingBufferConsume(b, n);
+                ref.head += e;
+                break;
+            case 5:
+                for(long k = rnd(8); k > 0; --k) {
+                    if(!PGAppendByteToChunkedRingBuffer(b, tmp[k])) ok = fail(it, "chunked append byte", -1);
+                    ref.bytes[ref.tail++] = tmp[k];
+                }
+                break;
+            case 6:
+                // Offsets outside of the bytes wrap around, negative ones from the end.
+                if(cc) {
+                    long o = ((rnd(4) == 0) ? (rnd(cc * 4) - (cc * 2)) : rnd(cc));
+                    long i = (((o % cc) + cc) % cc);
+
+                    if(PGGetByteFromChunkedRingBuffer(b, o) != ref.bytes[ref.head + i]) ok = fail(it, "chunked get byte", -1);
+                    PGSetByteOnChunkedRingBuffer(b, o, tmp[0]);
+                    ref.bytes[ref.head + i] = tmp[0];
+                }
+                else if(PGGetByteFromChunkedRingBuffer(b, rnd(8)) != 0) {
+                    ok = fail(it, "chunked get byte when empty", -1);
+                }
+                break;
+            default: {
+                PGRingBufferSpan spans[8];
+                long             max = (1 + rnd(8));
+                long             ns  = PGGetChunkedRingBufferSpans(b, spans, max);
+                long             at  = 0;
+
+                if((cc == 0) != (ns == 0)) ok = fail(it, "chunked span count", -1);
+                for(long i = 0; ok && (i < ((ns < max) ? ns : max)); ++i) {
+                    // Only the first span can start part way into a chunk and only the last can end part way.
+                    if((spans[i].length <= 0) || (spans[i].length > cs) || ((i > 0) && (i < (ns - 1)) && (spans[i].length != cs))) ok = fail(it, "chunked span length", -1);
+                    else if(memcmp(spans[i].bytes, (ref.bytes + ref.head + at), (size_t)spans[i].length)) ok = fail(it, "chunked span bytes", -1);
+                    at += spans[i].length;
+                }
+                if(ok && (ns <= max) && (at != cc)) ok = fail(it, "chunked spans", -1);
+                break;
+            }
+        }
+
+        cc = (ref.tail - ref.head);
+        if(ok && (PGChunkedRingBufferCount(b) != cc)) ok = fail(it, "chunked count", -1);
+        // At most one chunk that's partly used at each end, plus the spares. Even when it's empty there's a chunk.
+        if(ok && ((PGChunkedRingBufferCapacity(b) < ((cc == 0) ? cs : cc)) || (PGChunkedRingBufferCapacity(b) > (cc + ((limit + 1) * cs))))) ok = fail(it, "chunked capacity", -1);
+    }
+
+    PGDiscardChunkedRingBuffer(b);
+    free(ref.bytes);
+    free(tmp);
+    return ok;
+}
+
+static int verify(long iterations) {
+    const int flags[] = {
+        PG_RINGBUFFER_DEFAULT,
+        PG_RINGBUFFER_POW2,
+        PG_RINGBUFFER_MIRRORED,
+        (PG_RINGBUFFER_MIRRORED | PG_RINGBUFFER_POW2),
+        PG_RINGBUFFER_PAGE_ALIGNED,
+        (PG_RINGBUFFER_HUGEPAGES | PG_RINGBUFFER_POW2),
+        PG_RINGBUFFER_OVERWRITE,
+        (PG_RINGBUFFER_OVERWRITE | PG_RINGBUFFER_MIRRORED | PG_RINGBUFFER_POW2),
+    };
+    bool      ok = true;
+
+    // Each set of flags is run once with the default policy and once with random growth, shrink and maximum
+    // capacity policies. Then the random policies are run again with the ring buffers coming from a pool that only
+    // keeps a couple of blocks of each size up to 64KB, so that growing and shrinking moves them between size
+    // classes and in and out of the pool.
+    for(size_t i = 0; i < (sizeof(flags) / sizeof(flags[0])); ++i) {
+        for(int run = 0; run < 3; ++run) {
+            PGRingBufferPool      *pool = ((run == 2) ? PGCreateRingBufferPool(2, (1 << 16)) : NULL);
+            PGRingBufferPoolStats st;
+            bool                  r;
+
+            gAllocator = (pool ? PGRingBufferPoolAllocator(pool) : NULL);
+            r          = verifyFlags(flags[i], (run > 0), iterations);
+
+            if(pool) {
+                // Everything has been discarded so every block that was handed out has been given back.
+                PGGetRingBufferPoolStats(pool, &st);
+                if(r && ((st.hits + st.misses) != (st.recycled + st.released))) r = fail(iterations, "pool blocks not given back", flags[i]);
+                PGDiscardRingBufferPool(pool);
+                gAllocator = NULL;
+            }
+
+            printf("verify flags=%-3d policy=%-7s alloc=%-6s iterations=%-10ld %s\n", flags[i], ((run > 0) ? "random" : "default"), (pool ? "pool" : "malloc"), iterations, (r ? "ok" : "FAILED"));
+            ok = (ok && r);
+        }
+    }
+
+    // The chunked ring buffer, with its chunks coming from malloc and then from a pool.
+    for(int run = 0; run < 2; ++run) {
+        PGRingBufferPool      *pool = (run ? PGCreateRingBufferPool(2, 0) : NULL);
+        PGRingBufferPoolStats st;
+        bool                  r;
+
+        gAllocator = (pool ? PGRingBufferPoolAllocator(pool) : NULL);
+        r          = verifyChunked(iterations);
+
+        if(pool) {
+            PGGetRingBufferPoolStats(pool, &st);
+            if(r && ((st.hits + st.misses) != (st.recycled + st.released))) r = fail(iterations, "pool blocks not given back", -1);
+            PGDiscardRingBufferPool(pool);
+            gAllocator = NULL;
+        }
+
+        printf("verify chunked                alloc=%-6s iterations=%-10ld %s\n", (pool ? "pool" : "malloc"), iterations, (r ? "ok" : "FAILED"));
+        ok = (ok && r);
+    }
+
+    return (ok ? 0 : 1);
+}
+
+// ---------------------------------------------------------------------------------------------------------------
+
+int main(int argc, const char *argv[]) {
+    const char *filter  = NULL;
+    bool        quick   = false;
+    long        verifyN = 0;
+
+    for(int i = 1; i < argc; ++i) {
+        const char *a = argv[i];
+
+        if(strcmp(a, "--format=csv") == 0) gFormat = PG_CSV;
+        else if(strcmp(a, "--format=json") == 0) gFormat = PG_JSON;
+        else if(strcmp(a, "--format=text") == 0) gFormat = PG_TEXT;
+        else if(strncmp(a, "--min-time=", 11) == 0) gMinTime = (atof(a + 11) / 1000.0);
+        else if(strncmp(a, "--filter=", 9) == 0) filter = (a + 9);
+        else if(strcmp(a, "--pow2") == 0) gFlags |= PG_RINGBUFFER_POW2;
+        else if(strcmp(a, "--mirrored") == 0) gFlags |= PG_RINGBUFFER_MIRRORED;
+        else if(strcmp(a, "--quick") == 0) quick = true;
+        else if(strcmp(a, "--verify") == 0) verifyN = 100000;
+        else if(strncmp(a, "--verify=", 9) == 0) verifyN = atol(a + 9);
+        else {
+            fprintf(stderr, "usage: %s [--format=text|csv|json] [--min-time=ms] [--filter=name] [--pow2] [--mirrored] [--quick] [--verify[=iterations]]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if(verifyN > 0) return verify(verifyN);
+
+    const long sizes[]  = { (4L * 1024), (64L * 1024), (1024L * 1024), (16L * 1024 * 1024) };
+    const long chunks[] = { 16, 256, 4096, 65536 };
+    size_t     nsizes   = (quick ? 2 : (sizeof(sizes) / sizeof(sizes[0])));
+    uint8_t    *chunk   = malloc(65536);
+
+    gPool = PGCreateRingBufferPool(0, 0);
+    if(quick && (gMinTime > 0.01)) gMinTime = 0.01;
+    memset(chunk, 0xa5, 65536);
+
+    for(size_t b = 0; b < (sizeof(gBenches) / sizeof(gBenches[0])); ++b) {
+        const PGBench *bench = &gBenches[b];
+
+        if(filter && strcmp(filter, bench->name)) continue;
+
+        for(size_t s = 0; s < nsizes; ++s) {
+            for(size_t c = 0; c < (sizeof(chunks) / sizeof(chunks[0])); ++c) {
+                // The operations need room for a few chunks either side of the head.
+                if((chunks[c] * 4) > sizes[s]) continue;
+
+                if(bench->setup) {
+                    runCase(bench, sizes[s], chunks[c], false, chunk);
+                    runCase(bench, sizes[s], chunks[c], true, chunk);
+                }
+                else {
+                    runCase(bench, sizes[s], chunks[c], false, chunk);
+                }
+            }
+        }
+    }
+
+    if(gFormat == PG_JSON) printf((gResults ? "\n]\n" : "[]\n"));
+
+    PGDiscardRingBufferPool(gPool);
+    free(chunk);
+    return 0;
+}
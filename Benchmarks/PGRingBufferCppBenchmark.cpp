@@ -0,0 +1,170 @@
+//
+//  PGRingBufferCppBenchmark.cpp
+//  PGRingBuffer
+//
+//  Created by Galen Rhodes on 10/16/26.
+//  Copyright © 2020 Project Galen. All rights reserved.
+//
+//  Compares the header-only pg::RingBuffer template against the C API for the small operations where the cost of
+//  an out-of-line call dominates: single byte appends and reads, indexed access, and passing 64-bit values between
+//  two threads.
+//
+//  Build: cmake -S . -B build && cmake --build build --target PGRingBufferCppBenchmark
+//  Usage: PGRingBufferCppBenchmark [millions of operations]
+//
+
+#include "PGRingBuffer.h"
+#include "PGSPSCRingBuffer.h"
+#include "PGRingBuffer.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+static double now() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void report(const char *name, long ops, double secs, unsigned long check) {
+    std::printf("%-34s %8.2f ns/op   %10.2f Mops/s   (%lu)\n", name, ((secs * 1e9) / (double)ops), ((double)ops / secs / 1e6), check);
+}
+
+// Bytes one at a time through a buffer that is kept half full.
+
+static void bytesC(long ops) {
+    PGRingBuffer  *b = PGCreateRingBufferPow2(4096);
+    unsigned long x  = 0;
+    uint8_t       v;
+
+    for(int i = 0; i < 2048; ++i) PGAppendByteToRingBuffer(b, (uint8_t)i);
+
+    double start = now();
+    for(long i = 0; i < ops; ++i) {
+        PGAppendByteToRingBuffer(b, (uint8_t)i);
+        PGReadFromRingBuffer(b, &v, 1);
+        x += v;
+    }
+    report("C     append byte + read byte", ops, (now() - start), x);
+    PGDiscardRingBuffer(b);
+}
+
+template <typename R>
+static void bytesCpp(const char *name, R &r, long ops) {
+    unsigned long x = 0;
+    uint8_t       v = 0;
+
+    for(int i = 0; i < 2048; ++i) r.append((uint8_t)i);
+
+    double start = now();
+    for(long i = 0; i < ops; ++i) {
+        r.append((uint8_t)i);
+        r.read(v);
+        x += v;
+    }
+    report(name, ops, (now() - start), x);
+}
+
+// Indexed access over the whole of a wrapped buffer.
+
+static void indexC(long ops) {
+    PGRingBuffer  *b = PGCreateRingBufferPow2(4096);
+    unsigned long x  = 0;
+    uint8_t       junk[3000] = { 0 };
+
+    PGAppendToRingBuffer(b, junk, 3000);
+    PGRingBufferConsume(b, 3000);
+    for(int i = 0; i < 2048; ++i) PGAppendByteToRingBuffer(b, (uint8_t)i);
+
+    double start = now();
+    for(long i = 0; i < ops; ++i) x += PGGetByteFromRingBuffer(b, (i & 2047));
+    report("C     get byte at offset", ops, (now() - start), x);
+    PGDiscardRingBuffer(b);
+}
+
+template <typename R>
+static void indexCpp(const char *name, R &r, long ops) {
+    unsigned long x = 0;
+
+    for(int i = 0; i < 3000; ++i) r.append((uint8_t)0);
+    r.consume(3000);
+    for(int i = 0; i < 2048; ++i) r.append((uint8_t)i);
+
+    double start = now();
+    for(long i = 0; i < ops; ++i) x += r[(size_t)(i & 2047)];
+    report(name, ops, (now() - start), x);
+}
+
+// 64-bit values from one thread to another.
+
+static void spscC(long ops) {
+    PGSPSCRingBuffer *b = PGCreateSPSCRingBuffer(8192);
+    unsigned long    x  = 0;
+
+    double      start = now();
+    std::thread p([&] {
+        for(uint64_t i = 0; i < (uint64_t)ops;) if(PGAppendToSPSCRingBuffer(b, &i, sizeof(i))) ++i; else std::this_thread::yield();
+    });
+    for(long n = 0; n < ops;) {
+        uint64_t v;
+        if(PGReadFromSPSCRingBuffer(b, &v, sizeof(v)) == sizeof(v)) {
+            x += v;
+            ++n;
+        }
+        else {
+            std::this_thread::yield();
+        }
+    }
+    p.join();
+    report("C     SPSC u64 (2 threads)", ops, (now() - start), x);
+    PGDiscardSPSCRingBuffer(b);
+}
+
+static void spscCpp(long ops) {
+    auto          r = std::make_unique<pg::RingBuffer<uint64_t, 1024, pg::NoGrowth, pg::SPSC>>();
+    unsigned long x = 0;
+
+    double      start = now();
+    std::thread p([&] {
+        for(uint64_t i = 0; i < (uint64_t)ops;) if(r->append(i)) ++i; else std::this_thread::yield();
+    });
+    for(long n = 0; n < ops;) {
+        uint64_t v;
+        if(r->read(v)) {
+            x += v;
+            ++n;
+        }
+        else {
+            std::this_thread::yield();
+        }
+    }
+    p.join();
+    report("C++   SPSC u64 (2 threads)", ops, (now() - start), x);
+}
+
+int main(int argc, const char *argv[]) {
+    long ops = (((argc > 1) ? atol(argv[1]) : 20) * 1000000L);
+
+    bytesC(ops);
+    {
+        pg::RingBuffer<uint8_t> r(4096);
+        bytesCpp("C++   append byte + read (dynamic)", r, ops);
+    }
+    {
+        auto r = std::make_unique<pg::RingBuffer<uint8_t, 4096>>();
+        bytesCpp("C++   append byte + read (fixed)", *r, ops);
+    }
+
+    indexC(ops);
+    {
+        pg::RingBuffer<uint8_t> r(4096);
+        indexCpp("C++   operator[] (dynamic)", r, ops);
+    }
+    {
+        auto r = std::make_unique<pg::RingBuffer<uint8_t, 4096>>();
+        indexCpp("C++   operator[] (fixed)", *r, ops);
+    }
+
+    spscC(ops / 4);
+    spscCpp(ops / 4);
+    return 0;
+}
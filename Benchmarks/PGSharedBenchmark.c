@@ -0,0 +1,213 @@
+//
+//  PGSharedBenchmark.c
+//  PGRingBuffer
+//
+//  Created by Galen Rhodes on 10/16/26.
+//  Copyright © 2020 Project Galen. All rights reserved.
+//
+//  Measures loopback throughput between two processes for several chunk sizes. A PGSharedRingBuffer, attached to
+//  by name in a forked consumer process, is compared against writing the same chunks to a Unix domain socketpair,
+//  which is what callers had to do before. The consumer checks every byte it receives.
+//
+//  Build: cmake -S . -B build && cmake --build build --target PGSharedBenchmark
+//  Usage: PGSharedBenchmark [MiB per run] [ring size in KiB]
+//
+
+#include "PGSharedRingBuffer.h"
+#include <errno.h>
+#include <limits.h>
+#include <sched.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <time.h>
+
+#define PG_MAX_CHUNK (64 * 1024)
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((double)ts.tv_sec + ((double)ts.tv_nsec / 1e9));
+}
+
+/*
+ * Byte `i` of the stream is always `(uint8_t)(i * 7)` so the consumer can check what it gets wherever the chunks
+ * happen to be split.
+ */
+static void fillChunk(uint8_t *chunk, long at, long length) {
+    for(long i = 0; i < length; ++i) chunk[i] = (uint8_t)((at + i) * 7);
+}
+
+static bool checkChunk(const uint8_t *chunk, long at, long length) {
+    for(long i = 0; i < length; ++i) if(chunk[i] != (uint8_t)((at + i) * 7)) return false;
+    return true;
+}
+
+static int sharedConsumer(const char *name, long total) {
+    PGSharedRingBuffer *buff = PGAttachSharedRingBuffer(name);
+    PGRingBufferSpan   span;
+    long               got   = 0;
+
+    if(buff == NULL) return 2;
+
+    while(got < total) {
+        if(PGPeekSpanFromSharedRingBuffer(buff, &span) == 0) {
+            sched_yield();
+            continue;
+        }
+        if(!checkChunk(span.bytes, got, span.length)) return 1;
+        got += PGSharedRingBufferConsume(buff, span.length);
+    }
+
+    PGDetachSharedRingBuffer(buff);
+    return 0;
+}
+
+/*
+ * Returns -1 without running anything if a chunk doesn't fit in the ring. The appends are all or nothing so the
+ * producer would wait for room forever.
+ */
+static double runShared(long chunkSize, long total, long ringSize) {
+    char    name[64];
+    uint8_t chunk[PG_MAX_CHUNK];
+    int     status;
+
+    snprintf(name, sizeof(name), "/PGSharedBenchmark.%ld", (long)getpid());
+    PGSharedRingBuffer *buff = PGCreateSharedRingBuffer(name, ringSize);
+    if(buff == NULL) {
+        perror("PGCreateSharedRingBuffer");
+        exit(1);
+    }
+    if(chunkSize > PGSharedRingBufferCapacity(buff)) {
+        PGDetachSharedRingBuffer(buff);
+        PGUnlinkSharedRingBuffer(name);
+        return -1;
+    }
+
+    double start = now();
+    pid_t  pid   = fork();
+
+    if(pid == 0) _exit(sharedConsumer(name, total));
+
+    for(long sent = 0; sent < total; sent += chunkSize) {
+        long length = (((total - sent) < chunkSize) ? (total - sent) : chunkSize);
+
+        fillChunk(chunk, sent, length);
+        while(!PGAppendToSharedRingBuffer(buff, chunk, length)) sched_yield();
+    }
+
+    waitpid(pid, &status, 0);
+    double secs = (now() - start);
+
+    PGDetachSharedRingBuffer(buff);
+    PGUnlinkSharedRingBuffer(name);
+    if(!WIFEXITED(status) || WEXITSTATUS(status)) {
+        fprintf(stderr, "shared consumer failed (%d)\n", status);
+        exit(1);
+    }
+    return secs;
+}
+
+static int socketConsumer(int fd, long total) {
+    uint8_t chunk[PG_MAX_CHUNK];
+    long    got = 0;
+
+    while(got < total) {
+        ssize_t r = read(fd, chunk, sizeof(chunk));
+
+        if(r <= 0) return 2;
+        if(!checkChunk(chunk, got, r)) return 1;
+        got += r;
+    }
+
+    return 0;
+}
+
+static double runSocket(long chunkSize, long total, long ringSize) {
+    uint8_t chunk[PG_MAX_CHUNK];
+    int     fds[2];
+    int     status;
+
+    if(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+        perror("socketpair");
+        exit(1);
+    }
+    // Give the socket the same amount of buffering as the ring.
+    int sz = (int)ringSize;
+    setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &sz, sizeof(sz));
+    setsockopt(fds[1], SOL_SOCKET, SO_RCVBUF, &sz, sizeof(sz));
+
+    double start = now();
+    pid_t  pid   = fork();
+
+    if(pid == 0) {
+        close(fds[0]);
+        _exit(socketConsumer(fds[1], total));
+    }
+    close(fds[1]);
+
+    for(long sent = 0; sent < total; sent += chunkSize) {
+        long length = (((total - sent) < chunkSize) ? (total - sent) : chunkSize);
+
+        fillChunk(chunk, sent, length);
+        for(long w = 0; w < length;) {
+            ssize_t r = write(fds[0], (chunk + w), (size_t)(length - w));
+            if(r < 0) {
+                perror("write");
+                exit(1);
+            }
+            w += r;
+        }
+    }
+
+    waitpid(pid, &status, 0);
+    double secs = (now() - start);
+
+    close(fds[0]);
+    if(!WIFEXITED(status) || WEXITSTATUS(status)) {
+        fprintf(stderr, "socket consumer failed (%d)\n", status);
+        exit(1);
+    }
+    return secs;
+}
+
+/*
+ * Parses a whole number from 1 to `max`. Returns zero if `a` isn't one.
+ */
+static long positiveArg(const char *a, long max) {
+    char *end = NULL;
+    long v;
+
+    errno = 0;
+    v     = strtol(a, &end, 10);
+    return (((errno == 0) && (end != a) && (*end == 0) && (v > 0) && (v <= max)) ? v : 0);
+}
+
+int main(int argc, const char *argv[]) {
+    long mib      = ((argc > 1) ? positiveArg(argv[1], (LONG_MAX >> 20)) : 256);
+    // The ring size is also used for the socket buffers, which take an int.
+    long kib      = ((argc > 2) ? positiveArg(argv[2], (INT_MAX >> 10)) : 1024);
+    long chunks[] = { 64, 512, 4096, 16384, PG_MAX_CHUNK };
+
+    if((argc > 3) || (mib == 0) || (kib == 0)) {
+        fprintf(stderr, "usage: %s [MiB per run] [ring size in KiB]\n", argv[0]);
+        return 2;
+    }
+
+    long total    = (mib * 1024 * 1024);
+    long ringSize = (kib * 1024);
+
+    for(size_t i = 0; i < (sizeof(chunks) / sizeof(chunks[0])); ++i) {
+        double shared = runShared(chunks[i], total, ringSize);
+
+        if(shared < 0) {
+            printf("chunk=%-7ld skipped, bigger than the ring\n", chunks[i]);
+            continue;
+        }
+
+        double sock = runSocket(chunks[i], total, ringSize);
+
+        printf("chunk=%-7ld shared %10.2f MB/s   socketpair %10.2f MB/s   %6.2fx\n", chunks[i], ((double)total / shared / 1e6), ((double)total / sock / 1e6), (sock / shared));
+    }
+
+    return 0;
+}
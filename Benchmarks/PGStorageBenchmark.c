@@ -0,0 +1,98 @@
+//
+//  PGStorageBenchmark.c
+//  PGRingBuffer
+//
+//  Created by Galen Rhodes on 10/16/26.
+//  Copyright © 2020 Project Galen. All rights reserved.
+//
+//  Measures sequential throughput through a large ring buffer for each kind of storage: the default allocator,
+//  cache line aligned, page aligned, and huge page backed. The first fill is reported separately because that is
+//  where the page faults happen. After that the ring is kept half full while fixed size chunks are appended and
+//  read back so every byte of the storage is streamed through many times.
+//
+//  Build: cmake -S . -B build && cmake --build build --target PGStorageBenchmark
+//  Usage: PGStorageBenchmark [ring size in MiB] [passes] [chunk size in KiB]
+//
+
+#include "PGRingBuffer.h"
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((double)ts.tv_sec + ((double)ts.tv_nsec / 1e9));
+}
+
+static void run(const char *name, int flags, long size, long passes, uint8_t *chunk, long chunkSize) {
+    PGRingBuffer *buff = PGCreateRingBufferWithFlags(size, flags);
+
+    if(buff == NULL) {
+        printf("%-8s could not be created\n", name);
+        return;
+    }
+
+    long half = (PGRingBufferCapacity(buff) / 2);
+
+    // First fill. This is where the pages get faulted in.
+    double start = now();
+    while((PGRingBufferCount(buff) + chunkSize) <= PGRingBufferCapacity(buff)) PGAppendToRingBuffer(buff, chunk, chunkSize);
+    double fill = (now() - start);
+    long   fb   = PGRingBufferCount(buff);
+
+    while(PGRingBufferCount(buff) > half) PGReadFromRingBuffer(buff, chunk, chunkSize);
+
+    long total = (passes * PGRingBufferCapacity(buff));
+    long moved = 0;
+
+    start = now();
+    while(moved < total) {
+        PGAppendToRingBuffer(buff, chunk, chunkSize);
+        moved += PGReadFromRingBuffer(buff, chunk, chunkSize);
+    }
+    double secs = (now() - start);
+
+    printf("%-8s size=%-10ld first fill %10.2f MB/s   steady %10.2f MB/s (append + read)   base=%p\n", name, buff->size, ((double)fb / fill / 1e6), ((double)moved / secs / 1e6), (void *)buff->buffer);
+    PGDiscardRingBuffer(buff);
+}
+
+/*
+ * Parses a whole number from 1 to `max`. Returns zero if `a` isn't one.
+ */
+static long positiveArg(const char *a, long max) {
+    char *end = NULL;
+    long v;
+
+    errno = 0;
+    v     = strtol(a, &end, 10);
+    return (((errno == 0) && (end != a) && (*end == 0) && (v > 0) && (v <= max)) ? v : 0);
+}
+
+int main(int argc, const char *argv[]) {
+    // Up to a TiB and a million passes so that the bytes moved can't overflow. The chunk has to fit in the half of
+    // the ring that is kept free.
+    long mib    = ((argc > 1) ? positiveArg(argv[1], (1L << 20)) : 256);
+    long passes = ((argc > 2) ? positiveArg(argv[2], (1L << 20)) : 8);
+    long kib    = ((argc > 3) ? positiveArg(argv[3], (mib * 512)) : 64);
+
+    if((argc > 4) || (mib == 0) || (passes == 0) || (kib == 0)) {
+        fprintf(stderr, "usage: %s [ring size in MiB] [passes] [chunk size in KiB]\n", argv[0]);
+        return 2;
+    }
+
+    long    size      = (mib * 1024 * 1024);
+    long    chunkSize = (kib * 1024);
+    uint8_t *chunk    = malloc((size_t)chunkSize);
+
+    if(chunk == NULL) return 1;
+    memset(chunk, 0x5a, (size_t)chunkSize);
+
+    run("default", PG_RINGBUFFER_DEFAULT, size, passes, chunk, chunkSize);
+    run("cache", PG_RINGBUFFER_CACHE_ALIGNED, size, passes, chunk, chunkSize);
+    run("page", PG_RINGBUFFER_PAGE_ALIGNED, size, passes, chunk, chunkSize);
+    run("huge", PG_RINGBUFFER_HUGEPAGES, size, passes, chunk, chunkSize);
+
+    free(chunk);
+    return 0;
+}
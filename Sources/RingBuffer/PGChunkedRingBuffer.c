@@ -0,0 +1,301 @@
+//
+//  PGChunkedRingBuffer.c
+//  PGRingBuffer
+//
+//  Created by Galen Rhodes on 10/16/26.
+//  Copyright © 2020 Project Galen. All rights reserved.
+//
+
+#include "include/PGChunkedRingBuffer.h"
+#include "PGRingBufferCommon.h"
+#include <errno.h>
+
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "OCUnusedGlobalDeclarationInspection"
+
+#define PG_CHUNK_MIN_SIZE  (64)
+#define PG_CHUNK_MIN_SLOTS (8)
+
+/*
+ * `chunks` is itself a ring, of `slots` chunk pointers, and the `allocated` chunks always occupy the slots from
+ * `first` onwards. The bytes start `head` bytes into the first chunk. Byte `i` is therefore in chunk
+ * ((head + i) >> shift) counting from `first`. The chunks past the one holding the last byte are spares. When the
+ * first chunk has been read it becomes a spare simply by moving it from the front of the allocated slots to the
+ * back, so neither the bytes nor the chunks ever have to be shuffled. Only the (small) list of pointers is ever
+ * reallocated, and only when it runs out of slots.
+ */
+struct _st_pg_chunked_ringbuffer_ {
+    long    chunkSize;
+    long    chunkMask;
+    int     shift;
+    long    maxSpare;
+    uint8_t **chunks;
+    long    slots;
+    long    first;
+    long    allocated;
+    long    head;
+    long    count;
+
+    const PGRingBufferAllocator *allocator;
+};
+
+#define pgAlloc(b, s)   ((b)->allocator->alloc((b)->allocator->context, (s)))
+#define pgFree(b, p, s) ((b)->allocator->free((b)->allocator->context, (p), (s)))
+
+/*
+ * The chunk holding the byte at position `at`, counting from the start of the first chunk.
+ */
+PG_ALWAYS_INLINE uint8_t *pgChunkAt(const PGChunkedRingBuffer *buff, long at) {
+    return buff->chunks[((buff->first + (at >> buff->shift)) & (buff->slots - 1))];
+}
+
+/*
+ * The number of chunks holding bytes. An empty buffer still counts the first one.
+ */
+PG_ALWAYS_INLINE long pgUsed(const PGChunkedRingBuffer *buff) {
+    return (buff->count ? (((buff->head + buff->count - 1) >> buff->shift) + 1) : 1);
+}
+
+/*
+ * Doubles the list of chunk pointers, straightening it out as it goes.
+ */
+static bool pgGrowSlots(PGChunkedRingBuffer *buff) {
+    long    nslots = (buff->slots * 2);
+    uint8_t **nc   = pgAlloc(buff, (long)(nslots * sizeof(uint8_t *)));
+
+    if(nc == NULL) return false;
+
+    for(long i = 0; i < buff->allocated; ++i) nc[i] = buff->chunks[((buff->first + i) & (buff->slots - 1))];
+    pgFree(buff, buff->chunks, (long)(buff->slots * sizeof(uint8_t *)));
+    buff->chunks = nc;
+    buff->slots  = nslots;
+    buff->first  = 0;
+    return true;
+}
+
+/*
+ * Makes sure there are chunks for everything up to position `end`. Any chunks allocated before running out of
+ * memory are kept as spares.
+ */
+static bool pgEnsureChunks(PGChunkedRingBuffer *buff, long end) {
+    long needed = ((end + buff->chunkMask) >> buff->shift);
+
+    while(buff->allocated < needed) {
+        if((buff->allocated == buff->slots) && !pgGrowSlots(buff)) return false;
+
+        uint8_t *c = pgAlloc(buff, buff->chunkSize);
+        if(c == NULL) return false;
+
+        buff->chunks[((buff->first + buff->allocated) & (buff->slots - 1))] = c;
+        buff->allocated++;
+    }
+
+    return true;
+}
+
+/*
+ * Copies `length` bytes starting at position `at` out of the chunks.
+ */
+static void pgCopyOut(const PGChunkedRingBuffer *buff, long at, uint8_t *dest, long length) {
+    while(length > 0) {
+        long o = (at & buff->chunkMask);
+        long l = pg_Min(length, (buff->chunkSize - o));
+
+        memcpy(dest, (pgChunkAt(buff, at) + o), (size_t)l);
+        dest += l;
+        at += l;
+        length -= l;
+    }
+}
+
+PG_ALWAYS_INLINE long pgIndexOf(const PGChunkedRingBuffer *buff, long offset) {
+    // Only divide when we really have to.
+    if((offset < 0) || (offset >= buff->count)) offset %= buff->count;
+    if(offset < 0) offset += buff->count;
+    return (buff->head + offset);
+}
+
+PGChunkedRingBuffer *PGCreateChunkedRingBuffer(long chunkSize, long maxSpareChunks) {
+    return PGCreateChunkedRingBufferWithAllocator(chunkSize, maxSpareChunks, NULL);
+}
+
+PGChunkedRingBuffer *PGCreateChunkedRingBufferWithAllocator(long chunkSize, long maxSpareChunks, const PGRingBufferAllocator *allocator) {
+    if(allocator == NULL) allocator = &_PGDefaultRingBufferAllocator;
+    if(chunkSize <= 0) chunkSize = PG_CHUNKED_DEFAULT_CHUNK_SIZE;
+    if((chunkSize = pgNextPow2(pg_Max(chunkSize, PG_CHUNK_MIN_SIZE))) == 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    PGChunkedRingBuffer *buff = allocator->alloc(allocator->context, sizeof(PGChunkedRingBuffer));
+
+    if(buff) {
+        int shift = 0;
+        while((1L << shift) < chunkSize) ++shift;
+
+        buff->chunkSize = chunkSize;
+        buff->chunkMask = (buff->chunkSize - 1);
+        buff->shift     = shift;
+        buff->maxSpare  = pg_Max(0, maxSpareChunks);
+        buff->slots     = PG_CHUNK_MIN_SLOTS;
+        buff->first     = 0;
+        buff->allocated = 0;
+        buff->head      = 0;
+        buff->count     = 0;
+        buff->allocator = allocator;
+        buff->chunks    = pgAlloc(buff, (long)(buff->slots * sizeof(uint8_t *)));
+
+        // Always keep at least one chunk so that an empty buffer doesn't have to allocate.
+        if(buff->chunks && pgEnsureChunks(buff, 1)) return buff;
+        PGDiscardChunkedRingBuffer(buff);
+        buff = NULL;
+    }
+
+    return buff;
+}
+
+void PGDiscardChunkedRingBuffer(PGChunkedRingBuffer *buff) {
+    if(buff) {
+        if(buff->chunks) {
+            for(long i = 0; i < buff->allocated; ++i) pgFree(buff, buff->chunks[((buff->first + i) & (buff->slots - 1))], buff->chunkSize);
+            pgFree(buff, buff->chunks, (long)(buff->slots * sizeof(uint8_t *)));
+        }
+        pgFree(buff, buff, sizeof(PGChunkedRingBuffer));
+    }
+}
+
+bool PGAppendToChunkedRingBuffer(PGChunkedRingBuffer *buff, const void *src, long length) {
+    if(src && (length > 0)) {
+        long at = (buff->head + buff->count);
+
+        if(!pgEnsureChunks(buff, (at + length))) return false;
+
+        for(long l; length > 0; length -= l) {
+            long o = (at & buff->chunkMask);
+            l = pg_Min(length, (buff->chunkSize - o));
+
+            memcpy((pgChunkAt(buff, at) + o), src, (size_t)l);
+            src += l;
+            at += l;
+            buff->count += l;
+        }
+    }
+
+    return true;
+}
+
+bool PGAppendByteToChunkedRingBuffer(PGChunkedRingBuffer *buff, uint8_t byte) {
+    long at = (buff->head + buff->count);
+
+    if(__builtin_expect(((at >> buff->shift) >= buff->allocated), 0) && !pgEnsureChunks(buff, (at + 1))) return false;
+
+    pgChunkAt(buff, at)[(at & buff->chunkMask)] = byte;
+    buff->count++;
+    return true;
+}
+
+long PGPeekFromChunkedRingBuffer(const PGChunkedRingBuffer *buff, void *dest, long maxLength) {
+    if((dest == NULL) || (maxLength <= 0)) return 0;
+
+    long cc = pg_Min(maxLength, buff->count);
+    pgCopyOut(buff, buff->head, dest, cc);
+    return cc;
+}
+
+long PGReadFromChunkedRingBuffer(PGChunkedRingBuffer *buff, void *dest, long maxLength) {
+    long cc = PGPeekFromChunkedRingBuffer(buff, dest, maxLength);
+    PGChunkedRingBufferConsume(buff, cc);
+    return cc;
+}
+
+void PGChunkedRingBufferConsume(PGChunkedRingBuffer *buff, long length) {
+    if(length > 0) {
+        long cc = pg_Min(length, buff->count);
+        long m  = (buff->slots - 1);
+        long k;
+        long spare;
+
+        buff->count -= cc;
+        buff->head += cc;
+        k = (buff->head >> buff->shift);
+        buff->head &= buff->chunkMask;
+        // Once it's empty start again at the top of the chunk rather than wherever the head ended up.
+        if(buff->count == 0) buff->head = 0;
+
+        // Each emptied chunk goes to the back as a spare, or is freed if there are enough spares already. If the
+        // bytes ended exactly at the end of the last chunk then `spare` starts at -1 so that one is kept.
+        spare = (buff->allocated - k - pgUsed(buff));
+        for(long i = 0; i < k; ++i) {
+            uint8_t *c = buff->chunks[buff->first];
+
+            buff->first = ((buff->first + 1) & m);
+            if(spare < buff->maxSpare) {
+                buff->chunks[((buff->first + buff->allocated - 1) & m)] = c;
+                spare++;
+            }
+            else {
+                pgFree(buff, c, buff->chunkSize);
+                buff->allocated--;
+            }
+        }
+    }
+}
+
+uint8_t PGGetByteFromChunkedRingBuffer(const PGChunkedRingBuffer *buff, long offset) {
+    if(buff->count == 0) return 0;
+
+    long at = pgIndexOf(buff, offset);
+    return pgChunkAt(buff, at)[(at & buff->chunkMask)];
+}
+
+void PGSetByteOnChunkedRingBuffer(PGChunkedRingBuffer *buff, long index, uint8_t byte) {
+    if(buff->count) {
+        long at = pgIndexOf(buff, index);
+        pgChunkAt(buff, at)[(at & buff->chunkMask)] = byte;
+    }
+}
+
+long PGGetChunkedRingBufferSpans(const PGChunkedRingBuffer *buff, PGRingBufferSpan *spans, long maxSpans) {
+    if(buff->count == 0) return 0;
+
+    long at = buff->head;
+    long n  = (((buff->head + buff->count - 1) >> buff->shift) + 1);
+
+    for(long i = 0, left = buff->count; (i < pg_Min(n, maxSpans)); ++i) {
+        long o = (at & buff->chunkMask);
+        long l = pg_Min(left, (buff->chunkSize - o));
+
+        spans[i].bytes  = (pgChunkAt(buff, at) + o);
+        spans[i].length = l;
+        at += l;
+        left -= l;
+    }
+
+    return n;
+}
+
+void PGClearChunkedRingBuffer(PGChunkedRingBuffer *buff, bool keepCapacity) {
+    buff->head  = 0;
+    buff->count = 0;
+
+    if(!keepCapacity) {
+        while(buff->allocated > 1) {
+            buff->allocated--;
+            pgFree(buff, buff->chunks[((buff->first + buff->allocated) & (buff->slots - 1))], buff->chunkSize);
+        }
+    }
+}
+
+long PGChunkedRingBufferChunkSize(const PGChunkedRingBuffer *buff) {
+    return buff->chunkSize;
+}
+
+long PGChunkedRingBufferCapacity(const PGChunkedRingBuffer *buff) {
+    return ((buff->allocated * buff->chunkSize) - buff->head);
+}
+
+long PGChunkedRingBufferCount(const PGChunkedRingBuffer *buff) {
+    return buff->count;
+}
+
+#pragma clang diagnostic pop
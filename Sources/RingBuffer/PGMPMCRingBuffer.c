@@ -0,0 +1,200 @@
+//
+//  PGMPMCRingBuffer.c
+//  PGRingBuffer
+//
+//  Created by Galen Rhodes on 10/16/26.
+//  Copyright © 2020 Project Galen. All rights reserved.
+//
+
+#include "include/PGMPMCRingBuffer.h"
+#include "PGRingBufferCommon.h"
+#include <errno.h>
+#include <stdatomic.h>
+
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "OCUnusedGlobalDeclarationInspection"
+
+#define PG_DEFAULT_CELL_SIZE (64)
+#define PG_MPMC_MAX_SIZE     (LONG_MAX / 4)
+
+/*
+ * This is Dmitry Vyukov's bounded MPMC queue extended so that a record can claim several consecutive cells with
+ * a single CAS. Cell `i` is free for position `p` when its sequence is `p`, and holds data for position `p` when
+ * its sequence is `p + 1`. Consumers give cells back by setting the sequence to `p + count`.
+ *
+ * The sequences live apart from the data so that a record's bytes are contiguous (unless it wraps past the end
+ * of the storage).
+ */
+typedef struct _st_pg_mpmc_cell_ {
+    _Atomic long seq;
+    _Atomic long length;
+}               PGMPMCCell;
+
+struct _st_pg_mpmc_ringbuffer_ {
+    long       count;
+    long       mask;
+    long       cellSize;
+    PGMPMCCell *cells;
+    uint8_t    *buffer;
+
+    PG_CACHE_ALIGNED _Atomic long enqueuePos;
+    PG_CACHE_ALIGNED _Atomic long dequeuePos;
+};
+
+#define pgLoad(a, o)     atomic_load_explicit(&(a), (o))
+#define pgStore(a, v, o) atomic_store_explicit(&(a), (v), (o))
+#define pgCAS(a, e, v)   atomic_compare_exchange_weak_explicit(&(a), (e), (v), memory_order_relaxed, memory_order_relaxed)
+#define pgCellsFor(b, l) (((l) <= (b)->cellSize) ? 1 : (((l) + (b)->cellSize - 1) / (b)->cellSize))
+
+PGMPMCRingBuffer *PGCreateMPMCRingBuffer(long capacity, long cellSize) {
+    PGMPMCRingBuffer *buff = NULL;
+
+    // With both of these bounded neither the number of cells nor the size of the storage can overflow.
+    if((capacity > PG_MPMC_MAX_SIZE) || (cellSize > PG_MPMC_MAX_SIZE)) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    if(posix_memalign((void **)&buff, PG_CACHE_LINE_SIZE, sizeof(PGMPMCRingBuffer)) == 0) {
+        long cs = ((cellSize <= 0) ? PG_DEFAULT_CELL_SIZE : (((cellSize + 7) / 8) * 8));
+        long cc = 2;
+
+        while(cc < ((capacity + cs - 1) / cs)) cc <<= 1;
+
+        buff->count    = cc;
+        buff->mask     = (cc - 1);
+        buff->cellSize = cs;
+        buff->cells    = malloc((size_t)cc * sizeof(PGMPMCCell));
+        buff->buffer   = malloc((size_t)(cc * cs));
+
+        if(buff->cells && buff->buffer) {
+            for(long i = 0; i < cc; ++i) {
+                atomic_init(&buff->cells[i].seq, i);
+                atomic_init(&buff->cells[i].length, 0);
+            }
+            atomic_init(&buff->enqueuePos, 0);
+            atomic_init(&buff->dequeuePos, 0);
+            return buff;
+        }
+
+        free(buff->cells);
+        free(buff->buffer);
+        free(buff);
+    }
+
+    return NULL;
+}
+
+void PGDiscardMPMCRingBuffer(PGMPMCRingBuffer *buff) {
+    if(buff) {
+        free(buff->cells);
+        free(buff->buffer);
+        free(buff);
+    }
+}
+
+/*
+ * Returns zero if all `n` cells starting at `pos` are free, less than zero if the buffer is full, and greater
+ * than zero if another producer got there first.
+ */
+PG_ALWAYS_INLINE long pgCellsFree(PGMPMCRingBuffer *buff, long pos, long n) {
+    for(long i = 0; i < n; ++i) {
+        long dif = (pgLoad(buff->cells[(pos + i) & buff->mask].seq, memory_order_acquire) - (pos + i));
+        if(dif) return dif;
+    }
+    return 0;
+}
+
+bool PGAppendRecordToMPMCRingBuffer(PGMPMCRingBuffer *buff, const void *src, long length) {
+    if((length < 0) || ((length > 0) && (src == NULL)) || (length > PGMPMCRingBufferMaxRecordLength(buff))) return false;
+
+    long n   = pgCellsFor(buff, length);
+    long pos = pgLoad(buff->enqueuePos, memory_order_relaxed);
+
+    for(;;) {
+        long dif = pgCellsFree(buff, pos, n);
+
+        if(dif == 0) {
+            if(pgCAS(buff->enqueuePos, &pos, (pos + n))) break;
+        }
+        else if(dif < 0) {
+            return false;
+        }
+        else {
+            pos = pgLoad(buff->enqueuePos, memory_order_relaxed);
+        }
+    }
+
+    long idx = (pos & buff->mask);
+    long off = (idx * buff->cellSize);
+    long l   = pg_Min(length, ((buff->count * buff->cellSize) - off));
+
+    PGMemCpy((buff->buffer + off), src, l);
+    PGMemCpy(buff->buffer, (src + l), (length - l));
+    pgStore(buff->cells[idx].length, length, memory_order_relaxed);
+
+    // Publish the first cell last so that a consumer that sees it also sees the rest.
+    for(long i = (n - 1); i >= 0; --i) pgStore(buff->cells[(pos + i) & buff->mask].seq, (pos + i + 1), memory_order_release);
+
+    return true;
+}
+
+bool PGReadRecordFromMPMCRingBuffer(PGMPMCRingBuffer *buff, void *dest, long maxLength, long *length) {
+    long pos = pgLoad(buff->dequeuePos, memory_order_relaxed);
+    long len;
+    long n;
+
+    if(length) *length = 0;
+
+    for(;;) {
+        PGMPMCCell *cell = &buff->cells[pos & buff->mask];
+        long       dif   = (pgLoad(cell->seq, memory_order_acquire) - (pos + 1));
+
+        if(dif == 0) {
+            // This might be stale but if it is then the CAS below will fail.
+            len = pgLoad(cell->length, memory_order_relaxed);
+
+            if(len > maxLength) {
+                long npos = pgLoad(buff->dequeuePos, memory_order_relaxed);
+
+                if(npos == pos) {
+                    if(length) *length = len;
+                    return false;
+                }
+
+                pos = npos;
+            }
+            else {
+                n = pgCellsFor(buff, len);
+                if(pgCAS(buff->dequeuePos, &pos, (pos + n))) break;
+            }
+        }
+        else if(dif < 0) {
+            return false;
+        }
+        else {
+            pos = pgLoad(buff->dequeuePos, memory_order_relaxed);
+        }
+    }
+
+    long off = ((pos & buff->mask) * buff->cellSize);
+    long l   = pg_Min(len, ((buff->count * buff->cellSize) - off));
+
+    PGMemCpy(dest, (buff->buffer + off), l);
+    PGMemCpy((dest + l), buff->buffer, (len - l));
+
+    for(long i = 0; i < n; ++i) pgStore(buff->cells[(pos + i) & buff->mask].seq, (pos + i + buff->count), memory_order_release);
+
+    if(length) *length = len;
+    return true;
+}
+
+long PGMPMCRingBufferCapacity(const PGMPMCRingBuffer *buff) {
+    return (buff->count * buff->cellSize);
+}
+
+long PGMPMCRingBufferMaxRecordLength(const PGMPMCRingBuffer *buff) {
+    return (buff->count * buff->cellSize);
+}
+
+#pragma clang diagnostic pop
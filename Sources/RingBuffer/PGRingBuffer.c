@@ -6,89 +6,457 @@
 //  Copyright © 2020 Project Galen. All rights reserved.
 //
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+    #define _GNU_SOURCE
+#endif
+
 #include "include/PGRingBuffer.h"
+#include "PGRingBufferCommon.h"
+
+#include <errno.h>
+#include <limits.h>
+
+// The out-of-line versions of the functions that the header has inline fast paths for are defined here.
+#undef PGRingBufferCount
+#undef PGRingBufferRemaining
+#undef PGAppendByteToRingBuffer
+#undef PGPrependByteToRingBuffer
+#undef PGGetByteFromRingBuffer
+#undef PGSetByteOnRingBuffer
+
+#include <sys/mman.h>
+
+#if defined(__linux__) && defined(MFD_CLOEXEC)
+    #define PG_HAS_MIRROR 1
+#else
+    #define PG_HAS_MIRROR 0
+#endif
+
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    #define PG_HAS_HUGEPAGES 1
+#else
+    #define PG_HAS_HUGEPAGES 0
+#endif
 
 #pragma clang diagnostic push
 #pragma ide diagnostic ignored "OCUnusedGlobalDeclarationInspection"
-#define PG_ALWAYS_INLINE __attribute__((__always_inline__))
 
-typedef void (*PGFunc)(void *, long, int);
+#define PG_MIN_SIZE            (5)
+#define PG_MAX_SIZE            ((LONG_MAX / 4) + 1)
+#define PG_ROTATE_STACK        (256)
 
-#define RBCC(b)                (((b)->head <= (b)->tail) ? ((b)->tail - (b)->head) : (((b)->size - (b)->head) + (b)->tail))
-#define pg_Min(x, y)           (((x) < (y)) ? (x) : (y))
-#define pgIncHead(b, l)        ((l > 0) ? ((b)->head = (((b)->head + (l)) % (b)->size)) : (b)->head)
-#define pgIncTail(b, l)        ((b)->tail = (((b)->tail + (l)) % (b)->size))
-#define pgDecHead(b, l)        ((b)->head = ((((b)->head < (l)) ? ((b)->size + (b)->head) : (b)->head) - (l)))
+#define pgIsPow2(b)            ((b)->mask != 0)
+#define pgWrap(b, i)           (pgIsPow2(b) ? ((i) & (b)->mask) : ((i) % (b)->size))
+#define RBCC(b)                (pgIsPow2(b) ? (((b)->tail - (b)->head) & (b)->mask) : (((b)->head <= (b)->tail) ? ((b)->tail - (b)->head) : (((b)->size - (b)->head) + (b)->tail)))
+#define pgIncHead(b, l)        ((l > 0) ? ((b)->head = pgWrap((b), ((b)->head + (l)))) : (b)->head)
+#define pgIncTail(b, l)        ((b)->tail = pgWrap((b), ((b)->tail + (l))))
+#define pgDecHead(b, l)        ((b)->head = (pgIsPow2(b) ? (((b)->head - (l)) & (b)->mask) : ((((b)->head < (l)) ? ((b)->size + (b)->head) : (b)->head) - (l))))
 #define pgReadFrom(b, s, d, l) PGMemCpy((d), ((b)->buffer + (s)), (l))
-#define indexOf(b, o)          (((b)->head == (b)->tail) ? (-1) : (((b)->head < (b)->tail) ? (((b)->head + ((o) % RBCC((b))))) : (((b)->head + ((o) % RBCC((b)))) % (b)->size)))
+#define pgMaskFor(f, s)        (((f) & PG_RINGBUFFER_POW2) ? ((s) - 1) : 0)
+#define pgIsMirrored(b)        ((b)->fd >= 0)
+#define pgContig(b, i)         (pgIsMirrored(b) ? (b)->size : ((b)->size - (i)))
+#define pgAlloc(b, s)          ((b)->allocator->alloc((b)->allocator->context, (s)))
+#define pgRealloc(b, p, o, n)  ((b)->allocator->realloc((b)->allocator->context, (p), (o), (n)))
+#define pgFree(b, p, s)        ((b)->allocator->free((b)->allocator->context, (p), (s)))
+
+/*
+ * The counters cost nothing unless PG_RINGBUFFER_STATS is turned on. The arguments are not evaluated when it's
+ * off so they must not have side effects.
+ */
+#if PG_RINGBUFFER_STATS
+    #define pgStat(b, f, n)    ((b)->stats.f += (n))
+    #define pgStatWrap(b, l)   ((b)->stats.wrapCopies += ((l) > 0))
+    #define pgStatPeak(b)      pgUpdatePeak(b)
+#else
+    #define pgStat(b, f, n)    ((void)0)
+    #define pgStatWrap(b, l)   ((void)0)
+    #define pgStatPeak(b)      ((void)0)
+#endif
+
+/*
+ * Swaps in place over the one or two live segments. If the first segment doesn't end on a word boundary then the
+ * word that straddles the wrap point is gathered into a temporary, swapped, and scattered back.
+ */
+PG_ALWAYS_INLINE long _PGSwapRingBufferEndian(PGRingBuffer *buff, long bytesPerWord, int alt) {
+    PGRingBufferSpan spans[2];
+    long             ws = (PGPeekSpansFromRingBuffer(buff, spans) / bytesPerWord);
+
+    if(ws) {
+        long length = (ws * bytesPerWord);
+        long l1     = pg_Min(length, spans[0].length);
+        long r      = (l1 % bytesPerWord);
+
+        _PGSwap(spans[0].bytes, (l1 - r), bytesPerWord, alt);
+
+        if(l1 < length) {
+            long s = 0;
+
+            if(r) {
+                uint8_t word[8];
+
+                s = (bytesPerWord - r);
+                memcpy(word, (spans[0].bytes + l1 - r), (size_t)r);
+                memcpy((word + r), spans[1].bytes, (size_t)s);
+                _PGSwap(word, bytesPerWord, bytesPerWord, alt);
+                memcpy((spans[0].bytes + l1 - r), word, (size_t)r);
+                memcpy(spans[1].bytes, (word + r), (size_t)s);
+            }
+
+            _PGSwap((spans[1].bytes + s), (length - l1 - s), bytesPerWord, alt);
+        }
+    }
+
+    return ws;
+}
 
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wunused-parameter"
 
-void _PGSwap16(void *words, long length, int alt) {
-    long ws = (length / 2);
+static void *pgDefaultAlloc(void *context, long size) {
+    return malloc((size_t)size);
+}
 
-    if(ws) {
-        uint16_t *buff = words;
-        for(long i     = 0; i < ws; words++) {
-            uint16_t w = buff[i];
-            buff[i] = ((uint16_t)((w & 0xff00) >> 8) | (uint16_t)((w & 0x00ff) << 8));
+static void *pgDefaultRealloc(void *context, void *ptr, long oldSize, long newSize) {
+    return realloc(ptr, (size_t)newSize);
+}
+
+static void pgDefaultFree(void *context, void *ptr, long size) {
+    free(ptr);
+}
+
+#pragma clang diagnostic pop
+
+const PGRingBufferAllocator _PGDefaultRingBufferAllocator = { pgDefaultAlloc, pgDefaultRealloc, pgDefaultFree, NULL };
+
+#if PG_RINGBUFFER_STATS
+
+PG_ALWAYS_INLINE void pgUpdatePeak(PGRingBuffer *buff) {
+    long cc = RBCC(buff);
+    if(cc > buff->stats.peakCount) buff->stats.peakCount = cc;
+}
+
+#endif
+
+PG_ALWAYS_INLINE long pgIndexOf(const PGRingBuffer *buff, long offset) {
+    long cc = RBCC(buff);
+    if(cc == 0) return -1;
+    // Only divide when we really have to.
+    if((offset < 0) || (offset >= cc)) offset %= cc;
+    return pgWrap(buff, (buff->head + offset));
+}
+
+PG_ALWAYS_INLINE long pgRead(PGRingBuffer *buff, uint8_t *dest, long d) {
+    pgReadFrom(buff, buff->head, dest, d);
+    pgIncHead(buff, d);
+    return d;
+}
+
+/*
+ * Called after bytes are taken out of the buffer. Shrinks the buffer once it has been found under used enough
+ * times in a row. Any read that finds it above the watermark starts the count over again.
+ */
+PG_ALWAYS_INLINE void pgCheckUsage(PGRingBuffer *buff) {
+    if((buff->policy.shrinkAfter > 0) && (buff->size > buff->initSize)) {
+        if(RBCC(buff) < (long)((double)buff->size * buff->policy.shrinkWatermark)) {
+            if(++buff->underUsed >= buff->policy.shrinkAfter) PGShrinkRingBuffer(buff);
+        }
+        else {
+            buff->underUsed = 0;
         }
     }
 }
 
-#pragma clang diagnostic pop
+static long pgPageSize(void) {
+    static long ps = 0;
+    if(ps == 0) ps = sysconf(_SC_PAGESIZE);
+    return ps;
+}
+
+PG_ALWAYS_INLINE long pgRoundToPage(long size) {
+    long ps = pgPageSize();
+    return (((size + ps - 1) / ps) * ps);
+}
+
+/*
+ * Heap storage comes in three kinds depending on the creation flags and the size. Which kind a buffer is using
+ * can always be worked out from those two things so it isn't stored anywhere. Mirrored storage is separate and
+ * is handled by the pgMirror functions.
+ */
+#define PG_STORAGE_ALLOCATOR (0)
+#define PG_STORAGE_ALIGNED   (1)
+#define PG_STORAGE_HUGE      (2)
+
+PG_ALWAYS_INLINE int pgStorageKind(int flags, long size) {
+    if((flags & PG_RINGBUFFER_HUGEPAGES) && (size >= PG_RINGBUFFER_HUGEPAGE_MIN_SIZE)) return PG_STORAGE_HUGE;
+    if(flags & (PG_RINGBUFFER_CACHE_ALIGNED | PG_RINGBUFFER_PAGE_ALIGNED | PG_RINGBUFFER_HUGEPAGES)) return PG_STORAGE_ALIGNED;
+    return PG_STORAGE_ALLOCATOR;
+}
 
-PG_ALWAYS_INLINE uint64_t zaphod(uint64_t w, int i) {
-    switch(i) {
-        case 1: return (((w & 0xffffffff00000000) >> 32) | ((w & 0x00000000ffffffff) << 32));
-        case 2: return (((w & 0xffff000000000000) >> 48) | ((w & 0x0000ffff00000000) >> 16) | ((w & 0x00000000ffff0000) << 16) | ((w & 0x000000000000ffff) << 48));
-        default: return ((w >> 56) | ((w >> 40) & 0xff00) | ((w >> 24) & 0xff0000) | ((w >> 8) & 0xff000000) | ((w & 0xff000000) << 8) | ((w & 0xff0000) << 24) | ((w & 0xff00) << 40) | (w << 56));
+#if PG_HAS_HUGEPAGES
+
+#define PG_HUGEPAGE_SIZE (2L * 1024 * 1024)
+
+PG_ALWAYS_INLINE long pgHugeLength(long size) {
+    return (((size + PG_HUGEPAGE_SIZE - 1) / PG_HUGEPAGE_SIZE) * PG_HUGEPAGE_SIZE);
+}
+
+/*
+ * Try for pre-reserved huge pages first. Those usually aren't configured so fall back to asking for transparent
+ * huge pages on a mapping that's aligned to a huge page boundary. Either way it's unmapped the same way.
+ */
+static uint8_t *pgHugeMap(long size) {
+    size_t len = (size_t)pgHugeLength(size);
+
+#if defined(MAP_HUGETLB) && defined(MAP_HUGE_2MB)
+    uint8_t *b = mmap(NULL, len, (PROT_READ | PROT_WRITE), (MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_HUGE_2MB), -1, 0);
+    if(b != MAP_FAILED) return b;
+#endif
+
+    uint8_t *base = mmap(NULL, (len + PG_HUGEPAGE_SIZE), (PROT_READ | PROT_WRITE), (MAP_PRIVATE | MAP_ANONYMOUS), -1, 0);
+    if(base == MAP_FAILED) return NULL;
+
+    uint8_t *a    = (uint8_t *)((((uintptr_t)base) + PG_HUGEPAGE_SIZE - 1) & ~((uintptr_t)PG_HUGEPAGE_SIZE - 1));
+    size_t  front = (size_t)(a - base);
+
+    if(front) munmap(base, front);
+    munmap((a + len), (PG_HUGEPAGE_SIZE - front));
+    madvise(a, len, MADV_HUGEPAGE);
+    return a;
+}
+
+#endif
+
+/*
+ * Allocates storage of the right kind for `size` bytes.
+ */
+static uint8_t *pgStorageAlloc(PGRingBuffer *buff, long size) {
+    void *b = NULL;
+
+    switch(pgStorageKind(buff->flags, size)) {
+#if PG_HAS_HUGEPAGES
+        case PG_STORAGE_HUGE:
+            b = pgHugeMap(size);
+            break;
+#else
+        case PG_STORAGE_HUGE:
+#endif
+        case PG_STORAGE_ALIGNED: {
+            long a = ((buff->flags & (PG_RINGBUFFER_PAGE_ALIGNED | PG_RINGBUFFER_HUGEPAGES)) ? pgPageSize() : PG_CACHE_LINE_SIZE);
+            if(posix_memalign(&b, (size_t)a, (size_t)size) != 0) b = NULL;
+            break;
+        }
+        default:
+            b = pgAlloc(buff, size);
+            break;
+    }
+
+    if(b == NULL) pgStat(buff, failedAllocations, 1);
+    return b;
+}
+
+static void pgStorageFree(PGRingBuffer *buff, uint8_t *b, long size) {
+    switch(pgStorageKind(buff->flags, size)) {
+#if PG_HAS_HUGEPAGES
+        case PG_STORAGE_HUGE:
+            munmap(b, (size_t)pgHugeLength(size));
+            break;
+#else
+        case PG_STORAGE_HUGE:
+#endif
+        case PG_STORAGE_ALIGNED:
+            free(b);
+            break;
+        default:
+            pgFree(buff, b, size);
+            break;
     }
 }
 
-void _PGSwap32(void *words, long length, int alt) {
-    long ws = (length / 4);
-    if(ws) {
-        uint32_t *buff = words;
-        for(long i     = 0; i < ws; i++) {
-            uint32_t w = buff[i];
-            buff[i] = (alt ? (((w & 0xffff0000) >> 16) | ((w & 0x0000ffff) << 16)) : (((w & 0xff000000) >> 24) | ((w & 0x00ff0000) >> 8) | ((w & 0x0000ff00) << 8) | ((w & 0x000000ff) << 24)));
+/*
+ * Like realloc(3) but keeps the storage the right kind for the new size. The first `min(osize, nsize)` bytes
+ * are kept. Returns NULL, leaving the old storage alone, if the new storage can't be allocated.
+ */
+static uint8_t *pgStorageRealloc(PGRingBuffer *buff, long osize, long nsize) {
+    int ok = pgStorageKind(buff->flags, osize);
+    int nk = pgStorageKind(buff->flags, nsize);
+
+    if(ok == nk) {
+        if(ok == PG_STORAGE_ALLOCATOR) {
+            uint8_t *b = pgRealloc(buff, buff->buffer, osize, nsize);
+            if(b == NULL) pgStat(buff, failedAllocations, 1);
+            return b;
         }
+#if PG_HAS_HUGEPAGES
+        if(ok == PG_STORAGE_HUGE) {
+            size_t olen = (size_t)pgHugeLength(osize);
+            size_t nlen = (size_t)pgHugeLength(nsize);
+
+            if(olen == nlen) return buff->buffer;
+            if(nlen < olen) {
+                munmap((buff->buffer + nlen), (olen - nlen));
+                return buff->buffer;
+            }
+            // Let the kernel move the page tables rather than copying. Huge TLB mappings may refuse so those
+            // get copied below.
+            uint8_t *b = mremap(buff->buffer, olen, nlen, MREMAP_MAYMOVE);
+            if(b != MAP_FAILED) {
+                madvise(b, nlen, MADV_HUGEPAGE);
+                return b;
+            }
+        }
+#endif
+    }
+
+    uint8_t *b = pgStorageAlloc(buff, nsize);
+
+    if(b) {
+        PGMemCpy(b, buff->buffer, pg_Min(osize, nsize));
+        pgStat(buff, resizeBytesMoved, pg_Min(osize, nsize));
+        pgStorageFree(buff, buff->buffer, osize);
     }
+
+    return b;
 }
 
-void _PGSwap64(void *buffer, long length, int alt) {
-    uint64_t *words = buffer;
-    long     ws     = (length / 8);
+/*
+ * Reserve the address space for the whole thing, map the file over the front of it, and then map the data part of
+ * the file a second time straight after itself. Also used by the shared ring buffer and the journal, which keep a
+ * header in front of the data.
+ */
+uint8_t *_PGMapMirroredFile(int fd, long dataOffset, long size) {
+    size_t  total = (size_t)(dataOffset + (size * 2));
+    uint8_t *base = mmap(NULL, total, PROT_NONE, (MAP_PRIVATE | MAP_ANONYMOUS), -1, 0);
+
+    if(base != MAP_FAILED) {
+        if((mmap(base, (size_t)(dataOffset + size), (PROT_READ | PROT_WRITE), (MAP_SHARED | MAP_FIXED), fd, 0) != MAP_FAILED) &&
+           (mmap((base + dataOffset + size), (size_t)size, (PROT_READ | PROT_WRITE), (MAP_SHARED | MAP_FIXED), fd, dataOffset) != MAP_FAILED)) {
+            return base;
+        }
+        munmap(base, total);
+    }
 
-    if(ws) for(long i = 0; i < ws; ++i) words[i] = zaphod(words[i], alt);
+    return NULL;
 }
 
-PG_ALWAYS_INLINE long _PGSwapRingBufferEndian(PGRingBuffer *buff, long bytesPerWord, PGFunc func, int alt) {
-    long ws = (RBCC(buff) / bytesPerWord);
+#if PG_HAS_MIRROR
 
-    if(ws) {
-        long    length = (ws * bytesPerWord);
-        uint8_t *words = malloc((size_t)length);
-        PGReadFromRingBuffer(buff, words, length);
-        func(words, length, alt);
-        PGPrependToRingBuffer(buff, words, length);
+/*
+ * Reserve twice the address space and then map the same pages into both halves.
+ */
+PG_ALWAYS_INLINE uint8_t *pgMirrorMap(int fd, long size) {
+    return _PGMapMirroredFile(fd, 0, size);
+}
+
+static bool pgMirrorCreate(long size, uint8_t **buffer, int *fd) {
+    int f = memfd_create("PGRingBuffer", MFD_CLOEXEC);
+
+    if(f >= 0) {
+        if(ftruncate(f, size) == 0) {
+            uint8_t *b = pgMirrorMap(f, size);
+
+            if(b) {
+                *buffer = b;
+                *fd     = f;
+                return true;
+            }
+        }
+        close(f);
     }
 
-    return ws;
+    return false;
 }
 
-PG_ALWAYS_INLINE long pgRead(PGRingBuffer *buff, uint8_t *dest, long d) {
-    pgReadFrom(buff, buff->head, dest, d);
-    pgIncHead(buff, d);
-    return d;
+static void pgMirrorDestroy(uint8_t *buffer, long size, int fd) {
+    munmap(buffer, (size_t)(size * 2));
+    close(fd);
+}
+
+/*
+ * Resizes the backing memory and maps a new view of it. The pages that already hold data are kept so nothing
+ * is copied here.
+ */
+static uint8_t *pgMirrorResize(PGRingBuffer *buff, long nsize) {
+    if(ftruncate(buff->fd, nsize) == 0) {
+        uint8_t *nb = pgMirrorMap(buff->fd, nsize);
+
+        if(nb) {
+            munmap(buff->buffer, (size_t)(buff->size * 2));
+            return nb;
+        }
+        // Put it back the way it was so that the old view stays valid.
+        if(ftruncate(buff->fd, buff->size) != 0) {}
+    }
+
+    return NULL;
 }
 
+/*
+ * Moves the contents of a heap buffer into new mirrored storage.
+ */
+static bool pgMirrorSwitch(PGRingBuffer *buff, long nsize) {
+    uint8_t *nb = NULL;
+    int     fd  = -1;
+
+    if(pgMirrorCreate(nsize, &nb, &fd)) {
+        long cc = PGPeekFromRingBuffer(buff, nb, RBCC(buff));
+        pgStorageFree(buff, buff->buffer, buff->size);
+        buff->buffer = nb;
+        buff->fd     = fd;
+        buff->size   = nsize;
+        buff->mask   = pgMaskFor(buff->flags, nsize);
+        buff->head   = 0;
+        buff->tail   = cc;
+        pgStat(buff, resizeBytesMoved, cc);
+        return true;
+    }
+
+    pgStat(buff, failedAllocations, 1);
+    return false;
+}
+
+#endif
+
+/*
+ * The largest size the storage may have under the buffer's policy.
+ */
+PG_ALWAYS_INLINE long pgSizeLimit(const PGRingBuffer *buff) {
+    long mx = buff->policy.maxCapacity;
+
+    // PG_MAX_SIZE is a power of two so it's a valid limit either way.
+    if((mx <= 0) || (mx >= PG_MAX_SIZE)) return PG_MAX_SIZE;
+    if(buff->flags & PG_RINGBUFFER_POW2) {
+        long p = PG_MIN_POW2_SIZE;
+        while((p << 1) <= (mx + 1)) p <<= 1;
+        return p;
+    }
+    return (mx + 1);
+}
+
+long _PGRingBufferMaxSize(const PGRingBuffer *buff) {
+    return ((buff->flags & PG_RINGBUFFER_OVERWRITE) ? PGRingBufferCapacity(buff) : (pgSizeLimit(buff) - 1));
+}
+
+/*
+ * Returns the new size or zero if the policy's maximum capacity won't allow enough room.
+ */
 PG_ALWAYS_INLINE long getNewBufferSize(const PGRingBuffer *buff, long needed, long nsize) {
-    long c = (RBCC(buff) + 1);
-    do { nsize *= 2; } while((nsize - c) < needed);
-    return nsize;
+    long   c  = (RBCC(buff) + 1);
+    long   mx = pgSizeLimit(buff);
+    double f  = ((buff->policy.growthFactor > 1.0) ? buff->policy.growthFactor : 2.0);
+
+    if((mx - c) < needed) {
+        errno = ENOMEM;
+        return 0;
+    }
+
+    do {
+        // Done in double so that growing a huge buffer can't overflow.
+        double g = ((double)nsize * f);
+        nsize = ((g >= (double)mx) ? mx : pg_Max((nsize + 1), (long)g));
+        if(buff->flags & PG_RINGBUFFER_POW2) nsize = pgNextPow2(nsize);
+    } while(((nsize - c) < needed) && (nsize < mx));
+
+    return pg_Min(nsize, mx);
 }
 
 PG_ALWAYS_INLINE void defragBufferAfterResize(PGRingBuffer *buff, long nsize, long osize, long ohead, long otail) {
@@ -96,134 +464,391 @@ PG_ALWAYS_INLINE void defragBufferAfterResize(PGRingBuffer *buff, long nsize, lo
         long    hsz = (osize - ohead);
         uint8_t *nb = buff->buffer;
 
-        if(hsz > otail) {
-            // Defrag by moving the tail.
+        if((hsz > otail) && (otail < (nsize - osize))) {
+            // Defrag by moving the tail. (Only if it fits in the new space. It might not with a small growth factor.)
             PGMemMove((nb + osize), nb, otail);
             buff->tail += osize;
+            pgStat(buff, resizeBytesMoved, otail);
         }
         else {
             // Defrag by moving the head.
             long nhead = (nsize - hsz);
             PGMemMove((nb + nhead), (nb + ohead), hsz);
             buff->head = nhead;
+            pgStat(buff, resizeBytesMoved, hsz);
+        }
+    }
+}
+
+/*
+ * Exchanges two non-overlapping blocks of `length` bytes. The fixed size chunks let the compiler use vector
+ * loads and stores.
+ */
+PG_ALWAYS_INLINE void pgSwapBlocks(uint8_t *a, uint8_t *b, long length) {
+    uint8_t t[64];
+
+    for(; length >= 64; a += 64, b += 64, length -= 64) {
+        memcpy(t, a, 64);
+        memcpy(a, b, 64);
+        memcpy(b, t, 64);
+    }
+    if(length > 0) {
+        PGMemCpy(t, a, length);
+        PGMemCpy(a, b, length);
+        PGMemCpy(b, t, length);
+    }
+}
+
+/*
+ * Rotates the `length` bytes at `bytes` to the left by `k` bytes in place (Gries-Mills block swap). Once either
+ * side is small enough it is parked on the stack and the other side is moved in one go so that we never spin on
+ * tiny blocks.
+ */
+static void pgRotate(uint8_t *bytes, long length, long k) {
+    uint8_t t[PG_ROTATE_STACK];
+
+    while((k > 0) && (k < length)) {
+        long r = (length - k);
+
+        if(k <= PG_ROTATE_STACK) {
+            PGMemCpy(t, bytes, k);
+            PGMemMove(bytes, (bytes + k), r);
+            PGMemCpy((bytes + r), t, k);
+            return;
+        }
+        else if(r <= PG_ROTATE_STACK) {
+            PGMemCpy(t, (bytes + k), r);
+            PGMemMove((bytes + r), bytes, k);
+            PGMemCpy(bytes, t, r);
+            return;
+        }
+        else if(k <= r) {
+            pgSwapBlocks(bytes, (bytes + k), k);
+            bytes += k;
+            length -= k;
+        }
+        else {
+            pgSwapBlocks(bytes, (bytes + k), r);
+            bytes += r;
+            length -= r;
+            k -= r;
         }
     }
 }
 
 bool PGDefragRingBuffer(PGRingBuffer *buff) {
+    if(pgIsMirrored(buff)) return true;
+
     long    h  = buff->head;
     long    t  = buff->tail;
-    long    s  = buff->size;
+    long    cc = RBCC(buff);
     uint8_t *b = buff->buffer;
 
     if(t < h) {
-        long hs = (s - h);
-        long ts = t;
+        long hs = (buff->size - h);
 
-        if(hs < ts) {
-            uint8_t *nb = malloc((size_t)hs);
-
-            if(nb) {
-                PGMemMove(nb, b + h, hs);
-                PGMemCpy(b + hs, b, ts);
-                PGMemMove(b, nb, hs);
-                buff->head = 0;
-                buff->tail = (hs + ts);
-                free(nb);
-            }
-            else {
-                return false;
-            }
+        if((h - t) >= hs) {
+            // The head segment fits in the gap so just slide the tail segment over to make room for it.
+            PGMemMove((b + hs), b, t);
+            PGMemCpy(b, (b + h), hs);
+            pgStat(buff, defragBytesMoved, cc);
         }
         else {
-            uint8_t *nb = malloc((size_t)ts);
-
-            if(nb) {
-                PGMemMove(nb, b, ts);
-                PGMemCpy(b, (b + h), hs);
-                PGMemMove((b + hs), nb, ts);
-                buff->head = 0;
-                buff->tail = (hs + ts);
-                free(nb);
-            }
-            else {
-                return false;
-            }
+            // Close the gap and then rotate the two segments into place.
+            PGMemMove((b + t), (b + h), hs);
+            pgRotate(b, cc, t);
+            pgStat(buff, defragBytesMoved, (hs + cc));
         }
     }
-    else if(h < t) {
-        if(h) {
-            long cc = (t - h);
-            PGMemCpy(b, (b + h), cc);
-            buff->head = 0;
-            buff->tail = cc;
-        }
-    }
-    else {
-        buff->head = buff->tail = 0;
+    else if(h) {
+        PGMemMove(b, (b + h), cc);
+        pgStat(buff, defragBytesMoved, cc);
     }
+
+    buff->head = 0;
+    buff->tail = cc;
     return true;
 }
 
-uint8_t *PGGetRingBufferBuffer(PGRingBuffer *buff, long *size) {
-    if(PGDefragRingBuffer(buff)) {
-        *size = RBCC(buff);
-        return buff->buffer;
-    }
-    else {
-        *size = 0;
-        return NULL;
+uint8_t *PGMakeRingBufferContiguous(PGRingBuffer *buff, long length) {
+    long h  = buff->head;
+    long hs = pgContig(buff, h);
+
+    length = pg_Min(length, RBCC(buff));
+
+    if(length > hs) {
+        long    t    = buff->tail;
+        long    need = (length - hs);
+        uint8_t *b   = buff->buffer;
+
+        if((h - t) >= need) {
+            // Slide everything back by just enough for the first `length` bytes to end at the end of the storage.
+            PGMemMove((b + h - need), (b + h), hs);
+            PGMemCpy((b + buff->size - need), b, need);
+            PGMemMove(b, (b + need), (t - need));
+            buff->head = (h - need);
+            buff->tail = (t - need);
+            pgStat(buff, defragBytesMoved, (hs + t));
+        }
+        else {
+            PGDefragRingBuffer(buff);
+        }
     }
+
+    return (buff->buffer + buff->head);
+}
+
+uint8_t *PGGetRingBufferBuffer(PGRingBuffer *buff, long *size) {
+    *size = RBCC(buff);
+    return PGMakeRingBufferContiguous(buff, *size);
 }
 
 long PGSwapRingBufferEndian16(PGRingBuffer *buff) {
-    return _PGSwapRingBufferEndian(buff, 2, _PGSwap16, 0);
+    return _PGSwapRingBufferEndian(buff, 2, 0);
 }
 
 long PGSwapRingBufferEndian32(PGRingBuffer *buff) {
-    return _PGSwapRingBufferEndian(buff, 4, _PGSwap32, 0);
+    return _PGSwapRingBufferEndian(buff, 4, 0);
 }
 
 long PGSwapRingBufferEndian32Alt(PGRingBuffer *buff) {
-    return _PGSwapRingBufferEndian(buff, 4, _PGSwap32, 1);
+    return _PGSwapRingBufferEndian(buff, 4, 1);
 }
 
 long PGSwapRingBufferEndian64(PGRingBuffer *buff) {
-    return _PGSwapRingBufferEndian(buff, 8, _PGSwap64, 0);
+    return _PGSwapRingBufferEndian(buff, 8, 0);
 }
 
 long PGSwapRingBufferEndian64Alt(PGRingBuffer *buff) {
-    return _PGSwapRingBufferEndian(buff, 8, _PGSwap64, 1);
+    return _PGSwapRingBufferEndian(buff, 8, 1);
 }
 
 long PGSwapRingBufferEndian64AltAlt(PGRingBuffer *buff) {
-    return _PGSwapRingBufferEndian(buff, 8, _PGSwap64, 2);
+    return _PGSwapRingBufferEndian(buff, 8, 2);
+}
+
+void PGSetRingBufferPolicy(PGRingBuffer *buff, const PGRingBufferPolicy *policy) {
+    buff->policy    = (policy ? *policy : PG_RINGBUFFER_DEFAULT_POLICY);
+    buff->underUsed = 0;
+}
+
+void PGGetRingBufferPolicy(const PGRingBuffer *buff, PGRingBufferPolicy *policy) {
+    *policy = buff->policy;
+}
+
+bool PGShrinkRingBuffer(PGRingBuffer *buff) {
+    long cc    = RBCC(buff);
+    long nsize = pg_Max(buff->initSize, ((cc + 1) * 2));
+
+    if(buff->flags & PG_RINGBUFFER_POW2) nsize = pgNextPow2(nsize);
+    buff->underUsed = 0;
+
+#if PG_HAS_MIRROR
+    if(pgIsMirrored(buff)) {
+        uint8_t *nb = NULL;
+        int     fd  = -1;
+
+        // The new storage can't overlap the old so this is a copy rather than a compaction.
+        if(nsize >= PG_RINGBUFFER_MIRROR_MIN_SIZE) {
+            nsize = pgRoundToPage(nsize);
+            if(nsize >= buff->size) return true;
+            if(!pgMirrorCreate(nsize, &nb, &fd)) {
+                pgStat(buff, failedAllocations, 1);
+                return false;
+            }
+        }
+        else if((nb = pgStorageAlloc(buff, nsize)) == NULL) {
+            return false;
+        }
+
+        PGPeekFromRingBuffer(buff, nb, cc);
+        pgStat(buff, resizeBytesMoved, cc);
+        pgStat(buff, shrinks, 1);
+        pgMirrorDestroy(buff->buffer, buff->size, buff->fd);
+        buff->buffer = nb;
+        buff->fd     = fd;
+        buff->size   = nsize;
+        buff->mask   = pgMaskFor(buff->flags, nsize);
+        buff->head   = 0;
+        buff->tail   = cc;
+        return true;
+    }
+#endif
+
+    if(nsize >= buff->size) return true;
+
+    PGDefragRingBuffer(buff);
+
+    uint8_t *nb = pgStorageRealloc(buff, buff->size, nsize);
+    if(nb == NULL) return false;
+
+    buff->buffer = nb;
+    buff->size   = nsize;
+    buff->mask   = pgMaskFor(buff->flags, nsize);
+    pgStat(buff, shrinks, 1);
+    return true;
+}
+
+bool PGGetRingBufferStats(const PGRingBuffer *buff, PGRingBufferStats *stats) {
+#if PG_RINGBUFFER_STATS
+    *stats = buff->stats;
+    return true;
+#else
+    memset(stats, 0, sizeof(PGRingBufferStats));
+    return false;
+#endif
+}
+
+void PGResetRingBufferStats(PGRingBuffer *buff) {
+#if PG_RINGBUFFER_STATS
+    memset(&buff->stats, 0, sizeof(PGRingBufferStats));
+    buff->stats.peakCount = RBCC(buff);
+#endif
+}
+
+long PGRingBufferDroppedBytes(const PGRingBuffer *buff) {
+    return buff->dropped;
+}
+
+long PGResetRingBufferDroppedBytes(PGRingBuffer *buff) {
+    long d = buff->dropped;
+    buff->dropped = 0;
+    return d;
+}
+
+bool PGRingBufferIsMirrored(const PGRingBuffer *buff) {
+    return pgIsMirrored(buff);
 }
 
 bool resizeBuffer(PGRingBuffer *buff, long needed, long osize, long ohead, long otail) {
-    long    nsize = getNewBufferSize(buff, needed, osize);
-    uint8_t *nb   = realloc(buff->buffer, (size_t)nsize);
+    if(buff->flags & PG_RINGBUFFER_OVERWRITE) return false;
+
+    long nsize = getNewBufferSize(buff, needed, osize);
+
+    if(nsize <= osize) return false;
+
+#if PG_HAS_MIRROR
+    if((buff->flags & PG_RINGBUFFER_MIRRORED) && (nsize >= PG_RINGBUFFER_MIRROR_MIN_SIZE)) {
+        long msize = pgRoundToPage(nsize);
+
+        // Mirrored storage has to be a whole number of pages so keep under the maximum by rounding down.
+        if(msize > pgSizeLimit(buff)) msize -= pgPageSize();
+
+        if((msize - RBCC(buff) - 1) < needed) {
+            // Can't be done with mirrored storage. Leave it where it is.
+            if(pgIsMirrored(buff)) return false;
+        }
+        else if(pgIsMirrored(buff)) {
+            nsize = msize;
+            uint8_t *nb = pgMirrorResize(buff, nsize);
+
+            if(nb) {
+                buff->buffer = nb;
+                buff->size   = nsize;
+                buff->mask   = pgMaskFor(buff->flags, nsize);
+                defragBufferAfterResize(buff, nsize, osize, ohead, otail);
+                pgStat(buff, resizes, 1);
+                return true;
+            }
+
+            pgStat(buff, failedAllocations, 1);
+            return false;
+        }
+        else if(pgMirrorSwitch(buff, msize)) {
+            pgStat(buff, resizes, 1);
+            return true;
+        }
+        // Otherwise fall back to the heap.
+    }
+#endif
+
+    uint8_t *nb = pgStorageRealloc(buff, osize, nsize);
 
     if(nb) {
         buff->buffer = nb;
         buff->size   = nsize;
+        buff->mask   = pgMaskFor(buff->flags, nsize);
         defragBufferAfterResize(buff, nsize, osize, ohead, otail);
+        pgStat(buff, resizes, 1);
         return true;
     }
 
     return false;
 }
 
+/*
+ * Makes room for `length` new bytes in an overwriting buffer by dropping the oldest ones. If `length` is more than
+ * the capacity then everything already there is dropped along with the start of the new bytes. Returns how many
+ * of the new bytes to skip.
+ */
+static long pgOverwrite(PGRingBuffer *buff, long length) {
+    long skip = pg_Max(0, (length - PGRingBufferCapacity(buff)));
+    long drop = pg_Min(RBCC(buff), ((length - skip) - PGRingBufferRemaining(buff)));
+
+    pgIncHead(buff, drop);
+    buff->dropped += (pg_Max(0, drop) + skip);
+    return skip;
+}
+
+/*
+ * Makes room for `length` new bytes at the tail, either by growing the storage or, for an overwriting buffer, by
+ * dropping the oldest bytes. Returns how many of the new bytes won't fit and have to be skipped (only ever
+ * non-zero when overwriting) or -1 if the storage could not be grown.
+ */
+PG_ALWAYS_INLINE long pgMakeRoom(PGRingBuffer *buff, long length) {
+    if(__builtin_expect((PGRingBufferRemaining(buff) >= length), 1)) return 0;
+    if(buff->flags & PG_RINGBUFFER_OVERWRITE) return pgOverwrite(buff, length);
+    return (resizeBuffer(buff, length, buff->size, buff->head, buff->tail) ? 0 : -1);
+}
+
 PGRingBuffer *PGCreateRingBuffer(long initialSize) {
-    PGRingBuffer *buff = malloc(sizeof(PGRingBuffer));
+    return PGCreateRingBufferWithFlags(initialSize, PG_RINGBUFFER_DEFAULT);
+}
+
+PGRingBuffer *PGCreateRingBufferPow2(long initialSize) {
+    return PGCreateRingBufferWithFlags(initialSize, PG_RINGBUFFER_POW2);
+}
+
+PGRingBuffer *PGCreateRingBufferWithFlags(long initialSize, int flags) {
+    return PGCreateRingBufferWithAllocator(initialSize, flags, NULL);
+}
+
+PGRingBuffer *PGCreateRingBufferWithAllocator(long initialSize, int flags, const PGRingBufferAllocator *allocator) {
+    if(allocator == NULL) allocator = &_PGDefaultRingBufferAllocator;
+
+    if(initialSize > PG_MAX_SIZE) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    PGRingBuffer *buff = allocator->alloc(allocator->context, sizeof(PGRingBuffer));
     if(buff) {
-        buff->initSize = pg_Min(initialSize, 5);
-        buff->size     = buff->initSize;
-        buff->head     = 0;
-        buff->tail     = 0;
-        buff->buffer   = malloc((size_t)buff->size);
+        buff->initSize  = ((flags & PG_RINGBUFFER_POW2) ? pgNextPow2(initialSize) : pg_Max(initialSize, PG_MIN_SIZE));
+        buff->size      = buff->initSize;
+        buff->head      = 0;
+        buff->tail      = 0;
+        buff->flags     = flags;
+        buff->fd        = -1;
+        buff->buffer    = NULL;
+        buff->allocator = allocator;
+        buff->policy    = PG_RINGBUFFER_DEFAULT_POLICY;
+        buff->underUsed = 0;
+        buff->dropped   = 0;
+#if PG_RINGBUFFER_STATS
+        memset(&buff->stats, 0, sizeof(PGRingBufferStats));
+#endif
+
+#if PG_HAS_MIRROR
+        if((flags & PG_RINGBUFFER_MIRRORED) && (buff->initSize >= PG_RINGBUFFER_MIRROR_MIN_SIZE)) {
+            long sz = pgRoundToPage(buff->initSize);
+            if(pgMirrorCreate(sz, &buff->buffer, &buff->fd)) buff->initSize = buff->size = sz;
+        }
+#endif
+
+        buff->mask = pgMaskFor(flags, buff->size);
+        if(!buff->buffer) buff->buffer = pgStorageAlloc(buff, buff->size);
         if(buff->buffer) return buff;
-        free(buff);
+        pgFree(buff, buff, sizeof(PGRingBuffer));
         buff = NULL;
     }
     return buff;
@@ -231,20 +856,23 @@ PGRingBuffer *PGCreateRingBuffer(long initialSize) {
 
 void PGDiscardRingBuffer(PGRingBuffer *buff) {
     if(buff) {
-        if(buff->buffer) free(buff->buffer);
-        free(buff);
+#if PG_HAS_MIRROR
+        if(pgIsMirrored(buff)) pgMirrorDestroy(buff->buffer, buff->size, buff->fd);
+        else
+#endif
+        if(buff->buffer) pgStorageFree(buff, buff->buffer, buff->size);
+        pgFree(buff, buff, sizeof(PGRingBuffer));
     }
 }
 
 long PGReadFromRingBuffer(PGRingBuffer *buff, void *dest, long maxLength) {
     if((dest != NULL) && (maxLength > 0) && (buff->head != buff->tail)) {
-        if((buff->tail < buff->head)) {
-            long d = pgRead(buff, dest, pg_Min(maxLength, (buff->size - buff->head)));
-            return (d + pgRead(buff, (dest + d), pg_Min((maxLength - d), buff->tail)));
-        }
-        else {
-            return pgRead(buff, dest, pg_Min(maxLength, (buff->tail - buff->head)));
-        }
+        long cc = pg_Min(maxLength, RBCC(buff));
+        long d  = pgRead(buff, dest, pg_Min(cc, pgContig(buff, buff->head)));
+        pgStatWrap(buff, (cc - d));
+        d += pgRead(buff, (dest + d), (cc - d));
+        pgCheckUsage(buff);
+        return d;
     }
 
     return 0;
@@ -252,20 +880,18 @@ long PGReadFromRingBuffer(PGRingBuffer *buff, void *dest, long maxLength) {
 
 long PGReadLastFromRingBuffer(PGRingBuffer *buff, void *dest, long maxLength) {
     if((dest != NULL) && (maxLength > 0) && (buff->head != buff->tail)) {
-        if(buff->head < buff->tail) {
-            long sz = pg_Min((buff->tail - buff->head), maxLength);
-            buff->tail = (buff->tail - sz);
-            return pgReadFrom(buff, buff->tail, dest, sz);
-        }
-        else {
-            long sz = pg_Min(buff->tail, maxLength);
-            long x  = (maxLength - pgReadFrom(buff, (buff->tail = 0), dest, sz));
-            if(x > 0) {
-                long sz2 = pg_Min((buff->size - buff->head), x);
-                return (sz + pgReadFrom(buff, (buff->tail = (buff->size - sz2)), (dest + sz), sz2));
-            }
-            return sz;
-        }
+        long cc = pg_Min(maxLength, RBCC(buff));
+        long st = (buff->tail - cc);
+
+        if(st < 0) st += buff->size;
+
+        long l = pg_Min(cc, pgContig(buff, st));
+        pgReadFrom(buff, st, dest, l);
+        pgReadFrom(buff, 0, (dest + l), (cc - l));
+        pgStatWrap(buff, (cc - l));
+        buff->tail = st;
+        pgCheckUsage(buff);
+        return cc;
     }
 
     return 0;
@@ -277,33 +903,27 @@ bool PGEnsureCapacity(PGRingBuffer *buff, long needed) {
 
 bool PGAppendRingBufferToRingBuffer(PGRingBuffer *dest, const PGRingBuffer *src) {
     if(src && (src->head != src->tail)) {
-        if(src->head < src->tail) {
-            return PGAppendToRingBuffer(dest, (src->buffer + src->head), (src->tail - src->head));
-        }
-        else {
-            if(PGAppendToRingBuffer(dest, (src->buffer + src->head), (src->size - src->head))) {
-                return PGAppendToRingBuffer(dest, src->buffer, src->tail);
-            }
-            return false;
-        }
+        long cc = RBCC(src);
+        long l  = pg_Min(cc, pgContig(src, src->head));
+        return (PGAppendToRingBuffer(dest, (src->buffer + src->head), l) && PGAppendToRingBuffer(dest, src->buffer, (cc - l)));
     }
     return true;
 }
 
 bool PGAppendToRingBuffer(PGRingBuffer *buff, const void *src, long length) {
     if(src && length > 0) {
-        if(PGEnsureCapacity(buff, length)) {
-            if((buff->tail < buff->head)) {
-                PGMemCpy((buff->buffer + buff->tail), src, length);
-                pgIncTail(buff, length);
-            }
-            else {
-                long l = pg_Min(length, (buff->size - buff->tail));
-                PGMemCpy((buff->buffer + buff->tail), src, l);
-                pgIncTail(buff, l);
-                return PGAppendToRingBuffer(buff, (src + l), (length - l));
-            }
-
+        long skip = pgMakeRoom(buff, length);
+
+        if(skip >= 0) {
+            src += skip;
+            length -= skip;
+
+            long l = pg_Min(length, pgContig(buff, buff->tail));
+            PGMemCpy((buff->buffer + buff->tail), src, l);
+            PGMemCpy(buff->buffer, (src + l), (length - l));
+            pgIncTail(buff, length);
+            pgStatWrap(buff, (length - l));
+            pgStatPeak(buff);
             return true;
         }
 
@@ -313,10 +933,40 @@ bool PGAppendToRingBuffer(PGRingBuffer *buff, const void *src, long length) {
     return true;
 }
 
+long PGRingBufferReserve(PGRingBuffer *buff, long length, PGRingBufferSpan spans[2]) {
+    long l = 0;
+
+    if(length > 0) {
+        // An overwriting buffer doesn't drop anything yet. Any room past what's free runs over the oldest bytes,
+        // which are only dropped once the new bytes are committed.
+        if(buff->flags & PG_RINGBUFFER_OVERWRITE) length = pg_Min(length, PGRingBufferCapacity(buff));
+        else if(pgMakeRoom(buff, length) < 0) length = PGRingBufferRemaining(buff);
+        l = pg_Min(length, pgContig(buff, buff->tail));
+    }
+    else {
+        length = 0;
+    }
+
+    spans[0].bytes  = (buff->buffer + buff->tail);
+    spans[0].length = l;
+    spans[1].bytes  = buff->buffer;
+    spans[1].length = (length - l);
+    return length;
+}
+
+void PGRingBufferCommit(PGRingBuffer *buff, long length) {
+    if(length > 0) {
+        if(buff->flags & PG_RINGBUFFER_OVERWRITE) pgMakeRoom(buff, (length = pg_Min(length, PGRingBufferCapacity(buff))));
+        pgIncTail(buff, pg_Min(length, PGRingBufferRemaining(buff)));
+        pgStatPeak(buff);
+    }
+}
+
 bool PGAppendByteToRingBuffer(PGRingBuffer *buff, uint8_t byte) {
-    if(PGEnsureCapacity(buff, 1)) {
+    if(pgMakeRoom(buff, 1) == 0) {
         buff->buffer[buff->tail] = byte;
         pgIncTail(buff, 1);
+        pgStatPeak(buff);
         return true;
     }
     return false;
@@ -324,15 +974,10 @@ bool PGAppendByteToRingBuffer(PGRingBuffer *buff, uint8_t byte) {
 
 bool PGPrependRingBufferToRingBuffer(PGRingBuffer *dest, const PGRingBuffer *src) {
     if(src && (src->head != src->tail)) {
-        if(src->head < src->tail) {
-            return PGPrependToRingBuffer(dest, (src->buffer + src->head), (src->tail - src->head));
-        }
-        else {
-            if(PGPrependToRingBuffer(dest, (src->buffer + src->head), (src->size - src->head))) {
-                return PGPrependToRingBuffer(dest, src->buffer, src->tail);
-            }
-            return false;
-        }
+        long cc = RBCC(src);
+        long l  = pg_Min(cc, pgContig(src, src->head));
+        // Prepend the wrapped part first so that it ends up after the first part.
+        return (PGPrependToRingBuffer(dest, src->buffer, (cc - l)) && PGPrependToRingBuffer(dest, (src->buffer + src->head), l));
     }
     return true;
 }
@@ -343,14 +988,16 @@ bool PGPrependToRingBuffer(PGRingBuffer *buff, const void *src, long length) {
             long ohead = buff->head;
             pgDecHead(buff, length);
 
-            if(buff->head < ohead) {
+            if(pgIsMirrored(buff) || (buff->head < ohead)) {
                 PGMemCpy((buff->buffer + buff->head), src, length);
             }
             else {
                 long l = (buff->size - buff->head);
                 PGMemCpy((buff->buffer + buff->head), src, l);
                 PGMemCpy(buff->buffer, (src + l), (length - l));
+                pgStatWrap(buff, (length - l));
             }
+            pgStatPeak(buff);
             return true;
         }
         return false;
@@ -361,11 +1008,125 @@ bool PGPrependToRingBuffer(PGRingBuffer *buff, const void *src, long length) {
 bool PGPrependByteToRingBuffer(PGRingBuffer *buff, uint8_t byte) {
     if(PGEnsureCapacity(buff, 1)) {
         buff->buffer[pgDecHead(buff, 1)] = byte;
+        pgStatPeak(buff);
         return true;
     }
     return false;
 }
 
+#define PG_STORAGE_FLAGS (PG_RINGBUFFER_POW2 | PG_RINGBUFFER_MIRRORED | PG_RINGBUFFER_CACHE_ALIGNED | PG_RINGBUFFER_PAGE_ALIGNED | PG_RINGBUFFER_HUGEPAGES)
+
+/*
+ * Whether `a` can take over `b`'s storage and the other way around. The kind of storage is worked out from the
+ * flags and the size (or the fd for mirrored storage) so, as long as the flags and the allocator are the same,
+ * each buffer will free the other's storage correctly. The same maximum capacity means neither can end up with
+ * storage bigger than its policy allows.
+ */
+PG_ALWAYS_INLINE bool pgCanTrade(const PGRingBuffer *a, const PGRingBuffer *b) {
+    return ((a->allocator == b->allocator) &&
+            ((a->flags & PG_STORAGE_FLAGS) == (b->flags & PG_STORAGE_FLAGS)) &&
+            (((a->flags | b->flags) & PG_RINGBUFFER_OVERWRITE) == 0) &&
+            (a->policy.maxCapacity == b->policy.maxCapacity));
+}
+
+static void pgTradeStorage(PGRingBuffer *a, PGRingBuffer *b) {
+    PGRingBuffer t = *a;
+
+    a->buffer    = b->buffer;
+    a->size      = b->size;
+    a->mask      = b->mask;
+    a->fd        = b->fd;
+    a->head      = b->head;
+    a->tail      = b->tail;
+    a->underUsed = 0;
+    b->buffer    = t.buffer;
+    b->size      = t.size;
+    b->mask      = t.mask;
+    b->fd        = t.fd;
+    b->head      = t.head;
+    b->tail      = t.tail;
+    b->underUsed = 0;
+    pgStatPeak(a);
+    pgStatPeak(b);
+}
+
+bool PGMoveRingBufferToRingBuffer(PGRingBuffer *dest, PGRingBuffer *src) {
+    long sc = RBCC(src);
+    long dc = RBCC(dest);
+
+    if((dest == src) || (sc == 0)) return true;
+
+    if(pgCanTrade(dest, src) && (dc < sc)) {
+        // Cheaper to put the destination's bytes in front of the source's and take the source's storage.
+        if(!PGEnsureCapacity(src, dc) || !PGPrependRingBufferToRingBuffer(src, dest)) return false;
+        dest->head = dest->tail = 0;
+        pgTradeStorage(dest, src);
+        return true;
+    }
+
+    // An overwriting destination drops its oldest bytes rather than growing.
+    if(!((dest->flags & PG_RINGBUFFER_OVERWRITE) || PGEnsureCapacity(dest, sc)) || !PGAppendRingBufferToRingBuffer(dest, src)) return false;
+    src->head = src->tail = 0;
+    return true;
+}
+
+bool PGMoveRingBufferToFrontOfRingBuffer(PGRingBuffer *dest, PGRingBuffer *src) {
+    long sc = RBCC(src);
+    long dc = RBCC(dest);
+
+    if((dest == src) || (sc == 0)) return true;
+
+    if(pgCanTrade(dest, src) && (dc < sc)) {
+        if(!PGEnsureCapacity(src, dc) || !PGAppendRingBufferToRingBuffer(src, dest)) return false;
+        dest->head = dest->tail = 0;
+        pgTradeStorage(dest, src);
+        return true;
+    }
+
+    if(!PGEnsureCapacity(dest, sc) || !PGPrependRingBufferToRingBuffer(dest, src)) return false;
+    src->head = src->tail = 0;
+    return true;
+}
+
+PGRingBuffer *PGSplitRingBuffer(PGRingBuffer *buff, long offset) {
+    long         cc = RBCC(buff);
+    long         rest;
+    bool         swap;
+    PGRingBuffer *nb;
+
+    offset = pg_Min(pg_Max(0, offset), cc);
+    rest   = (cc - offset);
+    // An overwriting buffer's capacity is fixed so it has to keep its own storage.
+    swap   = ((rest < offset) && !(buff->flags & PG_RINGBUFFER_OVERWRITE));
+    nb     = PGCreateRingBufferWithAllocator(((swap ? rest : offset) + 1), buff->flags, buff->allocator);
+
+    if(nb == NULL) return NULL;
+    nb->policy   = buff->policy;
+    nb->initSize = pg_Min(nb->initSize, buff->initSize);
+
+    if(swap) {
+        // Copy the tail end out, cut it off, and trade so that `nb` ends up with the original storage.
+        PGRingBufferSpan spans[2];
+        long             l;
+
+        PGPeekSpansFromRingBuffer(buff, spans);
+        l = pg_Max(0, pg_Min(rest, (spans[0].length - offset)));
+        PGMemCpy(nb->buffer, (spans[0].bytes + (spans[0].length - l)), l);
+        PGMemCpy((nb->buffer + l), (spans[1].bytes + (spans[1].length - (rest - l))), (rest - l));
+        nb->tail   = rest;
+        buff->tail = pgWrap(buff, (buff->head + offset));
+        pgTradeStorage(nb, buff);
+    }
+    else {
+        PGPeekFromRingBuffer(buff, nb->buffer, offset);
+        nb->tail = offset;
+        PGRingBufferConsume(buff, offset);
+    }
+
+    pgStatPeak(nb);
+    return nb;
+}
+
 /**
  * The current capacity of the buffer when empty.
  *
@@ -383,6 +1144,13 @@ long PGRingBufferCapacity(const PGRingBuffer *buff) {
  * @param length the number of bytes to consume from the buffer.
  */
 void PGRingBufferConsume(PGRingBuffer *buff, long length) {
+    if(length > 0) {
+        pgIncHead(buff, pg_Min(RBCC(buff), length));
+        pgCheckUsage(buff);
+    }
+}
+
+void _PGRingBufferConsume(PGRingBuffer *buff, long length) {
     if(length > 0) { pgIncHead(buff, pg_Min(RBCC(buff), length)); }
 }
 
@@ -415,11 +1183,32 @@ long PGRingBufferRemaining(const PGRingBuffer *buff) {
  * @return the number of bytes read.
  */
 long PGPeekFromRingBuffer(PGRingBuffer *buff, void *dest, long maxLength) {
-    long head = buff->head;
-    long tail = buff->tail;
-    long cc   = PGReadFromRingBuffer(buff, dest, maxLength);
-    buff->head = head;
-    buff->tail = tail;
+    if((dest != NULL) && (maxLength > 0)) {
+        PGRingBufferSpan spans[2];
+        long             cc = pg_Min(maxLength, PGPeekSpansFromRingBuffer(buff, spans));
+        long             l  = PGMemCpy(dest, spans[0].bytes, pg_Min(cc, spans[0].length));
+        pgStatWrap(buff, (cc - l));
+        return (l + PGMemCpy((dest + l), spans[1].bytes, (cc - l)));
+    }
+
+    return 0;
+}
+
+/**
+ * Get the bytes in the buffer, in place, as two spans.
+ *
+ * @param buff the buffer.
+ * @param spans receives the two readable spans.
+ * @return the total number of bytes in the two spans.
+ */
+long PGPeekSpansFromRingBuffer(const PGRingBuffer *buff, PGRingBufferSpan spans[2]) {
+    long cc = RBCC(buff);
+    long l  = pg_Min(cc, pgContig(buff, buff->head));
+
+    spans[0].bytes  = (buff->buffer + buff->head);
+    spans[0].length = l;
+    spans[1].bytes  = buff->buffer;
+    spans[1].length = (cc - l);
     return cc;
 }
 
@@ -432,7 +1221,7 @@ long PGPeekFromRingBuffer(PGRingBuffer *buff, void *dest, long maxLength) {
  * @return A single byte from the buffer or zero if the buffer is empty.
  */
 uint8_t PGGetByteFromRingBuffer(PGRingBuffer *buff, long offset) {
-    long x = indexOf(buff, offset);
+    long x = pgIndexOf(buff, offset);
     return ((x < 0) ? (uint8_t)0 : buff->buffer[x]);
 }
 
@@ -445,7 +1234,7 @@ uint8_t PGGetByteFromRingBuffer(PGRingBuffer *buff, long offset) {
  * @param byte The value to set at that index.
  */
 void PGSetByteOnRingBuffer(PGRingBuffer *buff, long index, uint8_t byte) {
-    long x = indexOf(buff, index);
+    long x = pgIndexOf(buff, index);
     if(x >= 0) buff->buffer[x] = byte;
 }
 
@@ -458,14 +1247,36 @@ void PGSetByteOnRingBuffer(PGRingBuffer *buff, long index, uint8_t byte) {
  * @return `true` if successful, `false` if th buffer could not be resized.
  */
 bool PGClearRingBuffer(PGRingBuffer *buff, bool keepCapacity) {
-    buff->head = 0;
-    buff->tail = 0;
+    buff->head      = 0;
+    buff->tail      = 0;
+    buff->underUsed = 0;
 
     if(!keepCapacity) {
-        uint8_t *b = realloc(buff->buffer, (size_t)buff->initSize);
+#if PG_HAS_MIRROR
+        if(pgIsMirrored(buff)) {
+            uint8_t *b = ((buff->initSize >= PG_RINGBUFFER_MIRROR_MIN_SIZE) ? pgMirrorResize(buff, buff->initSize) : pgStorageAlloc(buff, buff->initSize));
+
+            if(b == NULL) {
+                pgStat(buff, failedAllocations, (buff->initSize >= PG_RINGBUFFER_MIRROR_MIN_SIZE));
+                return false;
+            }
+            if(buff->initSize < PG_RINGBUFFER_MIRROR_MIN_SIZE) {
+                pgMirrorDestroy(buff->buffer, buff->size, buff->fd);
+                buff->fd = -1;
+            }
+            if(buff->size != buff->initSize) pgStat(buff, shrinks, 1);
+            buff->buffer = b;
+            buff->size   = buff->initSize;
+            buff->mask   = pgMaskFor(buff->flags, buff->size);
+            return true;
+        }
+#endif
+        uint8_t *b = ((buff->size == buff->initSize) ? buff->buffer : pgStorageRealloc(buff, buff->size, buff->initSize));
         if(b) {
+            if(buff->size != buff->initSize) pgStat(buff, shrinks, 1);
             buff->buffer = b;
             buff->size   = buff->initSize;
+            buff->mask   = pgMaskFor(buff->flags, buff->size);
         }
         else return false;
     }
@@ -483,27 +1294,27 @@ long PGMemMove(void *dst, const void *src, long length) {
 }
 
 void PGSwap16(void *buffer, long length) {
-    _PGSwap16(buffer, length, 0);
+    _PGSwap(buffer, length, 2, 0);
 }
 
 void PGSwap32(void *buffer, long length) {
-    _PGSwap32(buffer, length, 0);
+    _PGSwap(buffer, length, 4, 0);
 }
 
 void PGSwap32Alt(void *buffer, long length) {
-    _PGSwap32(buffer, length, 1);
+    _PGSwap(buffer, length, 4, 1);
 }
 
 void PGSwap64(void *buffer, long length) {
-    _PGSwap64(buffer, length, 0);
+    _PGSwap(buffer, length, 8, 0);
 }
 
 void PGSwap64Alt(void *buffer, long length) {
-    _PGSwap64(buffer, length, 1);
+    _PGSwap(buffer, length, 8, 1);
 }
 
 void PGSwap64AltAlt(void *buffer, long length) {
-    _PGSwap64(buffer, length, 2);
+    _PGSwap(buffer, length, 8, 2);
 }
 
 long PGHostByteOrder(void) {
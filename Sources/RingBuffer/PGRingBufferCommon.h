@@ -0,0 +1,79 @@
+//
+//  PGRingBufferCommon.h
+//  PGRingBuffer
+//
+//  Created by Galen Rhodes on 10/16/26.
+//  Copyright © 2020 Project Galen. All rights reserved.
+//
+//  Private macros shared by the library's source files. Not part of the public API.
+//
+
+#ifndef PGRingBufferCommon_h
+#define PGRingBufferCommon_h
+
+#include "include/PGRingBuffer.h"
+#include <limits.h>
+
+#define pg_Min(x, y)           (((x) < (y)) ? (x) : (y))
+#define pg_Max(x, y)           (((x) > (y)) ? (x) : (y))
+
+#define PG_MIN_POW2_SIZE       (8)
+#define PG_MAX_POW2_SIZE       ((LONG_MAX / 2) + 1)
+
+#if defined(__APPLE__) && defined(__aarch64__)
+    #define PG_CACHE_LINE_SIZE (128)
+#else
+    #define PG_CACHE_LINE_SIZE (64)
+#endif
+
+#define PG_CACHE_ALIGNED __attribute__((__aligned__(PG_CACHE_LINE_SIZE)))
+
+/*
+ * The smallest power of two, no less than `PG_MIN_POW2_SIZE`, that is at least `v`. Returns zero if `v` is more
+ * than the largest power of two a `long` can hold.
+ */
+PG_ALWAYS_INLINE long pgNextPow2(long v) {
+    long p = PG_MIN_POW2_SIZE;
+    if(v > PG_MAX_POW2_SIZE) return 0;
+    while(p < v) p <<= 1;
+    return p;
+}
+
+/*
+ * Swaps the bytes of each whole `bytesPerWord` sized word in `buffer`, picking the widest vector kernel the CPU
+ * supports. `alt` selects the Alt (1) or AltAlt (2) orderings. Lives in PGRingBufferSwap.c.
+ */
+void _PGSwap(void *buffer, long length, long bytesPerWord, int alt);
+
+/*
+ * Same as `_PGSwap` but reads the words from `src` and writes the swapped words to `dest`. `dest` and `src` must
+ * either be the same or not overlap at all.
+ */
+void _PGSwapCopy(void *dest, const void *src, long length, long bytesPerWord, int alt);
+
+/*
+ * Same as `PGRingBufferConsume` except that it never shrinks the buffer. Used where something else might still
+ * be holding pointers into the buffer's storage. Lives in PGRingBuffer.c.
+ */
+void _PGRingBufferConsume(PGRingBuffer *buff, long length);
+
+/*
+ * The most bytes the buffer could ever hold: its capacity if it's overwriting, otherwise the capacity of the
+ * biggest storage its policy would let it grow to. Lives in PGRingBuffer.c.
+ */
+long _PGRingBufferMaxSize(const PGRingBuffer *buff);
+
+/*
+ * `malloc`, `realloc` and `free`. Used when no allocator is given. Lives in PGRingBuffer.c.
+ */
+extern const PGRingBufferAllocator _PGDefaultRingBufferAllocator;
+
+/*
+ * Maps the first `dataOffset + size` bytes of the file `fd` and then maps the `size` bytes at `dataOffset` a second
+ * time straight after themselves, so that anything up to `size` bytes long starting in the first copy is
+ * contiguous. `dataOffset` and `size` must be multiples of the page size. Returns the start of the mapping, which
+ * is `dataOffset + (size * 2)` bytes long, or `NULL`. Lives in PGRingBuffer.c, next to the mirrored storage code.
+ */
+uint8_t *_PGMapMirroredFile(int fd, long dataOffset, long size);
+
+#endif /* PGRingBufferCommon_h */
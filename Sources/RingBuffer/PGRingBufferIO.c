@@ -0,0 +1,75 @@
+//
+//  PGRingBufferIO.c
+//  PGRingBuffer
+//
+//  Created by Galen Rhodes on 10/16/26.
+//  Copyright © 2020 Project Galen. All rights reserved.
+//
+
+#include "include/PGRingBufferIO.h"
+#include "PGRingBufferCommon.h"
+#include <errno.h>
+#include <sys/uio.h>
+
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "OCUnusedGlobalDeclarationInspection"
+
+PG_ALWAYS_INLINE int pgSpansToIOVec(const PGRingBufferSpan spans[2], struct iovec iov[2]) {
+    iov[0].iov_base = spans[0].bytes;
+    iov[0].iov_len  = (size_t)spans[0].length;
+    iov[1].iov_base = spans[1].bytes;
+    iov[1].iov_len  = (size_t)spans[1].length;
+    return ((spans[1].length > 0) ? 2 : 1);
+}
+
+long PGRingBufferReadFromFd(PGRingBuffer *buff, int fd, long maxLength) {
+    if(maxLength > 0) {
+        PGRingBufferSpan spans[2];
+        struct iovec     iov[2];
+
+        // An overwriting buffer can never hold more than its capacity. The oldest bytes are only dropped for what
+        // is actually read.
+        if(buff->flags & PG_RINGBUFFER_OVERWRITE) maxLength = pg_Min(maxLength, PGRingBufferCapacity(buff));
+
+        if(PGRingBufferReserve(buff, maxLength, spans) < maxLength) {
+            errno = ENOMEM;
+            return -1;
+        }
+
+        int     cnt = pgSpansToIOVec(spans, iov);
+        ssize_t rc;
+
+        do { rc = readv(fd, iov, cnt); } while((rc < 0) && (errno == EINTR));
+
+        if(rc > 0) PGRingBufferCommit(buff, (long)rc);
+        return (long)rc;
+    }
+
+    return 0;
+}
+
+long PGRingBufferWriteToFd(PGRingBuffer *buff, int fd, long maxLength) {
+    PGRingBufferSpan spans[2];
+    struct iovec     iov[2];
+    long             cc = PGPeekSpansFromRingBuffer(buff, spans);
+
+    if((maxLength > 0) && (maxLength < cc)) {
+        spans[0].length = pg_Min(maxLength, spans[0].length);
+        spans[1].length = (maxLength - spans[0].length);
+        cc              = maxLength;
+    }
+
+    if(cc > 0) {
+        int     cnt = pgSpansToIOVec(spans, iov);
+        ssize_t rc;
+
+        do { rc = writev(fd, iov, cnt); } while((rc < 0) && (errno == EINTR));
+
+        if(rc > 0) PGRingBufferConsume(buff, (long)rc);
+        return (long)rc;
+    }
+
+    return 0;
+}
+
+#pragma clang diagnostic pop
@@ -0,0 +1,537 @@
+//
+//  PGRingBufferIOEngine.c
+//  PGRingBuffer
+//
+//  Created by Galen Rhodes on 10/16/26.
+//  Copyright © 2020 Project Galen. All rights reserved.
+//
+
+#include "include/PGRingBufferIOEngine.h"
+#include "PGRingBufferCommon.h"
+#include <errno.h>
+#include <sys/uio.h>
+
+#if defined(__linux__) && defined(__has_include)
+    #if __has_include(<linux/io_uring.h>)
+        #include <linux/io_uring.h>
+        #include <sys/mman.h>
+        #include <sys/syscall.h>
+        #define PG_HAS_IO_URING 1
+    #endif
+#endif
+
+#ifndef PG_HAS_IO_URING
+    #define PG_HAS_IO_URING 0
+#endif
+
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "OCUnusedGlobalDeclarationInspection"
+
+typedef struct _st_pg_io_op_ {
+    PGRingBuffer           *buff;
+    int                    fd;
+    bool                   isWrite;
+    long                   result;
+    PGRingBufferIOCallback callback;
+    void                   *context;
+    struct iovec           iov[2];
+    struct _st_pg_io_op_   *next;
+}               PGIOOp;
+
+typedef struct _st_pg_io_reg_ {
+    PGRingBuffer *buff;
+    uint8_t      *base;
+    long         length;
+}               PGIOReg;
+
+struct _st_pg_ringbuffer_io_engine_ {
+    int      ringFd;
+    long     inFlight;
+    PGIOOp   *ops;
+    unsigned opCount;
+    PGIOOp   *freeOps;
+    PGIOOp   *doneHead;
+    PGIOOp   *doneTail;
+    PGIOReg  *regs;
+    int      regCount;
+    bool     regActive;
+    bool     regDirty;
+
+#if PG_HAS_IO_URING
+    unsigned            features;
+    unsigned            toSubmit;
+    unsigned            *sqHead;
+    unsigned            *sqTail;
+    unsigned            *sqMask;
+    unsigned            *sqArray;
+    unsigned            sqEntries;
+    struct io_uring_sqe *sqes;
+    unsigned            *cqHead;
+    unsigned            *cqTail;
+    unsigned            *cqMask;
+    struct io_uring_cqe *cqes;
+    void                *sqRing;
+    size_t              sqRingSize;
+    void                *cqRing;
+    size_t              cqRingSize;
+    size_t              sqesSize;
+#endif
+};
+
+#define pgRegLength(b) (PGRingBufferIsMirrored(b) ? ((b)->size * 2) : (b)->size)
+
+PG_ALWAYS_INLINE PGIOOp *pgTakeOp(PGRingBufferIOEngine *engine, PGRingBuffer *buff, int fd, bool isWrite, PGRingBufferIOCallback callback, void *context) {
+    PGIOOp *op = engine->freeOps;
+
+    if(op) {
+        engine->freeOps = op->next;
+        op->buff        = buff;
+        op->fd          = fd;
+        op->isWrite     = isWrite;
+        op->result      = 0;
+        op->callback    = callback;
+        op->context     = context;
+        op->next        = NULL;
+    }
+
+    return op;
+}
+
+PG_ALWAYS_INLINE void pgGiveOp(PGRingBufferIOEngine *engine, PGIOOp *op) {
+    op->buff        = NULL;
+    op->next        = engine->freeOps;
+    engine->freeOps = op;
+}
+
+/*
+ * Whether any operation that hasn't been reported yet is on the ring buffer. Free operations have no buffer.
+ */
+static bool pgHasOpOn(const PGRingBufferIOEngine *engine, const PGRingBuffer *buff) {
+    if(engine->inFlight > 0) {
+        for(unsigned i = 0; i < engine->opCount; ++i) if(engine->ops[i].buff == buff) return true;
+    }
+    return false;
+}
+
+PG_ALWAYS_INLINE void pgQueueDone(PGRingBufferIOEngine *engine, PGIOOp *op) {
+    if(engine->doneTail) engine->doneTail->next = op; else engine->doneHead = op;
+    engine->doneTail = op;
+}
+
+/*
+ * Advance the ring buffer the same way PGRingBufferReadFromFd/PGRingBufferWriteToFd do and report it.
+ */
+PG_ALWAYS_INLINE void pgFinishOp(PGRingBufferIOEngine *engine, PGIOOp *op, bool notify) {
+    if(op->result > 0) {
+        if(op->isWrite) _PGRingBufferConsume(op->buff, op->result); else PGRingBufferCommit(op->buff, op->result);
+    }
+    engine->inFlight--;
+    if(notify && op->callback) op->callback(op->buff, op->fd, op->isWrite, op->result, op->context);
+    pgGiveOp(engine, op);
+}
+
+#if PG_HAS_IO_URING
+
+PG_ALWAYS_INLINE int pgUringEnter(PGRingBufferIOEngine *engine, unsigned toSubmit, unsigned minComplete) {
+    unsigned flags = ((minComplete > 0) ? IORING_ENTER_GETEVENTS : 0);
+    long     rc;
+
+    do { rc = syscall(__NR_io_uring_enter, engine->ringFd, toSubmit, minComplete, flags, NULL, 0); } while((rc < 0) && (errno == EINTR));
+    return (int)rc;
+}
+
+static bool pgUringSetup(PGRingBufferIOEngine *engine, unsigned entries) {
+    struct io_uring_params p;
+
+    memset(&p, 0, sizeof(p));
+    int fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+    if(fd < 0) return false;
+
+    engine->ringFd     = fd;
+    engine->features   = p.features;
+    engine->sqRingSize = (p.sq_off.array + (p.sq_entries * sizeof(unsigned)));
+    engine->cqRingSize = (p.cq_off.cqes + (p.cq_entries * sizeof(struct io_uring_cqe)));
+    engine->sqesSize   = (p.sq_entries * sizeof(struct io_uring_sqe));
+
+    if(p.features & IORING_FEAT_SINGLE_MMAP) engine->sqRingSize = engine->cqRingSize = pg_Max(engine->sqRingSize, engine->cqRingSize);
+
+    engine->sqRing = mmap(NULL, engine->sqRingSize, (PROT_READ | PROT_WRITE), (MAP_SHARED | MAP_POPULATE), fd, IORING_OFF_SQ_RING);
+    if(engine->sqRing == MAP_FAILED) goto fail;
+
+    if(p.features & IORING_FEAT_SINGLE_MMAP) {
+        engine->cqRing = engine->sqRing;
+    }
+    else {
+        engine->cqRing = mmap(NULL, engine->cqRingSize, (PROT_READ | PROT_WRITE), (MAP_SHARED | MAP_POPULATE), fd, IORING_OFF_CQ_RING);
+        if(engine->cqRing == MAP_FAILED) goto fail_sq;
+    }
+
+    engine->sqes = mmap(NULL, engine->sqesSize, (PROT_READ | PROT_WRITE), (MAP_SHARED | MAP_POPULATE), fd, IORING_OFF_SQES);
+    if(engine->sqes == MAP_FAILED) goto fail_cq;
+
+    uint8_t *sq = engine->sqRing;
+    uint8_t *cq = engine->cqRing;
+
+    engine->sqHead    = (unsigned *)(sq + p.sq_off.head);
+    engine->sqTail    = (unsigned *)(sq + p.sq_off.tail);
+    engine->sqMask    = (unsigned *)(sq + p.sq_off.ring_mask);
+    engine->sqArray   = (unsigned *)(sq + p.sq_off.array);
+    engine->sqEntries = p.sq_entries;
+    engine->cqHead    = (unsigned *)(cq + p.cq_off.head);
+    engine->cqTail    = (unsigned *)(cq + p.cq_off.tail);
+    engine->cqMask    = (unsigned *)(cq + p.cq_off.ring_mask);
+    engine->cqes      = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+    engine->toSubmit  = 0;
+    return true;
+
+fail_cq:
+    if(engine->cqRing != engine->sqRing) munmap(engine->cqRing, engine->cqRingSize);
+fail_sq:
+    munmap(engine->sqRing, engine->sqRingSize);
+fail:
+    close(fd);
+    engine->ringFd = -1;
+    return false;
+}
+
+static void pgUringTeardown(PGRingBufferIOEngine *engine) {
+    munmap(engine->sqes, engine->sqesSize);
+    if(engine->cqRing != engine->sqRing) munmap(engine->cqRing, engine->cqRingSize);
+    munmap(engine->sqRing, engine->sqRingSize);
+    close(engine->ringFd);
+    engine->ringFd = -1;
+}
+
+/*
+ * Buffers can only be (re)registered as a whole table and, on older kernels, only while the ring is idle.
+ */
+static void pgUringRefreshRegistrations(PGRingBufferIOEngine *engine) {
+    for(int i = 0; i < engine->regCount; ++i) {
+        PGIOReg *r = &engine->regs[i];
+        if((r->base != r->buff->buffer) || (r->length != pgRegLength(r->buff))) engine->regDirty = true;
+    }
+
+    if(engine->regDirty && (engine->inFlight == 0)) {
+        if(engine->regActive) {
+            syscall(__NR_io_uring_register, engine->ringFd, IORING_UNREGISTER_BUFFERS, NULL, 0);
+            engine->regActive = false;
+        }
+
+        if(engine->regCount) {
+            struct iovec iov[engine->regCount];
+
+            for(int i = 0; i < engine->regCount; ++i) {
+                PGIOReg *r = &engine->regs[i];
+                r->base        = r->buff->buffer;
+                r->length      = pgRegLength(r->buff);
+                iov[i].iov_base = r->base;
+                iov[i].iov_len  = (size_t)r->length;
+            }
+
+            // If this fails (RLIMIT_MEMLOCK for instance) then we just don't use fixed buffers.
+            engine->regActive = (syscall(__NR_io_uring_register, engine->ringFd, IORING_REGISTER_BUFFERS, iov, engine->regCount) == 0);
+        }
+
+        engine->regDirty = false;
+    }
+}
+
+PG_ALWAYS_INLINE int pgUringFixedIndex(PGRingBufferIOEngine *engine, PGRingBuffer *buff) {
+    if(engine->regActive && !engine->regDirty) {
+        for(int i = 0; i < engine->regCount; ++i) if(engine->regs[i].buff == buff) return i;
+    }
+    return -1;
+}
+
+static struct io_uring_sqe *pgUringGetSQE(PGRingBufferIOEngine *engine) {
+    unsigned tail = *engine->sqTail;
+
+    if((tail - __atomic_load_n(engine->sqHead, __ATOMIC_ACQUIRE)) >= engine->sqEntries) {
+        if(pgUringEnter(engine, engine->toSubmit, 0) >= 0) engine->toSubmit = 0;
+        if((tail - __atomic_load_n(engine->sqHead, __ATOMIC_ACQUIRE)) >= engine->sqEntries) return NULL;
+    }
+
+    struct io_uring_sqe *sqe = &engine->sqes[tail & *engine->sqMask];
+    memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+PG_ALWAYS_INLINE void pgUringPushSQE(PGRingBufferIOEngine *engine) {
+    unsigned tail = *engine->sqTail;
+
+    engine->sqArray[tail & *engine->sqMask] = (tail & *engine->sqMask);
+    __atomic_store_n(engine->sqTail, (tail + 1), __ATOMIC_RELEASE);
+    engine->toSubmit++;
+}
+
+static bool pgUringQueue(PGRingBufferIOEngine *engine, PGIOOp *op, int cnt) {
+    pgUringRefreshRegistrations(engine);
+
+    struct io_uring_sqe *sqe = pgUringGetSQE(engine);
+    if(sqe == NULL) return false;
+
+    int idx = ((cnt == 1) ? pgUringFixedIndex(engine, op->buff) : -1);
+
+    if(idx >= 0) {
+        sqe->opcode    = (op->isWrite ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED);
+        sqe->addr      = (uint64_t)(uintptr_t)op->iov[0].iov_base;
+        sqe->len       = (uint32_t)op->iov[0].iov_len;
+        sqe->buf_index = (uint16_t)idx;
+    }
+    else {
+        sqe->opcode = (op->isWrite ? IORING_OP_WRITEV : IORING_OP_READV);
+        sqe->addr   = (uint64_t)(uintptr_t)op->iov;
+        sqe->len    = (uint32_t)cnt;
+    }
+
+    sqe->fd        = op->fd;
+    sqe->off       = ((engine->features & IORING_FEAT_RW_CUR_POS) ? (uint64_t)-1 : 0);
+    sqe->user_data = (uint64_t)(uintptr_t)op;
+    pgUringPushSQE(engine);
+    return true;
+}
+
+static int pgUringReap(PGRingBufferIOEngine *engine, bool notify) {
+    unsigned head = *engine->cqHead;
+    unsigned tail = __atomic_load_n(engine->cqTail, __ATOMIC_ACQUIRE);
+    int      cc   = 0;
+
+    while(head != tail) {
+        struct io_uring_cqe *cqe = &engine->cqes[head & *engine->cqMask];
+        PGIOOp              *op  = (PGIOOp *)(uintptr_t)cqe->user_data;
+
+        op->result = cqe->res;
+        head++;
+        __atomic_store_n(engine->cqHead, head, __ATOMIC_RELEASE);
+        pgFinishOp(engine, op, notify);
+        cc++;
+    }
+
+    return cc;
+}
+
+#endif
+
+PGRingBufferIOEngine *PGCreateRingBufferIOEngine(int entries, bool useFallback) {
+    PGRingBufferIOEngine *engine = NULL;
+
+    if(entries < 1) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    if((engine = calloc(1, sizeof(PGRingBufferIOEngine)))) {
+        unsigned n = 8;
+        while(n < (unsigned)entries) n <<= 1;
+
+        engine->ringFd  = -1;
+        engine->ops     = calloc(n, sizeof(PGIOOp));
+        engine->opCount = n;
+
+        if(engine->ops) {
+            for(unsigned i = 0; i < n; ++i) pgGiveOp(engine, &engine->ops[i]);
+#if PG_HAS_IO_URING
+            if(!useFallback) pgUringSetup(engine, n);
+#else
+            (void)useFallback;
+#endif
+            return engine;
+        }
+
+        free(engine);
+    }
+
+    return NULL;
+}
+
+void PGDiscardRingBufferIOEngine(PGRingBufferIOEngine *engine) {
+    if(engine) {
+#if PG_HAS_IO_URING
+        if(engine->ringFd >= 0) {
+            while(engine->inFlight > 0) {
+                if(pgUringEnter(engine, engine->toSubmit, 1) < 0) break;
+                engine->toSubmit = 0;
+                pgUringReap(engine, false);
+            }
+            pgUringTeardown(engine);
+        }
+#endif
+        free(engine->regs);
+        free(engine->ops);
+        free(engine);
+    }
+}
+
+bool PGRingBufferIOEngineIsAsync(const PGRingBufferIOEngine *engine) {
+    return (engine->ringFd >= 0);
+}
+
+bool PGRingBufferIOEngineRegister(PGRingBufferIOEngine *engine, PGRingBuffer *buff) {
+    if(engine->ringFd < 0) return true;
+
+    for(int i = 0; i < engine->regCount; ++i) if(engine->regs[i].buff == buff) return true;
+
+    PGIOReg *regs = realloc(engine->regs, ((size_t)(engine->regCount + 1) * sizeof(PGIOReg)));
+    if(regs == NULL) return false;
+
+    regs[engine->regCount].buff   = buff;
+    regs[engine->regCount].base   = NULL;
+    regs[engine->regCount].length = 0;
+    engine->regs = regs;
+    engine->regCount++;
+    engine->regDirty = true;
+    return true;
+}
+
+void PGRingBufferIOEngineUnregister(PGRingBufferIOEngine *engine, PGRingBuffer *buff) {
+    for(int i = 0; i < engine->regCount; ++i) {
+        if(engine->regs[i].buff == buff) {
+            engine->regs[i] = engine->regs[--engine->regCount];
+            engine->regDirty = true;
+#if PG_HAS_IO_URING
+            // The kernel has to let go of the pages before the caller frees them.
+            if(engine->regActive) {
+                syscall(__NR_io_uring_register, engine->ringFd, IORING_UNREGISTER_BUFFERS, NULL, 0);
+                engine->regActive = false;
+            }
+#endif
+            return;
+        }
+    }
+}
+
+bool PGRingBufferIOEngineSubmitRead(PGRingBufferIOEngine *engine, PGRingBuffer *buff, int fd, long maxLength, PGRingBufferIOCallback callback, void *context) {
+    // An overwriting buffer's oldest bytes are still there to be read until the read completes, so it only reads
+    // into the room that's already free.
+    if(buff->flags & PG_RINGBUFFER_OVERWRITE) maxLength = pg_Min(maxLength, PGRingBufferRemaining(buff));
+    if(maxLength <= 0) return false;
+
+    PGIOOp *op = pgTakeOp(engine, buff, fd, false, callback, context);
+    if(op == NULL) return false;
+
+#if PG_HAS_IO_URING
+    if(engine->ringFd >= 0) {
+        PGRingBufferSpan spans[2];
+
+        // A write that's already in flight points into the storage so it can't be resized or moved now. Only
+        // the room that's already free can be read into.
+        if(pgHasOpOn(engine, buff)) maxLength = pg_Min(maxLength, PGRingBufferRemaining(buff));
+
+        if((maxLength > 0) && (PGRingBufferReserve(buff, maxLength, spans) == maxLength)) {
+            op->iov[0].iov_base = spans[0].bytes;
+            op->iov[0].iov_len  = (size_t)spans[0].length;
+            op->iov[1].iov_base = spans[1].bytes;
+            op->iov[1].iov_len  = (size_t)spans[1].length;
+
+            if(pgUringQueue(engine, op, ((spans[1].length > 0) ? 2 : 1))) {
+                engine->inFlight++;
+                return true;
+            }
+        }
+
+        pgGiveOp(engine, op);
+        return false;
+    }
+#endif
+
+    long rc = PGRingBufferReadFromFd(buff, fd, maxLength);
+
+    if((rc < 0) && (errno == ENOMEM)) {
+        pgGiveOp(engine, op);
+        return false;
+    }
+
+    // The ring buffer has already been advanced so the result is only reported.
+    op->result = ((rc < 0) ? -errno : rc);
+    engine->inFlight++;
+    pgQueueDone(engine, op);
+    return true;
+}
+
+bool PGRingBufferIOEngineSubmitWrite(PGRingBufferIOEngine *engine, PGRingBuffer *buff, int fd, long maxLength, PGRingBufferIOCallback callback, void *context) {
+    if(PGRingBufferCount(buff) == 0) return false;
+
+    PGIOOp *op = pgTakeOp(engine, buff, fd, true, callback, context);
+    if(op == NULL) return false;
+
+#if PG_HAS_IO_URING
+    if(engine->ringFd >= 0) {
+        PGRingBufferSpan spans[2];
+        long             cc = PGPeekSpansFromRingBuffer(buff, spans);
+
+        if((maxLength > 0) && (maxLength < cc)) {
+            spans[0].length = pg_Min(maxLength, spans[0].length);
+            spans[1].length = (maxLength - spans[0].length);
+        }
+
+        op->iov[0].iov_base = spans[0].bytes;
+        op->iov[0].iov_len  = (size_t)spans[0].length;
+        op->iov[1].iov_base = spans[1].bytes;
+        op->iov[1].iov_len  = (size_t)spans[1].length;
+
+        if(pgUringQueue(engine, op, ((spans[1].length > 0) ? 2 : 1))) {
+            engine->inFlight++;
+            return true;
+        }
+
+        pgGiveOp(engine, op);
+        return false;
+    }
+#endif
+
+    long rc = PGRingBufferWriteToFd(buff, fd, maxLength);
+
+    op->result = ((rc < 0) ? -errno : rc);
+    engine->inFlight++;
+    pgQueueDone(engine, op);
+    return true;
+}
+
+int PGRingBufferIOEngineSubmit(PGRingBufferIOEngine *engine) {
+#if PG_HAS_IO_URING
+    if((engine->ringFd >= 0) && engine->toSubmit) {
+        int rc = pgUringEnter(engine, engine->toSubmit, 0);
+        if(rc > 0) engine->toSubmit -= (unsigned)rc;
+        return rc;
+    }
+#endif
+    return 0;
+}
+
+int PGRingBufferIOEngineComplete(PGRingBufferIOEngine *engine, int minComplete) {
+    int cc = 0;
+
+#if PG_HAS_IO_URING
+    if(engine->ringFd >= 0) {
+        unsigned wait = (unsigned)pg_Max(0, pg_Min(minComplete, engine->inFlight));
+        int      rc   = ((engine->toSubmit || wait) ? pgUringEnter(engine, engine->toSubmit, wait) : 0);
+
+        if(rc < 0) return -1;
+        engine->toSubmit -= (unsigned)pg_Min((unsigned)rc, engine->toSubmit);
+        return pgUringReap(engine, true);
+    }
+#else
+    (void)minComplete;
+#endif
+
+    while(engine->doneHead) {
+        PGIOOp *op = engine->doneHead;
+
+        engine->doneHead = op->next;
+        if(engine->doneHead == NULL) engine->doneTail = NULL;
+
+        // Already applied to the ring buffer when it was submitted.
+        engine->inFlight--;
+        if(op->callback) op->callback(op->buff, op->fd, op->isWrite, op->result, op->context);
+        pgGiveOp(engine, op);
+        cc++;
+    }
+
+    return cc;
+}
+
+long PGRingBufferIOEngineInFlight(const PGRingBufferIOEngine *engine) {
+    return engine->inFlight;
+}
+
+#pragma clang diagnostic pop
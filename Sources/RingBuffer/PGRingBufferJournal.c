@@ -0,0 +1,458 @@
+//
+//  PGRingBufferJournal.c
+//  PGRingBuffer
+//
+//  Created by Galen Rhodes on 10/16/26.
+//  Copyright © 2020 Project Galen. All rights reserved.
+//
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+    #define _GNU_SOURCE
+#endif
+
+#include "include/PGRingBufferJournal.h"
+#include "PGRingBufferCommon.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+    #define PG_CRC_X86 1
+    #include <immintrin.h>
+#else
+    #define PG_CRC_X86 0
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+    #define PG_CRC_ARM 1
+    #include <arm_acle.h>
+#else
+    #define PG_CRC_ARM 0
+#endif
+
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "OCUnusedGlobalDeclarationInspection"
+
+#define PG_JOURNAL_MAGIC    (0x50474a4e)  // "PGJN"
+#define PG_JOURNAL_MAX_SIZE (LONG_MAX / 4)
+#define PG_CRC32C_POLY      (0x82f63b78)
+
+#define pgPadded(l)         (((l) + 7) & ~7L)
+#define pgFramed(l)         (PG_RINGBUFFER_JOURNAL_FRAMING + pgPadded(l))
+#define pgFrameAt(b, p)     ((PGJournalFrame *)((b)->buffer + ((p) & (b)->mask)))
+#define pgMapSize(b)        ((size_t)((b)->header->dataOffset + ((b)->size * 2)))
+
+/*
+ * What lives at the start of the file. The records follow at `dataOffset`, which is a whole number of pages. `head`
+ * and `tail` are positions that only ever increase, the same as in PGSPSCRingBuffer, and are masked to get the
+ * index into the storage. The saved `tail` only ever covers records that an earlier sync has already made durable,
+ * so it can be trusted without checking those records. `generation` goes up by one every time the journal is
+ * recovered and is made durable, along with the recovered tail, before anything is appended. The whole header fits
+ * in one sector so a write of it is never torn.
+ */
+typedef struct _st_pg_journal_header_ {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t dataOffset;
+    int64_t  size;
+    int64_t  head;
+    int64_t  tail;
+    int64_t  generation;
+} PGJournalHeader;
+
+/*
+ * In front of every record. The checksum covers the record's position and generation as well as its length and
+ * bytes. The position means a stale record left over from the last time around the ring never looks valid. The
+ * generation catches the one the position can't: a record written before a crash that the recovered tail has
+ * since been rewound over, which sits at exactly the position the next record appended after it would have.
+ */
+typedef struct _st_pg_journal_frame_ {
+    uint32_t length;
+    uint32_t crc;
+    int64_t  generation;
+} PGJournalFrame;
+
+_Static_assert(sizeof(PGJournalFrame) == PG_RINGBUFFER_JOURNAL_FRAMING, "The framing has to match the header.");
+
+/*
+ * `head` and `tail` are where the journal is in memory. `syncedHead` and `syncedTail` are where it was at the last
+ * successful commit. Appends never reuse room before `syncedHead` because after a crash the records there would
+ * still be expected.
+ */
+struct _st_pg_ringbuffer_journal_ {
+    PGJournalHeader *header;
+    uint8_t         *buffer;
+    long            size;
+    long            mask;
+    int             fd;
+    long            head;
+    long            tail;
+    long            syncedHead;
+    long            syncedTail;
+    long            generation;
+};
+
+/*
+ * CRC-32C (Castagnoli), which SSE 4.2 and ARMv8 both have instructions for. The table is only for CPUs without them.
+ */
+static uint32_t       pgCrcTable[256];
+static pthread_once_t pgCrcOnce = PTHREAD_ONCE_INIT;
+
+static void pgCrcInit(void) {
+    for(uint32_t i = 0; i < 256; ++i) {
+        uint32_t c = i;
+        for(int j = 0; j < 8; ++j) c = ((c & 1) ? ((c >> 1) ^ PG_CRC32C_POLY) : (c >> 1));
+        pgCrcTable[i] = c;
+    }
+}
+
+static uint32_t pgCrcScalar(uint32_t crc, const uint8_t *p, long length) {
+    pthread_once(&pgCrcOnce, pgCrcInit);
+    for(long i = 0; i < length; ++i) crc = (pgCrcTable[((crc ^ p[i]) & 0xff)] ^ (crc >> 8));
+    return crc;
+}
+
+#if PG_CRC_X86
+
+__attribute__((__target__("sse4.2"))) static uint32_t pgCrcSSE42(uint32_t crc, const uint8_t *p, long length) {
+    long i = 0;
+
+#if defined(__x86_64__)
+    uint64_t c = crc;
+
+    for(; (i + 8) <= length; i += 8) {
+        uint64_t w;
+        memcpy(&w, (p + i), 8);
+        c = _mm_crc32_u64(c, w);
+    }
+    crc = (uint32_t)c;
+#endif
+    for(; i < length; ++i) crc = _mm_crc32_u8(crc, p[i]);
+
+    return crc;
+}
+
+#endif
+
+#if PG_CRC_ARM
+
+static uint32_t pgCrcARM(uint32_t crc, const uint8_t *p, long length) {
+    long i = 0;
+
+    for(; (i + 8) <= length; i += 8) {
+        uint64_t w;
+        memcpy(&w, (p + i), 8);
+        crc = __crc32cd(crc, w);
+    }
+    for(; i < length; ++i) crc = __crc32cb(crc, p[i]);
+
+    return crc;
+}
+
+#endif
+
+static uint32_t pgCrc32c(uint32_t crc, const void *src, long length) {
+#if PG_CRC_X86
+    // __builtin_cpu_supports() is just a test of a flag that libgcc/compiler-rt fills in once at startup.
+    if(__builtin_cpu_supports("sse4.2")) return pgCrcSSE42(crc, src, length);
+#elif PG_CRC_ARM
+    return pgCrcARM(crc, src, length);
+#endif
+    return pgCrcScalar(crc, src, length);
+}
+
+static uint32_t pgRecordCrc(long position, const PGJournalFrame *frame) {
+    int64_t  p   = position;
+    uint32_t crc = pgCrc32c(0xffffffff, &p, sizeof(p));
+
+    crc = pgCrc32c(crc, &frame->generation, sizeof(frame->generation));
+    crc = pgCrc32c(crc, &frame->length, sizeof(frame->length));
+    return ~pgCrc32c(crc, (frame + 1), frame->length);
+}
+
+PG_ALWAYS_INLINE long pgPageSize(void) {
+    return sysconf(_SC_PAGESIZE);
+}
+
+/*
+ * Makes everything written to the mapping so far durable. On Linux the pages written through the mapping are just
+ * dirty pages of the file so one fdatasync covers the header and the records together. Elsewhere the header and
+ * the records written since `from` are each synced with msync.
+ */
+static bool pgSync(PGRingBufferJournal *buff, long from, long to) {
+#if defined(__linux__)
+    (void)from;
+    (void)to;
+    return (fdatasync(buff->fd) == 0);
+#else
+    long     p     = pgPageSize();
+    uint8_t  *base = (uint8_t *)buff->header;
+    long     start = ((buff->header->dataOffset + (from & buff->mask)) & ~(p - 1));
+    long     end   = (buff->header->dataOffset + (from & buff->mask) + (to - from));
+
+    // The records might run on into the second copy of the storage but that is the same pages of the same file.
+    if((to > from) && (msync((base + start), (size_t)(end - start), MS_SYNC) != 0)) return false;
+    return (msync(base, (size_t)p, MS_SYNC) == 0);
+#endif
+}
+
+static PGRingBufferJournal *pgJournalMap(int fd, long dataOffset, long size) {
+    PGRingBufferJournal *buff = malloc(sizeof(PGRingBufferJournal));
+
+    if(buff) {
+        uint8_t *base = _PGMapMirroredFile(fd, dataOffset, size);
+
+        if(base) {
+            buff->header = (PGJournalHeader *)base;
+            buff->buffer = (base + dataOffset);
+            buff->size   = size;
+            buff->mask   = (size - 1);
+            buff->fd     = fd;
+            return buff;
+        }
+        free(buff);
+    }
+    else {
+        errno = ENOMEM;
+    }
+
+    return NULL;
+}
+
+static PGRingBufferJournal *pgJournalCreate(int fd, long capacity) {
+    long dataOffset = pgPageSize();
+    long size       = dataOffset;
+
+    if(capacity > PG_JOURNAL_MAX_SIZE) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    while((long)sizeof(PGJournalHeader) > dataOffset) dataOffset += pgPageSize();
+    while(size < capacity) size <<= 1;
+
+    if(ftruncate(fd, (off_t)(dataOffset + size)) == 0) {
+        PGRingBufferJournal *buff = pgJournalMap(fd, dataOffset, size);
+
+        if(buff) {
+            PGJournalHeader *h = buff->header;
+
+            // A freshly truncated file is all zeros so the head, the tail, and the generation are already zero.
+            h->version       = PG_RINGBUFFER_JOURNAL_VERSION;
+            h->headerSize    = (uint32_t)sizeof(PGJournalHeader);
+            h->dataOffset    = (uint32_t)dataOffset;
+            h->size          = size;
+            h->magic         = PG_JOURNAL_MAGIC;
+            buff->head       = buff->tail       = 0;
+            buff->syncedHead = buff->syncedTail = 0;
+            buff->generation = 0;
+            if(pgSync(buff, 0, 0)) return buff;
+
+            int err = errno;
+            munmap(buff->header, pgMapSize(buff));
+            free(buff);
+            errno = err;
+        }
+
+        // Leave it empty so that the next open tries again rather than seeing half a header.
+        int err = errno;
+        int r   = ftruncate(fd, 0);
+        (void)r;
+        errno = err;
+    }
+
+    return NULL;
+}
+
+/*
+ * Walks forward from the saved tail over the records whose checksums are good. These are the records that were
+ * synced by the last commit, and possibly some that were written after it and happened to reach the file anyway.
+ * The walk stops at the first record that is torn, stale, or was never written. Everything after the saved tail
+ * was appended since the header's generation was saved and generations never go down along the walk, so a record
+ * with a lower generation than the one before it (or than the header's, for the first) is from an earlier life.
+ */
+static long pgRecoverTail(const PGRingBufferJournal *buff, long tail, long generation) {
+    for(;;) {
+        long           room = (buff->size - (tail - buff->head));
+        PGJournalFrame *f   = pgFrameAt(buff, tail);
+
+        if((room < PG_RINGBUFFER_JOURNAL_FRAMING) || (pgFramed((long)f->length) > room)) break;
+        if((f->generation < generation) || (f->crc != pgRecordCrc(tail, f))) break;
+        generation = (long)f->generation;
+        tail += pgFramed((long)f->length);
+    }
+
+    return tail;
+}
+
+static PGRingBufferJournal *pgJournalRecover(int fd, off_t fileSize) {
+    PGJournalHeader h;
+    long            p = pgPageSize();
+
+    if(pread(fd, &h, sizeof(h), 0) != (ssize_t)sizeof(h)) {
+        errno = EPROTO;
+        return NULL;
+    }
+
+    long o = (long)h.dataOffset;
+    long s = (long)h.size;
+
+    if((h.magic != PG_JOURNAL_MAGIC) || (h.version != PG_RINGBUFFER_JOURNAL_VERSION) || (h.headerSize != sizeof(PGJournalHeader)) ||
+       (o < (long)sizeof(PGJournalHeader)) || ((o % p) != 0) || (s < p) || (s > PG_JOURNAL_MAX_SIZE) || ((s & (s - 1)) != 0) ||
+       (fileSize != (off_t)(o + s)) || (h.head < 0) || (h.tail < 0) || (h.tail > (h.head + s)) || (h.head > (h.tail + s)) ||
+       (h.generation < 0) || (h.generation == INT64_MAX)) {
+        errno = EPROTO;
+        return NULL;
+    }
+
+    PGRingBufferJournal *buff = pgJournalMap(fd, o, s);
+
+    if(buff) {
+        // The head is saved by the same sync as the records after the saved tail so it can be past the saved tail.
+        // Anything between the two had been consumed anyway.
+        buff->head       = (long)h.head;
+        buff->tail       = pgRecoverTail(buff, pg_Max((long)h.tail, buff->head), (long)h.generation);
+        buff->generation = (long)(h.generation + 1);
+
+        // What was recovered might only have reached the page cache so make it durable before trusting it. Only
+        // then are the recovered tail and the new generation saved, and they have to be durable before anything
+        // is appended so that nothing appended from now on can be mistaken for what was past the tail before.
+        if(pgSync(buff, buff->head, buff->tail)) {
+            buff->header->tail       = buff->tail;
+            buff->header->generation = buff->generation;
+
+            if(pgSync(buff, buff->tail, buff->tail)) {
+                buff->syncedHead = buff->head;
+                buff->syncedTail = buff->tail;
+                return buff;
+            }
+        }
+
+        int err = errno;
+        munmap(buff->header, pgMapSize(buff));
+        free(buff);
+        errno = err;
+    }
+
+    return NULL;
+}
+
+PGRingBufferJournal *PGOpenRingBufferJournal(const char *path, long capacity) {
+    PGRingBufferJournal *buff = NULL;
+    struct stat         st;
+    int                 fd    = open(path, (O_RDWR | O_CREAT | O_CLOEXEC), 0644);
+
+    if(fd < 0) return NULL;
+
+    if((flock(fd, (LOCK_EX | LOCK_NB)) == 0) && (fstat(fd, &st) == 0)) {
+        buff = ((st.st_size == 0) ? pgJournalCreate(fd, capacity) : pgJournalRecover(fd, st.st_size));
+    }
+
+    if(buff == NULL) {
+        int err = errno;
+        close(fd);
+        errno = err;
+    }
+
+    return buff;
+}
+
+bool PGCloseRingBufferJournal(PGRingBufferJournal *buff) {
+    bool ok = true;
+
+    if(buff) {
+        ok = PGCommitRingBufferJournal(buff);
+
+        // Save the exact tail so that the next open has nothing to walk over.
+        if(ok && (buff->header->tail != buff->syncedTail)) {
+            buff->header->tail = buff->syncedTail;
+            ok = pgSync(buff, buff->syncedTail, buff->syncedTail);
+        }
+
+        munmap(buff->header, pgMapSize(buff));
+        close(buff->fd);
+        free(buff);
+    }
+
+    return ok;
+}
+
+bool PGAppendToRingBufferJournal(PGRingBufferJournal *buff, const void *src, long length) {
+    if((length < 0) || ((src == NULL) && (length > 0)) || (length > UINT32_MAX)) return false;
+
+    long framed = pgFramed(length);
+
+    if((buff->tail + framed - buff->syncedHead) > buff->size) return false;
+
+    PGJournalFrame *f = pgFrameAt(buff, buff->tail);
+
+    f->length     = (uint32_t)length;
+    f->generation = buff->generation;
+    if(length) PGMemCpy((f + 1), src, length);
+    f->crc = pgRecordCrc(buff->tail, f);
+    buff->tail += framed;
+    return true;
+}
+
+bool PGCommitRingBufferJournal(PGRingBufferJournal *buff) {
+    long head = buff->head;
+    long tail = buff->tail;
+
+    if((head == buff->syncedHead) && (tail == buff->syncedTail)) return true;
+
+    // The saved tail only moves up to what the last commit made durable. What this commit syncs is found again by
+    // its checksums if there is a crash before the next one.
+    buff->header->tail = buff->syncedTail;
+    buff->header->head = head;
+
+    if(!pgSync(buff, buff->syncedTail, tail)) return false;
+
+    buff->syncedHead = head;
+    buff->syncedTail = tail;
+    return true;
+}
+
+long PGPeekRecordFromRingBufferJournal(const PGRingBufferJournal *buff, PGRingBufferSpan *record) {
+    if(buff->head == buff->tail) return -1;
+
+    PGJournalFrame *f = pgFrameAt(buff, buff->head);
+
+    record->bytes  = (uint8_t *)(f + 1);
+    record->length = (long)f->length;
+    return record->length;
+}
+
+long PGReadRecordFromRingBufferJournal(PGRingBufferJournal *buff, void *dest, long maxLength) {
+    PGRingBufferSpan record;
+
+    if((PGPeekRecordFromRingBufferJournal(buff, &record) < 0) || (record.length > maxLength)) return -1;
+    if(record.length) PGMemCpy(dest, record.bytes, record.length);
+    buff->head += pgFramed(record.length);
+    return record.length;
+}
+
+long PGRingBufferJournalConsume(PGRingBufferJournal *buff, long count) {
+    long i = 0;
+
+    for(; (i < count) && (buff->head < buff->tail); ++i) buff->head += pgFramed((long)pgFrameAt(buff, buff->head)->length);
+    return i;
+}
+
+long PGRingBufferJournalCapacity(const PGRingBufferJournal *buff) {
+    return buff->size;
+}
+
+long PGRingBufferJournalCount(const PGRingBufferJournal *buff) {
+    return (buff->tail - buff->head);
+}
+
+long PGRingBufferJournalRemaining(const PGRingBufferJournal *buff) {
+    return (buff->size - (buff->tail - buff->syncedHead));
+}
+
+#pragma clang diagnostic pop
@@ -0,0 +1,189 @@
+//
+//  PGRingBufferPool.c
+//  PGRingBuffer
+//
+//  Created by Galen Rhodes on 10/16/26.
+//  Copyright © 2020 Project Galen. All rights reserved.
+//
+
+#include "include/PGRingBufferPool.h"
+#include "PGRingBufferCommon.h"
+#include <pthread.h>
+
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "OCUnusedGlobalDeclarationInspection"
+
+#define PG_POOL_MIN_SHIFT         (6)
+#define PG_POOL_MAX_CLASSES       (26)
+#define PG_POOL_DEFAULT_BLOCKS    (64)
+#define PG_POOL_DEFAULT_MAX_BLOCK (1024 * 1024)
+
+#define pgClassSize(c)            (1L << ((c) + PG_POOL_MIN_SHIFT))
+
+/*
+ * Free blocks are chained through their first word.
+ */
+typedef struct _st_pg_pool_block_ {
+    struct _st_pg_pool_block_ *next;
+}               PGPoolBlock;
+
+typedef struct _st_pg_pool_class_ {
+    PGPoolBlock *free;
+    long        count;
+}               PGPoolClass;
+
+struct _st_pg_ringbuffer_pool_ {
+    PGRingBufferAllocator allocator;
+    pthread_mutex_t       lock;
+    long                  maxBlocks;
+    int                   classCount;
+    PGPoolClass           classes[PG_POOL_MAX_CLASSES];
+    PGRingBufferPoolStats stats;
+};
+
+/*
+ * Returns the index of the smallest size class that will hold `size` bytes or -1 if it is too big to be pooled.
+ */
+PG_ALWAYS_INLINE int pgClassFor(const PGRingBufferPool *pool, long size) {
+    int c = 0;
+    while((c < pool->classCount) && (pgClassSize(c) < size)) ++c;
+    return ((c < pool->classCount) ? c : -1);
+}
+
+static void *pgPoolAlloc(void *context, long size) {
+    PGRingBufferPool *pool = context;
+    int              c     = pgClassFor(pool, size);
+
+    if(c >= 0) {
+        pthread_mutex_lock(&pool->lock);
+        PGPoolBlock *b = pool->classes[c].free;
+
+        if(b) {
+            pool->classes[c].free = b->next;
+            pool->classes[c].count--;
+            pool->stats.hits++;
+            pool->stats.cachedBlocks--;
+            pool->stats.cachedBytes -= pgClassSize(c);
+            pthread_mutex_unlock(&pool->lock);
+            return b;
+        }
+
+        pool->stats.misses++;
+        pthread_mutex_unlock(&pool->lock);
+        return malloc((size_t)pgClassSize(c));
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stats.misses++;
+    pthread_mutex_unlock(&pool->lock);
+    return malloc((size_t)size);
+}
+
+static void pgPoolFree(void *context, void *ptr, long size) {
+    PGRingBufferPool *pool = context;
+    int              c     = pgClassFor(pool, size);
+
+    if(ptr == NULL) return;
+
+    pthread_mutex_lock(&pool->lock);
+    if((c >= 0) && (pool->classes[c].count < pool->maxBlocks)) {
+        PGPoolBlock *b = ptr;
+
+        b->next = pool->classes[c].free;
+        pool->classes[c].free = b;
+        pool->classes[c].count++;
+        pool->stats.recycled++;
+        pool->stats.cachedBlocks++;
+        pool->stats.cachedBytes += pgClassSize(c);
+        ptr = NULL;
+    }
+    else {
+        pool->stats.released++;
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    free(ptr);
+}
+
+static void *pgPoolRealloc(void *context, void *ptr, long oldSize, long newSize) {
+    PGRingBufferPool *pool = context;
+    int              oc    = pgClassFor(pool, oldSize);
+    int              nc    = pgClassFor(pool, newSize);
+
+    // Still fits in the same block.
+    if((oc >= 0) && (oc == nc)) return ptr;
+    // Neither end is pooled so let the system grow it in place if it can.
+    if((oc < 0) && (nc < 0)) return realloc(ptr, (size_t)newSize);
+
+    void *np = pgPoolAlloc(context, newSize);
+
+    if(np) {
+        PGMemCpy(np, ptr, pg_Min(oldSize, newSize));
+        pgPoolFree(context, ptr, oldSize);
+    }
+
+    return np;
+}
+
+PGRingBufferPool *PGCreateRingBufferPool(long maxBlocksPerClass, long maxBlockSize) {
+    PGRingBufferPool *pool = calloc(1, sizeof(PGRingBufferPool));
+
+    if(pool) {
+        if(pthread_mutex_init(&pool->lock, NULL) == 0) {
+            if(maxBlockSize <= 0) maxBlockSize = PG_POOL_DEFAULT_MAX_BLOCK;
+
+            pool->allocator.alloc   = pgPoolAlloc;
+            pool->allocator.realloc = pgPoolRealloc;
+            pool->allocator.free    = pgPoolFree;
+            pool->allocator.context = pool;
+            pool->maxBlocks         = ((maxBlocksPerClass <= 0) ? PG_POOL_DEFAULT_BLOCKS : maxBlocksPerClass);
+
+            while((pool->classCount < PG_POOL_MAX_CLASSES) && (pgClassSize(pool->classCount) <= maxBlockSize)) pool->classCount++;
+            return pool;
+        }
+
+        free(pool);
+    }
+
+    return NULL;
+}
+
+void PGTrimRingBufferPool(PGRingBufferPool *pool) {
+    pthread_mutex_lock(&pool->lock);
+    for(int c = 0; c < pool->classCount; ++c) {
+        PGPoolBlock *b = pool->classes[c].free;
+
+        while(b) {
+            PGPoolBlock *n = b->next;
+            free(b);
+            b = n;
+        }
+
+        pool->stats.released += pool->classes[c].count;
+        pool->classes[c].free  = NULL;
+        pool->classes[c].count = 0;
+    }
+    pool->stats.cachedBlocks = 0;
+    pool->stats.cachedBytes  = 0;
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void PGDiscardRingBufferPool(PGRingBufferPool *pool) {
+    if(pool) {
+        PGTrimRingBufferPool(pool);
+        pthread_mutex_destroy(&pool->lock);
+        free(pool);
+    }
+}
+
+const PGRingBufferAllocator *PGRingBufferPoolAllocator(PGRingBufferPool *pool) {
+    return &pool->allocator;
+}
+
+void PGGetRingBufferPoolStats(PGRingBufferPool *pool, PGRingBufferPoolStats *stats) {
+    pthread_mutex_lock(&pool->lock);
+    *stats = pool->stats;
+    pthread_mutex_unlock(&pool->lock);
+}
+
+#pragma clang diagnostic pop
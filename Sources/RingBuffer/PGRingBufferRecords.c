@@ -0,0 +1,240 @@
+//
+//  PGRingBufferRecords.c
+//  PGRingBuffer
+//
+//  Created by Galen Rhodes on 10/16/26.
+//  Copyright © 2020 Project Galen. All rights reserved.
+//
+
+#include "include/PGRingBufferRecords.h"
+#include "PGRingBufferCommon.h"
+
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "OCUnusedGlobalDeclarationInspection"
+
+/*
+ * The records are read and written in place through the one or two spans that make up the readable bytes or the
+ * reserved room. `at` is an offset from the start of the first span.
+ */
+PG_ALWAYS_INLINE uint8_t pgSpanByte(const PGRingBufferSpan spans[2], long at) {
+    return ((at < spans[0].length) ? spans[0].bytes[at] : spans[1].bytes[at - spans[0].length]);
+}
+
+PG_ALWAYS_INLINE void pgSpanGet(const PGRingBufferSpan spans[2], long at, uint8_t *dest, long length) {
+    long l = pg_Min(length, pg_Max(0, (spans[0].length - at)));
+
+    PGMemCpy(dest, (spans[0].bytes + at), l);
+    if(l < length) PGMemCpy((dest + l), (spans[1].bytes + (at + l - spans[0].length)), (length - l));
+}
+
+PG_ALWAYS_INLINE void pgSpanPut(const PGRingBufferSpan spans[2], long at, const uint8_t *src, long length) {
+    long l = pg_Min(length, pg_Max(0, (spans[0].length - at)));
+
+    PGMemCpy((spans[0].bytes + at), src, l);
+    if(l < length) PGMemCpy((spans[1].bytes + (at + l - spans[0].length)), (src + l), (length - l));
+}
+
+/*
+ * Writes the length prefix into `p` and returns its size. The length has already been checked.
+ */
+PG_ALWAYS_INLINE long pgEncodeLength(int format, long length, uint8_t *p) {
+    long i = 0;
+
+    switch(format) {
+        case PG_RECORD_FIXED32:
+            p[i++] = (uint8_t)length;
+            p[i++] = (uint8_t)(length >> 8);
+            length >>= 16;
+            // Fallthrough
+        case PG_RECORD_FIXED16:
+            p[i++] = (uint8_t)length;
+            p[i++] = (uint8_t)(length >> 8);
+            break;
+        default:
+            while(length >= 0x80) {
+                p[i++] = (uint8_t)(length | 0x80);
+                length >>= 7;
+            }
+            p[i++] = (uint8_t)length;
+            break;
+    }
+
+    return i;
+}
+
+/*
+ * Decodes the length prefix of the record that starts `at` bytes into the spans. Returns the length of the record
+ * and sets `*prefix` to the size of the prefix. Returns -1 if the prefix or the record isn't all there yet or -2
+ * if the prefix is corrupt. A record that would take up more than `maxSize` bytes, prefix and all, can never be
+ * all there so its prefix counts as corrupt too.
+ */
+static long pgRecordHeader(const PGRingBufferSpan spans[2], long cc, long at, int format, long maxSize, long *prefix) {
+    long avail = (cc - at);
+    long len   = 0;
+    long p;
+
+    if(format == PG_RECORD_VARINT) {
+        for(p = 0; ; ++p) {
+            if(p == PG_RECORD_MAX_VARINT) return -2;
+            if(p == avail) return -1;
+
+            uint8_t b = pgSpanByte(spans, (at + p));
+            len |= ((long)(b & 0x7f) << (7 * p));
+            if((b & 0x80) == 0) break;
+        }
+        ++p;
+    }
+    else if((format == PG_RECORD_FIXED16) || (format == PG_RECORD_FIXED32)) {
+        p = format;
+        if(avail < p) return -1;
+        for(long i = (p - 1); i >= 0; --i) len = ((len << 8) | pgSpanByte(spans, (at + i)));
+    }
+    else {
+        return -2;
+    }
+
+    if(len > (maxSize - p)) return -2;
+    if((avail - p) < len) return -1;
+    *prefix = p;
+    return len;
+}
+
+/*
+ * Drops whole records from the head of an overwriting buffer until at least `needed` bytes have gone. If what's
+ * at the head can't be parsed as records then everything is dropped.
+ */
+static void pgDropRecords(PGRingBuffer *buff, int format, long needed) {
+    PGRingBufferSpan spans[2];
+    long             cc = PGPeekSpansFromRingBuffer(buff, spans);
+    long             at = 0;
+
+    while(at < needed) {
+        long p   = 0;
+        long len = pgRecordHeader(spans, cc, at, format, _PGRingBufferMaxSize(buff), &p);
+
+        if(len < 0) {
+            at = cc;
+            break;
+        }
+        at += (p + len);
+    }
+
+    _PGRingBufferConsume(buff, at);
+    buff->dropped += at;
+}
+
+long PGRecordFramedSize(int format, long length) {
+    if(length < 0) return -1;
+
+    switch(format) {
+        case PG_RECORD_FIXED16:
+            return ((length <= UINT16_MAX) ? (length + 2) : -1);
+        case PG_RECORD_FIXED32:
+            return ((length <= (long)UINT32_MAX) ? (length + 4) : -1);
+        case PG_RECORD_VARINT: {
+            long p = 1;
+            for(long l = length; l >= 0x80; l >>= 7) ++p;
+            return (length + p);
+        }
+        default:
+            return -1;
+    }
+}
+
+bool PGAppendRecordToRingBuffer(PGRingBuffer *buff, int format, const void *src, long length) {
+    PGRingBufferSpan record = { (uint8_t *)src, length };
+    return PGAppendRecordsToRingBuffer(buff, format, &record, 1);
+}
+
+bool PGAppendRecordsToRingBuffer(PGRingBuffer *buff, int format, const PGRingBufferSpan *records, long count) {
+    PGRingBufferSpan spans[2];
+    uint8_t          prefix[PG_RECORD_MAX_VARINT];
+    long             total = 0;
+    long             at    = 0;
+
+    for(long i = 0; i < count; ++i) {
+        long f = PGRecordFramedSize(format, records[i].length);
+
+        if((f < 0) || ((records[i].bytes == NULL) && (records[i].length > 0))) return false;
+        total += f;
+    }
+
+    if(total == 0) return true;
+    if((buff->flags & PG_RINGBUFFER_OVERWRITE) && (PGRingBufferRemaining(buff) < total)) {
+        if(total > PGRingBufferCapacity(buff)) return false;
+        pgDropRecords(buff, format, (total - PGRingBufferRemaining(buff)));
+    }
+    if(PGRingBufferReserve(buff, total, spans) < total) return false;
+
+    for(long i = 0; i < count; ++i) {
+        long p = pgEncodeLength(format, records[i].length, prefix);
+
+        pgSpanPut(spans, at, prefix, p);
+        pgSpanPut(spans, (at + p), records[i].bytes, records[i].length);
+        at += (p + records[i].length);
+    }
+
+    PGRingBufferCommit(buff, total);
+    return true;
+}
+
+long PGNextRecordSize(const PGRingBuffer *buff, int format) {
+    PGRingBufferSpan spans[2];
+    long             cc = PGPeekSpansFromRingBuffer(buff, spans);
+    long             p;
+
+    return pgRecordHeader(spans, cc, 0, format, _PGRingBufferMaxSize(buff), &p);
+}
+
+long PGReadRecordFromRingBuffer(PGRingBuffer *buff, int format, void *dest, long maxLength) {
+    PGRingBufferSpan spans[2];
+    long             cc  = PGPeekSpansFromRingBuffer(buff, spans);
+    long             p   = 0;
+    long             len = pgRecordHeader(spans, cc, 0, format, _PGRingBufferMaxSize(buff), &p);
+
+    if(len < 0) return len;
+    if((len > maxLength) || ((dest == NULL) && (len > 0))) return -1;
+
+    pgSpanGet(spans, p, dest, len);
+    PGRingBufferConsume(buff, (p + len));
+    return len;
+}
+
+long PGPopRecordsFromRingBuffer(PGRingBuffer *buff, int format, PGRingBufferSpan *records, long maxRecords) {
+    PGRingBufferSpan spans[2];
+    long             cc = PGPeekSpansFromRingBuffer(buff, spans);
+    long             mx = _PGRingBufferMaxSize(buff);
+    long             at = 0;
+    long             n  = 0;
+
+    while(n < maxRecords) {
+        long p   = 0;
+        long len = pgRecordHeader(spans, cc, at, format, mx, &p);
+        long st  = (at + p);
+        long l0  = spans[0].length;
+
+        if(len < 0) {
+            if((len == -2) && (n == 0)) return -2;
+            break;
+        }
+
+        if((st < l0) && ((st + len) > l0)) {
+            // Wraps around the end of the storage. Only safe to move things if nothing has been handed out yet.
+            if(n) break;
+            PGMakeRingBufferContiguous(buff, (p + len));
+            cc = PGPeekSpansFromRingBuffer(buff, spans);
+            continue;
+        }
+
+        records[n].bytes  = ((st < l0) ? (spans[0].bytes + st) : (spans[1].bytes + (st - l0)));
+        records[n].length = len;
+        at                = (st + len);
+        ++n;
+    }
+
+    // The storage mustn't be shrunk out from under the records we're handing back.
+    _PGRingBufferConsume(buff, at);
+    return n;
+}
+
+#pragma clang diagnostic pop
@@ -0,0 +1,310 @@
+//
+//  PGRingBufferSearch.c
+//  PGRingBuffer
+//
+//  Created by Galen Rhodes on 10/16/26.
+//  Copyright © 2020 Project Galen. All rights reserved.
+//
+
+#include "include/PGRingBuffer.h"
+#include "PGRingBufferCommon.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+    #define PG_SEARCH_X86 1
+    #include <immintrin.h>
+#else
+    #define PG_SEARCH_X86 0
+#endif
+
+#if defined(__aarch64__)
+    #define PG_SEARCH_NEON 1
+    #include <arm_neon.h>
+#else
+    #define PG_SEARCH_NEON 0
+#endif
+
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "OCUnusedGlobalDeclarationInspection"
+
+/*
+ * A set of bytes is kept as two 16 byte tables indexed by the low nibble of the byte. The first table is for
+ * bytes below 0x80 and the second for the rest. Bit (high nibble & 7) of the entry says whether the byte is in
+ * the set. That's exactly the shape a byte shuffle can look up 16 or 32 at a time. (W. Muła)
+ */
+PG_ALWAYS_INLINE void pgBuildSetMaps(const uint8_t *set, long setLength, uint8_t maps[32]) {
+    memset(maps, 0, 32);
+    for(long i = 0; i < setLength; ++i) maps[((set[i] >> 7) << 4) | (set[i] & 0x0f)] |= (uint8_t)(1 << ((set[i] >> 4) & 7));
+}
+
+PG_ALWAYS_INLINE bool pgInSet(const uint8_t maps[32], uint8_t c) {
+    return ((maps[((c >> 7) << 4) | (c & 0x0f)] >> ((c >> 4) & 7)) & 1);
+}
+
+#if PG_SEARCH_X86
+
+/*
+ * The x86 kernels start at `*i` and leave `*i` at the first position they didn't look at so that the next
+ * narrower kernel can pick up from there. They return the offset of the first match or -1.
+ */
+__attribute__((__target__("avx2"))) static long pgFindAnyAVX2(const uint8_t *bytes, long length, const uint8_t maps[32], long *i) {
+    __m256i m0 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)maps));
+    __m256i m1 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(maps + 16)));
+    __m256i bt = _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+    __m256i ix = _mm256_set1_epi8((char)0x8f);
+    __m256i hb = _mm256_set1_epi8((char)0x80);
+    __m256i nb = _mm256_set1_epi8(0x0f);
+    __m256i z  = _mm256_setzero_si256();
+
+    for(; (*i + 32) <= length; *i += 32) {
+        __m256i  x  = _mm256_loadu_si256((const __m256i *)(bytes + *i));
+        __m256i  t  = _mm256_or_si256(_mm256_shuffle_epi8(m0, _mm256_and_si256(x, ix)), _mm256_shuffle_epi8(m1, _mm256_and_si256(_mm256_xor_si256(x, hb), ix)));
+        __m256i  b  = _mm256_shuffle_epi8(bt, _mm256_and_si256(_mm256_srli_epi16(x, 4), nb));
+        uint32_t mk = ~(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(t, b), z));
+
+        if(mk) return (*i + __builtin_ctz(mk));
+    }
+
+    return -1;
+}
+
+__attribute__((__target__("ssse3"))) static long pgFindAnySSSE3(const uint8_t *bytes, long length, const uint8_t maps[32], long *i) {
+    __m128i m0 = _mm_loadu_si128((const __m128i *)maps);
+    __m128i m1 = _mm_loadu_si128((const __m128i *)(maps + 16));
+    __m128i bt = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+    __m128i ix = _mm_set1_epi8((char)0x8f);
+    __m128i hb = _mm_set1_epi8((char)0x80);
+    __m128i nb = _mm_set1_epi8(0x0f);
+    __m128i z  = _mm_setzero_si128();
+
+    for(; (*i + 16) <= length; *i += 16) {
+        __m128i  x  = _mm_loadu_si128((const __m128i *)(bytes + *i));
+        __m128i  t  = _mm_or_si128(_mm_shuffle_epi8(m0, _mm_and_si128(x, ix)), _mm_shuffle_epi8(m1, _mm_and_si128(_mm_xor_si128(x, hb), ix)));
+        __m128i  b  = _mm_shuffle_epi8(bt, _mm_and_si128(_mm_srli_epi16(x, 4), nb));
+        uint32_t mk = (~(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(t, b), z)) & 0xffff);
+
+        if(mk) return (*i + __builtin_ctz(mk));
+    }
+
+    return -1;
+}
+
+/*
+ * Compare the first and last bytes of the pattern against 32 (or 16) positions at once and only do the full
+ * compare where both match. The caller makes sure the pattern is at least two bytes long.
+ */
+__attribute__((__target__("avx2"))) static long pgFindPatternAVX2(const uint8_t *bytes, long length, const uint8_t *pat, long patLength, long *i) {
+    __m256i f = _mm256_set1_epi8((char)pat[0]);
+    __m256i l = _mm256_set1_epi8((char)pat[patLength - 1]);
+
+    for(; (*i + patLength - 1 + 32) <= length; *i += 32) {
+        __m256i  a  = _mm256_loadu_si256((const __m256i *)(bytes + *i));
+        __m256i  b  = _mm256_loadu_si256((const __m256i *)(bytes + *i + patLength - 1));
+        uint32_t mk = (uint32_t)_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, f), _mm256_cmpeq_epi8(b, l)));
+
+        for(; mk; mk &= (mk - 1)) {
+            long j = (*i + __builtin_ctz(mk));
+            if(memcmp((bytes + j + 1), (pat + 1), (size_t)(patLength - 2)) == 0) return j;
+        }
+    }
+
+    return -1;
+}
+
+__attribute__((__target__("sse2"))) static long pgFindPatternSSE2(const uint8_t *bytes, long length, const uint8_t *pat, long patLength, long *i) {
+    __m128i f = _mm_set1_epi8((char)pat[0]);
+    __m128i l = _mm_set1_epi8((char)pat[patLength - 1]);
+
+    for(; (*i + patLength - 1 + 16) <= length; *i += 16) {
+        __m128i  a  = _mm_loadu_si128((const __m128i *)(bytes + *i));
+        __m128i  b  = _mm_loadu_si128((const __m128i *)(bytes + *i + patLength - 1));
+        uint32_t mk = (uint32_t)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, f), _mm_cmpeq_epi8(b, l)));
+
+        for(; mk; mk &= (mk - 1)) {
+            long j = (*i + __builtin_ctz(mk));
+            if(memcmp((bytes + j + 1), (pat + 1), (size_t)(patLength - 2)) == 0) return j;
+        }
+    }
+
+    return -1;
+}
+
+#endif
+
+#if PG_SEARCH_NEON
+
+/*
+ * NEON has no movemask so each kernel just finds the first block of 16 with anything in it and leaves the exact
+ * position to the scalar code.
+ */
+static long pgFindAnyNEON(const uint8_t *bytes, long length, const uint8_t maps[32], long *i) {
+    static const uint8_t bits[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+    uint8x16_t           m0       = vld1q_u8(maps);
+    uint8x16_t           m1       = vld1q_u8(maps + 16);
+    uint8x16_t           bt       = vld1q_u8(bits);
+    uint8x16_t           ix       = vdupq_n_u8(0x8f);
+    uint8x16_t           hb       = vdupq_n_u8(0x80);
+
+    for(; (*i + 16) <= length; *i += 16) {
+        uint8x16_t x = vld1q_u8(bytes + *i);
+        uint8x16_t t = vorrq_u8(vqtbl1q_u8(m0, vandq_u8(x, ix)), vqtbl1q_u8(m1, vandq_u8(veorq_u8(x, hb), ix)));
+
+        if(vmaxvq_u8(vandq_u8(t, vqtbl1q_u8(bt, vshrq_n_u8(x, 4)))) != 0) break;
+    }
+
+    return -1;
+}
+
+static long pgFindPatternNEON(const uint8_t *bytes, long length, const uint8_t *pat, long patLength, long *i) {
+    uint8x16_t f = vdupq_n_u8(pat[0]);
+    uint8x16_t l = vdupq_n_u8(pat[patLength - 1]);
+
+    for(; (*i + patLength - 1 + 16) <= length; *i += 16) {
+        uint8x16_t m = vandq_u8(vceqq_u8(vld1q_u8(bytes + *i), f), vceqq_u8(vld1q_u8(bytes + *i + patLength - 1), l));
+
+        if(vmaxvq_u8(m) != 0) {
+            for(long j = *i, e = (*i + 16); j < e; ++j) {
+                if((bytes[j] == pat[0]) && (memcmp((bytes + j + 1), (pat + 1), (size_t)(patLength - 1)) == 0)) return j;
+            }
+        }
+    }
+
+    return -1;
+}
+
+#endif
+
+/*
+ * Returns the offset of the first byte in `bytes` that is in the set, or -1.
+ */
+static long pgFindAny(const uint8_t *bytes, long length, const uint8_t maps[32]) {
+    long i = 0;
+    long x = -1;
+
+#if PG_SEARCH_X86
+    // __builtin_cpu_supports() is just a test of a flag that libgcc/compiler-rt fills in once at startup.
+    if(__builtin_cpu_supports("avx2")) x = pgFindAnyAVX2(bytes, length, maps, &i);
+    if((x < 0) && __builtin_cpu_supports("ssse3")) x = pgFindAnySSSE3(bytes, length, maps, &i);
+#elif PG_SEARCH_NEON
+    x = pgFindAnyNEON(bytes, length, maps, &i);
+#endif
+
+    if(x >= 0) return x;
+    for(; i < length; ++i) if(pgInSet(maps, bytes[i])) return i;
+    return -1;
+}
+
+/*
+ * Returns the offset of the first complete occurrence of the pattern in `bytes`, or -1. The pattern is at least
+ * two bytes long.
+ */
+static long pgFindPattern(const uint8_t *bytes, long length, const uint8_t *pat, long patLength) {
+    long i = 0;
+    long x = -1;
+
+#if PG_SEARCH_X86
+    if(__builtin_cpu_supports("avx2")) x = pgFindPatternAVX2(bytes, length, pat, patLength, &i);
+    if((x < 0) && __builtin_cpu_supports("sse2")) x = pgFindPatternSSE2(bytes, length, pat, patLength, &i);
+#elif PG_SEARCH_NEON
+    x = pgFindPatternNEON(bytes, length, pat, patLength, &i);
+#endif
+
+    if(x >= 0) return x;
+
+    for(long e = (length - patLength + 1); i < e; ++i) {
+        const uint8_t *f = memchr((bytes + i), pat[0], (size_t)(e - i));
+
+        if(f == NULL) break;
+        i = (f - bytes);
+        if(memcmp((f + 1), (pat + 1), (size_t)(patLength - 1)) == 0) return i;
+    }
+
+    return -1;
+}
+
+long PGFindByteInRingBuffer(const PGRingBuffer *buff, long offset, uint8_t byte) {
+    PGRingBufferSpan spans[2];
+    long             cc   = PGPeekSpansFromRingBuffer(buff, spans);
+    long             base = 0;
+
+    offset = pg_Max(offset, 0);
+    if(offset >= cc) return -1;
+
+    for(int s = 0; s < 2; ++s) {
+        if(offset < spans[s].length) {
+            // memchr(3) is already vectorized by every libc worth using.
+            const uint8_t *f = memchr((spans[s].bytes + offset), byte, (size_t)(spans[s].length - offset));
+
+            if(f) return (base + (f - spans[s].bytes));
+            offset = 0;
+        }
+        else {
+            offset -= spans[s].length;
+        }
+        base += spans[s].length;
+    }
+
+    return -1;
+}
+
+long PGFindAnyByteInRingBuffer(const PGRingBuffer *buff, long offset, const uint8_t *set, long setLength) {
+    PGRingBufferSpan spans[2];
+    long             cc   = PGPeekSpansFromRingBuffer(buff, spans);
+    long             base = 0;
+    uint8_t          maps[32];
+
+    offset = pg_Max(offset, 0);
+    if((set == NULL) || (setLength < 1) || (offset >= cc)) return -1;
+    if(setLength == 1) return PGFindByteInRingBuffer(buff, offset, set[0]);
+
+    pgBuildSetMaps(set, setLength, maps);
+
+    for(int s = 0; s < 2; ++s) {
+        if(offset < spans[s].length) {
+            long x = pgFindAny((spans[s].bytes + offset), (spans[s].length - offset), maps);
+
+            if(x >= 0) return (base + offset + x);
+            offset = 0;
+        }
+        else {
+            offset -= spans[s].length;
+        }
+        base += spans[s].length;
+    }
+
+    return -1;
+}
+
+long PGFindInRingBuffer(const PGRingBuffer *buff, long offset, const void *pattern, long length) {
+    PGRingBufferSpan spans[2];
+    long             cc  = PGPeekSpansFromRingBuffer(buff, spans);
+    const uint8_t    *p  = pattern;
+    long             l0  = spans[0].length;
+    long             x;
+
+    offset = pg_Max(offset, 0);
+    if((p == NULL) || (length < 1) || ((cc - offset) < length)) return -1;
+    if(length == 1) return PGFindByteInRingBuffer(buff, offset, p[0]);
+
+    // Entirely in the first span.
+    if((l0 - offset) >= length) {
+        if((x = pgFindPattern((spans[0].bytes + offset), (l0 - offset), p, length)) >= 0) return (offset + x);
+    }
+
+    // Straddling the wrap point. There are fewer than `length` places one of these can start so just try each.
+    for(long s = pg_Max(offset, (l0 - length + 1)), e = pg_Min(l0, (cc - length + 1)); s < e; ++s) {
+        long a = (l0 - s);
+
+        if((spans[0].bytes[s] == p[0]) && (memcmp((spans[0].bytes + s), p, (size_t)a) == 0) && (memcmp(spans[1].bytes, (p + a), (size_t)(length - a)) == 0)) return s;
+    }
+
+    // Entirely in the second span.
+    long s1 = pg_Max(0, (offset - l0));
+
+    if((spans[1].length - s1) >= length) {
+        if((x = pgFindPattern((spans[1].bytes + s1), (spans[1].length - s1), p, length)) >= 0) return (l0 + s1 + x);
+    }
+
+    return -1;
+}
+
+#pragma clang diagnostic pop
@@ -0,0 +1,246 @@
+//
+//  PGRingBufferSwap.c
+//  PGRingBuffer
+//
+//  Created by Galen Rhodes on 10/16/26.
+//  Copyright © 2020 Project Galen. All rights reserved.
+//
+
+#include "include/PGRingBuffer.h"
+#include "PGRingBufferCommon.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+    #define PG_SWAP_X86 1
+    #include <immintrin.h>
+#else
+    #define PG_SWAP_X86 0
+#endif
+
+#if defined(__aarch64__)
+    #define PG_SWAP_NEON 1
+    #include <arm_neon.h>
+#else
+    #define PG_SWAP_NEON 0
+#endif
+
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "OCUnusedGlobalDeclarationInspection"
+
+/*
+ * Byte shuffles for 16 bytes at a time. Every kind of swap is just a fixed permutation of the bytes within each
+ * word so one vector kernel handles all of them.
+ */
+static const uint8_t pgSwapMasks[6][16] = {
+    { 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14 },   // 16
+    { 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12 },   // 32
+    { 2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13 },   // 32 Alt
+    { 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8 },   // 64
+    { 4, 5, 6, 7, 0, 1, 2, 3, 12, 13, 14, 15, 8, 9, 10, 11 },   // 64 Alt
+    { 6, 7, 4, 5, 2, 3, 0, 1, 14, 15, 12, 13, 10, 11, 8, 9 },   // 64 AltAlt
+};
+
+PG_ALWAYS_INLINE const uint8_t *pgSwapMaskFor(long bytesPerWord, int alt) {
+    switch(bytesPerWord) {
+        case 2: return pgSwapMasks[0];
+        case 4: return pgSwapMasks[1 + pg_Min(alt, 1)];
+        default: return pgSwapMasks[3 + pg_Min(alt, 2)];
+    }
+}
+
+#if PG_SWAP_X86
+
+__attribute__((__target__("avx2"))) static long pgSwapAVX2(uint8_t *dest, const uint8_t *src, long length, const uint8_t *mask) {
+    __m256i m = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)mask));
+    long    i = 0;
+
+    for(; (i + 64) <= length; i += 64) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(src + i));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(src + i + 32));
+        _mm256_storeu_si256((__m256i *)(dest + i), _mm256_shuffle_epi8(a, m));
+        _mm256_storeu_si256((__m256i *)(dest + i + 32), _mm256_shuffle_epi8(b, m));
+    }
+    for(; (i + 32) <= length; i += 32) {
+        _mm256_storeu_si256((__m256i *)(dest + i), _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(src + i)), m));
+    }
+
+    return i;
+}
+
+__attribute__((__target__("ssse3"))) static long pgSwapSSSE3(uint8_t *dest, const uint8_t *src, long length, const uint8_t *mask) {
+    __m128i m = _mm_loadu_si128((const __m128i *)mask);
+    long    i = 0;
+
+    for(; (i + 16) <= length; i += 16) {
+        _mm_storeu_si128((__m128i *)(dest + i), _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(src + i)), m));
+    }
+
+    return i;
+}
+
+#endif
+
+#if PG_SWAP_NEON
+
+static long pgSwapNEON(uint8_t *dest, const uint8_t *src, long length, const uint8_t *mask) {
+    uint8x16_t m = vld1q_u8(mask);
+    long       i = 0;
+
+    for(; (i + 16) <= length; i += 16) vst1q_u8((dest + i), vqtbl1q_u8(vld1q_u8(src + i), m));
+
+    return i;
+}
+
+#endif
+
+/*
+ * Swaps whatever the vector kernels left over. The words might not be aligned so they're moved in and out with
+ * memcpy which the compiler turns into plain loads and stores.
+ */
+static void pgSwapScalar(uint8_t *dest, const uint8_t *src, long length, long bytesPerWord, int alt) {
+    for(long i = 0; i < length; i += bytesPerWord) {
+        const uint8_t *p = (src + i);
+        uint8_t       *q = (dest + i);
+
+        if(bytesPerWord == 2) {
+            uint16_t w;
+            memcpy(&w, p, 2);
+            w = __builtin_bswap16(w);
+            memcpy(q, &w, 2);
+        }
+        else if(bytesPerWord == 4) {
+            uint32_t w;
+            memcpy(&w, p, 4);
+            w = (alt ? ((w >> 16) | (w << 16)) : __builtin_bswap32(w));
+            memcpy(q, &w, 4);
+        }
+        else {
+            uint64_t w;
+            memcpy(&w, p, 8);
+            switch(alt) {
+                case 1: w = ((w >> 32) | (w << 32));
+                    break;
+                case 2: w = (((w & 0xffff000000000000) >> 48) | ((w & 0x0000ffff00000000) >> 16) | ((w & 0x00000000ffff0000) << 16) | ((w & 0x000000000000ffff) << 48));
+                    break;
+                default: w = __builtin_bswap64(w);
+                    break;
+            }
+            memcpy(q, &w, 8);
+        }
+    }
+}
+
+void _PGSwapCopy(void *dest, const void *src, long length, long bytesPerWord, int alt) {
+    uint8_t       *d    = dest;
+    const uint8_t *s    = src;
+    const uint8_t *mask = pgSwapMaskFor(bytesPerWord, alt);
+    long          i     = 0;
+
+    length -= (length % bytesPerWord);
+    if(length <= 0) return;
+
+#if PG_SWAP_X86
+    // __builtin_cpu_supports() is just a test of a flag that libgcc/compiler-rt fills in once at startup.
+    if(__builtin_cpu_supports("avx2")) i = pgSwapAVX2(d, s, length, mask);
+    if(__builtin_cpu_supports("ssse3")) i += pgSwapSSSE3((d + i), (s + i), (length - i), mask);
+#elif PG_SWAP_NEON
+    i = pgSwapNEON(d, s, length, mask);
+#endif
+
+    pgSwapScalar((d + i), (s + i), (length - i), bytesPerWord, alt);
+}
+
+void _PGSwap(void *buffer, long length, long bytesPerWord, int alt) {
+    _PGSwapCopy(buffer, buffer, length, bytesPerWord, alt);
+}
+
+PG_ALWAYS_INLINE void pgCopyWords(void *dest, const void *src, long length, long bytesPerWord, bool swap) {
+    if(swap) _PGSwapCopy(dest, src, length, bytesPerWord, 0); else memcpy(dest, src, (size_t)length);
+}
+
+/*
+ * Copies `length` bytes (a whole number of words) between a flat buffer and the one or two spans of a ring buffer,
+ * swapping each word on the way if `swap` is true. `toSpans` says which way. A word that straddles the two spans is
+ * gathered into a temporary.
+ */
+PG_ALWAYS_INLINE void pgCopySpans(uint8_t *flat, PGRingBufferSpan spans[2], long length, long bytesPerWord, bool swap, bool toSpans) {
+    long l1 = pg_Min(length, spans[0].length);
+    long r  = (l1 % bytesPerWord);
+    long a  = (l1 - r);
+    long s  = 0;
+
+    if(toSpans) pgCopyWords(spans[0].bytes, flat, a, bytesPerWord, swap); else pgCopyWords(flat, spans[0].bytes, a, bytesPerWord, swap);
+
+    if(l1 < length) {
+        if(r) {
+            uint8_t word[8];
+
+            s = (bytesPerWord - r);
+            if(toSpans) {
+                pgCopyWords(word, (flat + a), bytesPerWord, bytesPerWord, swap);
+                memcpy((spans[0].bytes + a), word, (size_t)r);
+                memcpy(spans[1].bytes, (word + r), (size_t)s);
+            }
+            else {
+                memcpy(word, (spans[0].bytes + a), (size_t)r);
+                memcpy((word + r), spans[1].bytes, (size_t)s);
+                pgCopyWords((flat + a), word, bytesPerWord, bytesPerWord, swap);
+            }
+        }
+
+        // The straddling word, if there was one, took `r` bytes from the first span and `s` from the second.
+        if(toSpans) pgCopyWords((spans[1].bytes + s), (flat + l1 + s), (length - l1 - s), bytesPerWord, swap);
+        else pgCopyWords((flat + l1 + s), (spans[1].bytes + s), (length - l1 - s), bytesPerWord, swap);
+    }
+}
+
+PG_ALWAYS_INLINE long pgReadWords(PGRingBuffer *buff, void *dest, long maxWords, long bytesPerWord, long byteOrder) {
+    PGRingBufferSpan spans[2];
+    long             ws = pg_Min(maxWords, (PGPeekSpansFromRingBuffer(buff, spans) / bytesPerWord));
+
+    if(ws <= 0) return 0;
+
+    pgCopySpans(dest, spans, (ws * bytesPerWord), bytesPerWord, (byteOrder != PGHostByteOrder()), false);
+    PGRingBufferConsume(buff, (ws * bytesPerWord));
+    return ws;
+}
+
+PG_ALWAYS_INLINE bool pgAppendWords(PGRingBuffer *buff, const void *src, long count, long bytesPerWord, long byteOrder) {
+    PGRingBufferSpan spans[2];
+    long             length;
+
+    if((count < 0) || (count > (LONG_MAX / bytesPerWord)) || ((src == NULL) && (count > 0))) return false;
+    if(count == 0) return true;
+
+    length = (count * bytesPerWord);
+    if(PGRingBufferReserve(buff, length, spans) < length) return false;
+
+    pgCopySpans((uint8_t *)src, spans, length, bytesPerWord, (byteOrder != PGHostByteOrder()), true);
+    PGRingBufferCommit(buff, length);
+    return true;
+}
+
+long PGReadWords16FromRingBuffer(PGRingBuffer *buff, uint16_t *dest, long maxWords, long byteOrder) {
+    return pgReadWords(buff, dest, maxWords, 2, byteOrder);
+}
+
+long PGReadWords32FromRingBuffer(PGRingBuffer *buff, uint32_t *dest, long maxWords, long byteOrder) {
+    return pgReadWords(buff, dest, maxWords, 4, byteOrder);
+}
+
+long PGReadWords64FromRingBuffer(PGRingBuffer *buff, uint64_t *dest, long maxWords, long byteOrder) {
+    return pgReadWords(buff, dest, maxWords, 8, byteOrder);
+}
+
+bool PGAppendWords16ToRingBuffer(PGRingBuffer *buff, const uint16_t *src, long count, long byteOrder) {
+    return pgAppendWords(buff, src, count, 2, byteOrder);
+}
+
+bool PGAppendWords32ToRingBuffer(PGRingBuffer *buff, const uint32_t *src, long count, long byteOrder) {
+    return pgAppendWords(buff, src, count, 4, byteOrder);
+}
+
+bool PGAppendWords64ToRingBuffer(PGRingBuffer *buff, const uint64_t *src, long count, long byteOrder) {
+    return pgAppendWords(buff, src, count, 8, byteOrder);
+}
+
+#pragma clang diagnostic pop
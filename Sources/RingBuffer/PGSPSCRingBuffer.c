@@ -0,0 +1,166 @@
+//
+//  PGSPSCRingBuffer.c
+//  PGRingBuffer
+//
+//  Created by Galen Rhodes on 10/16/26.
+//  Copyright © 2020 Project Galen. All rights reserved.
+//
+
+#include "include/PGSPSCRingBuffer.h"
+#include "PGRingBufferCommon.h"
+#include <errno.h>
+#include <stdatomic.h>
+
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "OCUnusedGlobalDeclarationInspection"
+
+/*
+ * The head and the tail are positions that only ever increase. They are masked to get the index into the
+ * buffer. Each one lives on its own cache line along with the owning thread's cached copy of the other one so
+ * that the threads only touch each other's cache line when the cached copy says the buffer looks full (or
+ * empty).
+ */
+struct _st_pg_spsc_ringbuffer_ {
+    long    size;
+    long    mask;
+    uint8_t *buffer;
+
+    // Consumer's cache line.
+    PG_CACHE_ALIGNED _Atomic long head;
+    long                          cachedTail;
+
+    // Producer's cache line.
+    PG_CACHE_ALIGNED _Atomic long tail;
+    long                          cachedHead;
+};
+
+#define pgLoad(a, o)     atomic_load_explicit(&(a), (o))
+#define pgStore(a, v, o) atomic_store_explicit(&(a), (v), (o))
+
+/*
+ * Only look at the producer's cache line if the cached tail doesn't already cover what the caller wants.
+ */
+PG_ALWAYS_INLINE long pgAvailable(PGSPSCRingBuffer *buff, long head, long wanted) {
+    long cc = (buff->cachedTail - head);
+
+    if(cc < wanted) {
+        buff->cachedTail = pgLoad(buff->tail, memory_order_acquire);
+        cc = (buff->cachedTail - head);
+    }
+
+    return cc;
+}
+
+PG_ALWAYS_INLINE long pgCopyOut(const PGSPSCRingBuffer *buff, long head, uint8_t *dest, long length) {
+    long idx = (head & buff->mask);
+    long l   = pg_Min(length, (buff->size - idx));
+    PGMemCpy(dest, (buff->buffer + idx), l);
+    PGMemCpy((dest + l), buff->buffer, (length - l));
+    return length;
+}
+
+PGSPSCRingBuffer *PGCreateSPSCRingBuffer(long capacity) {
+    PGSPSCRingBuffer *buff = NULL;
+    long             size  = pgNextPow2(capacity);
+
+    if(size == 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    if(posix_memalign((void **)&buff, PG_CACHE_LINE_SIZE, sizeof(PGSPSCRingBuffer)) == 0) {
+        buff->size   = size;
+        buff->mask   = (size - 1);
+        buff->buffer = malloc((size_t)size);
+
+        if(buff->buffer) {
+            atomic_init(&buff->head, 0);
+            atomic_init(&buff->tail, 0);
+            buff->cachedHead = 0;
+            buff->cachedTail = 0;
+            return buff;
+        }
+
+        free(buff);
+    }
+
+    return NULL;
+}
+
+void PGDiscardSPSCRingBuffer(PGSPSCRingBuffer *buff) {
+    if(buff) {
+        free(buff->buffer);
+        free(buff);
+    }
+}
+
+bool PGAppendToSPSCRingBuffer(PGSPSCRingBuffer *buff, const void *src, long length) {
+    if(src && (length > 0)) {
+        long tail = pgLoad(buff->tail, memory_order_relaxed);
+
+        if((buff->size - (tail - buff->cachedHead)) < length) {
+            buff->cachedHead = pgLoad(buff->head, memory_order_acquire);
+            if((buff->size - (tail - buff->cachedHead)) < length) return false;
+        }
+
+        long idx = (tail & buff->mask);
+        long l   = pg_Min(length, (buff->size - idx));
+        PGMemCpy((buff->buffer + idx), src, l);
+        PGMemCpy(buff->buffer, (src + l), (length - l));
+        pgStore(buff->tail, (tail + length), memory_order_release);
+    }
+
+    return true;
+}
+
+long PGReadFromSPSCRingBuffer(PGSPSCRingBuffer *buff, void *dest, long maxLength) {
+    if(dest && (maxLength > 0)) {
+        long head = pgLoad(buff->head, memory_order_relaxed);
+        long cc   = pgAvailable(buff, head, maxLength);
+
+        cc = pgCopyOut(buff, head, dest, pg_Min(maxLength, cc));
+        if(cc) pgStore(buff->head, (head + cc), memory_order_release);
+        return cc;
+    }
+
+    return 0;
+}
+
+long PGPeekFromSPSCRingBuffer(PGSPSCRingBuffer *buff, void *dest, long maxLength) {
+    if(dest && (maxLength > 0)) {
+        long head = pgLoad(buff->head, memory_order_relaxed);
+        long cc   = pgAvailable(buff, head, maxLength);
+        return pgCopyOut(buff, head, dest, pg_Min(maxLength, cc));
+    }
+
+    return 0;
+}
+
+long PGSPSCRingBufferConsume(PGSPSCRingBuffer *buff, long length) {
+    if(length > 0) {
+        long head = pgLoad(buff->head, memory_order_relaxed);
+        long cc   = pgAvailable(buff, head, length);
+
+        cc = pg_Min(length, cc);
+        if(cc) pgStore(buff->head, (head + cc), memory_order_release);
+        return cc;
+    }
+
+    return 0;
+}
+
+long PGSPSCRingBufferCapacity(const PGSPSCRingBuffer *buff) {
+    return buff->size;
+}
+
+long PGSPSCRingBufferCount(const PGSPSCRingBuffer *buff) {
+    PGSPSCRingBuffer *b   = (PGSPSCRingBuffer *)buff;
+    long             head = pgLoad(b->head, memory_order_acquire);
+    return (pgLoad(b->tail, memory_order_acquire) - head);
+}
+
+long PGSPSCRingBufferRemaining(const PGSPSCRingBuffer *buff) {
+    return (buff->size - PGSPSCRingBufferCount(buff));
+}
+
+#pragma clang diagnostic pop
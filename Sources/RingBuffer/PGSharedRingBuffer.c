@@ -0,0 +1,346 @@
+//
+//  PGSharedRingBuffer.c
+//  PGRingBuffer
+//
+//  Created by Galen Rhodes on 10/16/26.
+//  Copyright © 2020 Project Galen. All rights reserved.
+//
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+    #define _GNU_SOURCE
+#endif
+
+#include "include/PGSharedRingBuffer.h"
+#include "PGRingBufferCommon.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if defined(__linux__) && defined(MFD_CLOEXEC)
+    #define PG_HAS_MEMFD 1
+#else
+    #define PG_HAS_MEMFD 0
+#endif
+
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "OCUnusedGlobalDeclarationInspection"
+
+#define PG_SHARED_MAGIC    (0x50475242)  // "PGRB"
+#define PG_SHARED_MAX_SIZE (LONG_MAX / 4)
+
+_Static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "The head and tail have to be lock-free to be shared between processes.");
+
+/*
+ * What lives at the start of the shared memory object. The bytes follow at `dataOffset`, which is a whole number of
+ * pages so that they can be mapped a second time straight after themselves. The head and the tail are positions
+ * that only ever increase, exactly as in PGSPSCRingBuffer, and each has a cache line to itself. `magic` is stored
+ * last, once everything else is set up, so a process that attaches early sees a bad magic rather than half a
+ * header. Fixed size types are used so the layout doesn't depend on the compiler's idea of `long`.
+ */
+typedef struct _st_pg_shared_header_ {
+    _Atomic uint32_t magic;
+    uint32_t         version;
+    uint32_t         headerSize;
+    uint32_t         dataOffset;
+    int64_t          size;
+
+    PG_CACHE_ALIGNED _Atomic int64_t head;
+    PG_CACHE_ALIGNED _Atomic int64_t tail;
+} PGSharedHeader;
+
+/*
+ * Each process's handle. The cached copies of the head and the tail are per process, just like the per thread
+ * copies in PGSPSCRingBuffer, so the producer and the consumer only touch each other's cache line when the cached
+ * copy says the buffer looks full (or empty).
+ */
+struct _st_pg_shared_ringbuffer_ {
+    PGSharedHeader *header;
+    uint8_t        *buffer;
+    long           size;
+    long           mask;
+    int            fd;
+
+    PG_CACHE_ALIGNED long cachedTail;
+    PG_CACHE_ALIGNED long cachedHead;
+};
+
+#define pgLoad(a, o)     atomic_load_explicit(&(a), (o))
+#define pgStore(a, v, o) atomic_store_explicit(&(a), (v), (o))
+#define pgMapSize(b)     ((size_t)((b)->header->dataOffset + ((b)->size * 2)))
+
+PG_ALWAYS_INLINE long pgPageSize(void) {
+    return sysconf(_SC_PAGESIZE);
+}
+
+static PGSharedRingBuffer *pgSharedAttach(int fd, long dataOffset, long size) {
+    PGSharedRingBuffer *buff = NULL;
+    uint8_t            *base = _PGMapMirroredFile(fd, dataOffset, size);
+
+    if(base) {
+        if(posix_memalign((void **)&buff, PG_CACHE_LINE_SIZE, sizeof(PGSharedRingBuffer)) == 0) {
+            buff->header     = (PGSharedHeader *)base;
+            buff->buffer     = (base + dataOffset);
+            buff->size       = size;
+            buff->mask       = (size - 1);
+            buff->fd         = fd;
+            buff->cachedHead = (long)pgLoad(buff->header->head, memory_order_acquire);
+            buff->cachedTail = (long)pgLoad(buff->header->tail, memory_order_acquire);
+            return buff;
+        }
+        munmap(base, (size_t)(dataOffset + (size * 2)));
+        errno = ENOMEM;
+    }
+
+    return NULL;
+}
+
+/*
+ * Opens a new, empty, shared memory object. Without a name it is anonymous: a memfd where there is one, otherwise a
+ * POSIX shared memory object whose name is removed again straight away.
+ */
+static int pgSharedOpen(const char *name) {
+    if(name) return shm_open(name, (O_RDWR | O_CREAT | O_EXCL), 0600);
+
+#if PG_HAS_MEMFD
+    return memfd_create("PGSharedRingBuffer", MFD_CLOEXEC);
+#else
+    static _Atomic long counter = 0;
+    char                temp[64];
+
+    snprintf(temp, sizeof(temp), "/PGSharedRingBuffer.%ld.%ld", (long)getpid(), atomic_fetch_add(&counter, 1));
+    int fd = shm_open(temp, (O_RDWR | O_CREAT | O_EXCL), 0600);
+    if(fd >= 0) shm_unlink(temp);
+    return fd;
+#endif
+}
+
+PGSharedRingBuffer *PGCreateSharedRingBuffer(const char *name, long capacity) {
+    long dataOffset = pgPageSize();
+    long size       = dataOffset;
+
+    if(capacity > PG_SHARED_MAX_SIZE) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    while((long)sizeof(PGSharedHeader) > dataOffset) dataOffset += pgPageSize();
+    while(size < capacity) size <<= 1;
+
+    int fd = pgSharedOpen(name);
+
+    if(fd >= 0) {
+        if(ftruncate(fd, (off_t)(dataOffset + size)) == 0) {
+            PGSharedRingBuffer *buff = pgSharedAttach(fd, dataOffset, size);
+
+            if(buff) {
+                PGSharedHeader *h = buff->header;
+
+                // A freshly truncated object is all zeros so the head and the tail are already zero.
+                h->version    = PG_SHARED_RINGBUFFER_VERSION;
+                h->headerSize = (uint32_t)sizeof(PGSharedHeader);
+                h->dataOffset = (uint32_t)dataOffset;
+                h->size       = size;
+                pgStore(h->magic, PG_SHARED_MAGIC, memory_order_release);
+                return buff;
+            }
+        }
+
+        int err = errno;
+        close(fd);
+        if(name) shm_unlink(name);
+        errno = err;
+    }
+
+    return NULL;
+}
+
+/*
+ * Checks the header before mapping everything. The object has to be big enough to hold what the header says it
+ * does, and the header has to have been written by a library with the same layout.
+ */
+static bool pgSharedCheck(int fd, long *dataOffset, long *size) {
+    struct stat st;
+    bool        ok = false;
+
+    if(fstat(fd, &st) != 0) return false;
+
+    if(st.st_size >= (off_t)sizeof(PGSharedHeader)) {
+        PGSharedHeader *h = mmap(NULL, sizeof(PGSharedHeader), PROT_READ, MAP_SHARED, fd, 0);
+
+        if(h == MAP_FAILED) return false;
+
+        if((pgLoad(h->magic, memory_order_acquire) == PG_SHARED_MAGIC) && (h->version == PG_SHARED_RINGBUFFER_VERSION) && (h->headerSize == sizeof(PGSharedHeader))) {
+            long p = pgPageSize();
+            long o = (long)h->dataOffset;
+            long s = (long)h->size;
+
+            ok = ((o >= (long)sizeof(PGSharedHeader)) && ((o % p) == 0) && (s >= p) && (s <= PG_SHARED_MAX_SIZE) && ((s & (s - 1)) == 0) && (st.st_size == (off_t)(o + s)));
+            *dataOffset = o;
+            *size       = s;
+        }
+
+        munmap(h, sizeof(PGSharedHeader));
+    }
+
+    if(!ok) errno = EPROTO;
+    return ok;
+}
+
+PGSharedRingBuffer *PGAttachSharedRingBufferFD(int fd) {
+    long dataOffset;
+    long size;
+    int  dfd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+
+    if(dfd >= 0) {
+        if(pgSharedCheck(dfd, &dataOffset, &size)) {
+            PGSharedRingBuffer *buff = pgSharedAttach(dfd, dataOffset, size);
+            if(buff) return buff;
+        }
+
+        int err = errno;
+        close(dfd);
+        errno = err;
+    }
+
+    return NULL;
+}
+
+PGSharedRingBuffer *PGAttachSharedRingBuffer(const char *name) {
+    int fd = shm_open(name, O_RDWR, 0);
+
+    if(fd >= 0) {
+        PGSharedRingBuffer *buff = PGAttachSharedRingBufferFD(fd);
+        int                err   = errno;
+
+        close(fd);
+        errno = err;
+        return buff;
+    }
+
+    return NULL;
+}
+
+void PGDetachSharedRingBuffer(PGSharedRingBuffer *buff) {
+    if(buff) {
+        munmap(buff->header, pgMapSize(buff));
+        close(buff->fd);
+        free(buff);
+    }
+}
+
+bool PGUnlinkSharedRingBuffer(const char *name) {
+    return (shm_unlink(name) == 0);
+}
+
+int PGSharedRingBufferFD(const PGSharedRingBuffer *buff) {
+    return buff->fd;
+}
+
+/*
+ * Only look at the producer's cache line if the cached tail doesn't already cover what the caller wants.
+ */
+PG_ALWAYS_INLINE long pgAvailable(PGSharedRingBuffer *buff, long head, long wanted) {
+    long cc = (buff->cachedTail - head);
+
+    if(cc < wanted) {
+        buff->cachedTail = (long)pgLoad(buff->header->tail, memory_order_acquire);
+        cc = (buff->cachedTail - head);
+    }
+
+    return cc;
+}
+
+/*
+ * Only look at the consumer's cache line if the cached head doesn't already leave enough room.
+ */
+PG_ALWAYS_INLINE bool pgHasRoom(PGSharedRingBuffer *buff, long tail, long length) {
+    if((buff->size - (tail - buff->cachedHead)) < length) {
+        buff->cachedHead = (long)pgLoad(buff->header->head, memory_order_acquire);
+        if((buff->size - (tail - buff->cachedHead)) < length) return false;
+    }
+
+    return true;
+}
+
+void *PGSharedRingBufferReserve(PGSharedRingBuffer *buff, long length) {
+    long tail = (long)pgLoad(buff->header->tail, memory_order_relaxed);
+
+    if((length < 0) || !pgHasRoom(buff, tail, length)) return NULL;
+    return (buff->buffer + (tail & buff->mask));
+}
+
+void PGSharedRingBufferCommit(PGSharedRingBuffer *buff, long length) {
+    if(length > 0) {
+        long tail = (long)pgLoad(buff->header->tail, memory_order_relaxed);
+        pgStore(buff->header->tail, (tail + length), memory_order_release);
+    }
+}
+
+bool PGAppendToSharedRingBuffer(PGSharedRingBuffer *buff, const void *src, long length) {
+    if(src && (length > 0)) {
+        uint8_t *dest = PGSharedRingBufferReserve(buff, length);
+
+        if(dest == NULL) return false;
+        PGMemCpy(dest, src, length);
+        PGSharedRingBufferCommit(buff, length);
+    }
+
+    return true;
+}
+
+long PGPeekSpanFromSharedRingBuffer(PGSharedRingBuffer *buff, PGRingBufferSpan *span) {
+    long head = (long)pgLoad(buff->header->head, memory_order_relaxed);
+
+    span->bytes  = (buff->buffer + (head & buff->mask));
+    span->length = pgAvailable(buff, head, buff->size);
+    return span->length;
+}
+
+long PGPeekFromSharedRingBuffer(PGSharedRingBuffer *buff, void *dest, long maxLength) {
+    if(dest && (maxLength > 0)) {
+        long head = (long)pgLoad(buff->header->head, memory_order_relaxed);
+        long cc   = pg_Min(maxLength, pgAvailable(buff, head, maxLength));
+
+        PGMemCpy(dest, (buff->buffer + (head & buff->mask)), cc);
+        return cc;
+    }
+
+    return 0;
+}
+
+long PGReadFromSharedRingBuffer(PGSharedRingBuffer *buff, void *dest, long maxLength) {
+    long cc = PGPeekFromSharedRingBuffer(buff, dest, maxLength);
+
+    if(cc) pgStore(buff->header->head, (pgLoad(buff->header->head, memory_order_relaxed) + cc), memory_order_release);
+    return cc;
+}
+
+long PGSharedRingBufferConsume(PGSharedRingBuffer *buff, long length) {
+    if(length > 0) {
+        long head = (long)pgLoad(buff->header->head, memory_order_relaxed);
+        long cc   = pg_Min(length, pgAvailable(buff, head, length));
+
+        if(cc) pgStore(buff->header->head, (head + cc), memory_order_release);
+        return cc;
+    }
+
+    return 0;
+}
+
+long PGSharedRingBufferCapacity(const PGSharedRingBuffer *buff) {
+    return buff->size;
+}
+
+long PGSharedRingBufferCount(const PGSharedRingBuffer *buff) {
+    long head = (long)pgLoad(buff->header->head, memory_order_acquire);
+    return ((long)pgLoad(buff->header->tail, memory_order_acquire) - head);
+}
+
+long PGSharedRingBufferRemaining(const PGSharedRingBuffer *buff) {
+    return (buff->size - PGSharedRingBufferCount(buff));
+}
+
+#pragma clang diagnostic pop
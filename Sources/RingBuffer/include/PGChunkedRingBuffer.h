@@ -0,0 +1,179 @@
+//
+//  PGChunkedRingBuffer.h
+//  PGRingBuffer
+//
+//  Created by Galen Rhodes on 10/16/26.
+//  Copyright © 2020 Project Galen. All rights reserved.
+//
+
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "OCUnusedGlobalDeclarationInspection"
+#ifndef PGChunkedRingBuffer_h
+#define PGChunkedRingBuffer_h
+
+#include "PGRingBuffer.h"
+
+__BEGIN_DECLS
+
+/**
+ * A ring buffer whose storage is a circular list of fixed size chunks rather than one block. Growing it just
+ * adds chunks so, unlike `PGRingBuffer`, the bytes already in it are never copied and there is no latency spike
+ * when a very large buffer has to grow. Chunks that have been read are recycled to the back of the list. The
+ * bytes are only contiguous within a chunk so whole-buffer access is through a list of spans (see
+ * `PGGetChunkedRingBufferSpans`).
+ */
+typedef struct _st_pg_chunked_ringbuffer_ PGChunkedRingBuffer;
+
+/**
+ * The default chunk size, in bytes.
+ */
+#define PG_CHUNKED_DEFAULT_CHUNK_SIZE (64 * 1024)
+
+/**
+ * Creates and initializes a new chunked ring buffer.
+ *
+ * @param chunkSize the size of each chunk. This will be rounded up to the next power of two (minimum 64). If
+ *                  zero or less then `PG_CHUNKED_DEFAULT_CHUNK_SIZE` is used.
+ * @param maxSpareChunks the most empty chunks to keep around for reuse once they have been read. Any more than
+ *                       this are freed.
+ * @return the newly created ring buffer or `NULL` if there is no power of two that big that a `long` can hold
+ *         (`errno` is set to `EINVAL`) or there was not enough memory.
+ */
+PG_EXPORT PGChunkedRingBuffer *PGCreateChunkedRingBuffer(long chunkSize, long maxSpareChunks);
+
+/**
+ * Creates and initializes a new chunked ring buffer using the given allocator for its header, its chunks, and
+ * its list of chunks. The allocator must outlive the ring buffer.
+ *
+ * @param chunkSize the size of each chunk. See `PGCreateChunkedRingBuffer`.
+ * @param maxSpareChunks the most empty chunks to keep around for reuse.
+ * @param allocator the allocator. If `NULL` then `malloc`, `realloc` and `free` are used.
+ * @return the newly created ring buffer or `NULL` if `chunkSize` is too big (`errno` is set to `EINVAL`) or
+ *         there was not enough memory.
+ */
+PG_EXPORT PGChunkedRingBuffer *PGCreateChunkedRingBufferWithAllocator(long chunkSize, long maxSpareChunks, const PGRingBufferAllocator *allocator);
+
+/**
+ * Deallocates an existing chunked ring buffer.
+ *
+ * @param buff the ring buffer to deallocate.
+ */
+PG_EXPORT void PGDiscardChunkedRingBuffer(PGChunkedRingBuffer *buff);
+
+/**
+ * Append the given bytes to the end of the ring buffer - adding chunks if needed.
+ *
+ * @param buff the buffer.
+ * @param src the source bytes.
+ * @param length the number of bytes to append.
+ * @return `true` if successful or `false` if a chunk could not be allocated, in which case nothing is appended.
+ */
+PG_EXPORT bool PGAppendToChunkedRingBuffer(PGChunkedRingBuffer *buff, const void *src, long length);
+
+/**
+ * Append a single byte to the end of the ring buffer - adding a chunk if needed.
+ *
+ * @param buff the buffer.
+ * @param byte the byte.
+ * @return `true` if successful or `false` if a chunk could not be allocated.
+ */
+PG_EXPORT bool PGAppendByteToChunkedRingBuffer(PGChunkedRingBuffer *buff, uint8_t byte);
+
+/**
+ * Reads up to `maxLength` bytes from the ring buffer into `dest`.
+ *
+ * @param buff the ring buffer.
+ * @param dest the destination buffer.
+ * @param maxLength the size of the destination buffer.
+ * @return the number of bytes actually read.
+ */
+PG_EXPORT long PGReadFromChunkedRingBuffer(PGChunkedRingBuffer *buff, void *dest, long maxLength);
+
+/**
+ * Get bytes from the buffer without removing them.
+ *
+ * @param buff the buffer.
+ * @param dest the destination buffer.
+ * @param maxLength the length of the destination buffer.
+ * @return the number of bytes read.
+ */
+PG_EXPORT long PGPeekFromChunkedRingBuffer(const PGChunkedRingBuffer *buff, void *dest, long maxLength);
+
+/**
+ * Effectively reads and forgets the next `length` bytes from the buffer. Every chunk that is emptied is
+ * recycled.
+ *
+ * @param buff the buffer.
+ * @param length the number of bytes to consume from the buffer.
+ */
+PG_EXPORT void PGChunkedRingBufferConsume(PGChunkedRingBuffer *buff, long length);
+
+/**
+ * Get a single byte from the buffer without removing it. As with `PGGetByteFromRingBuffer`, an offset outside
+ * of the buffer is taken modulo the number of bytes in it.
+ *
+ * @param buff the buffer.
+ * @param offset the offset from the beginning of the buffer.
+ * @return the byte or zero if the buffer is empty.
+ */
+PG_EXPORT uint8_t PGGetByteFromChunkedRingBuffer(const PGChunkedRingBuffer *buff, long offset);
+
+/**
+ * Replace a single byte in the buffer. As with `PGSetByteOnRingBuffer`, an index outside of the buffer is taken
+ * modulo the number of bytes in it. Nothing happens if the buffer is empty.
+ *
+ * @param buff the buffer.
+ * @param index the offset from the beginning of the buffer.
+ * @param byte the new byte.
+ */
+PG_EXPORT void PGSetByteOnChunkedRingBuffer(PGChunkedRingBuffer *buff, long index, uint8_t byte);
+
+/**
+ * Returns the bytes in the ring buffer as a list of spans, in order, one per chunk that they touch. This is the
+ * chunked equivalent of `PGGetRingBufferBuffer` and `PGPeekSpansFromRingBuffer`, and the spans can be handed
+ * straight to `writev`. They are only valid until the next call that modifies the buffer.
+ *
+ * @param buff the buffer.
+ * @param spans receives up to `maxSpans` spans.
+ * @param maxSpans the size of `spans`.
+ * @return the number of spans needed to cover all of the bytes, which may be more than `maxSpans`.
+ */
+PG_EXPORT long PGGetChunkedRingBufferSpans(const PGChunkedRingBuffer *buff, PGRingBufferSpan *spans, long maxSpans);
+
+/**
+ * Clears the buffer.
+ *
+ * @param buff the buffer.
+ * @param keepCapacity if true then the chunks are kept for reuse. If false then all but one of them are freed.
+ */
+PG_EXPORT void PGClearChunkedRingBuffer(PGChunkedRingBuffer *buff, bool keepCapacity);
+
+/**
+ * Returns the size of each of the ring buffer's chunks.
+ *
+ * @param buff the buffer.
+ * @return the chunk size in bytes.
+ */
+PG_EXPORT long PGChunkedRingBufferChunkSize(const PGChunkedRingBuffer *buff);
+
+/**
+ * Returns the number of bytes that the ring buffer can hold without allocating another chunk.
+ *
+ * @param buff the buffer.
+ * @return the current capacity.
+ */
+PG_EXPORT long PGChunkedRingBufferCapacity(const PGChunkedRingBuffer *buff);
+
+/**
+ * Returns the number of bytes currently in the ring buffer ready to be read.
+ *
+ * @param buff the buffer.
+ * @return the number of bytes in the buffer.
+ */
+PG_EXPORT long PGChunkedRingBufferCount(const PGChunkedRingBuffer *buff);
+
+__END_DECLS
+
+#endif /* PGChunkedRingBuffer_h */
+
+#pragma clang diagnostic pop
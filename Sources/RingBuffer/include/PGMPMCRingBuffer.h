@@ -0,0 +1,88 @@
+//
+//  PGMPMCRingBuffer.h
+//  PGRingBuffer
+//
+//  Created by Galen Rhodes on 10/16/26.
+//  Copyright © 2020 Project Galen. All rights reserved.
+//
+
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "OCUnusedGlobalDeclarationInspection"
+#ifndef PGMPMCRingBuffer_h
+#define PGMPMCRingBuffer_h
+
+#include "PGRingBuffer.h"
+
+__BEGIN_DECLS
+
+/**
+ * A bounded, lock-free queue of variable length records that can be shared by any number of producer and
+ * consumer threads. The storage is a ring of fixed size cells, each with its own sequence number. A record
+ * occupies as many consecutive cells as it needs so records are always read whole and in the order that they
+ * were claimed.
+ */
+typedef struct _st_pg_mpmc_ringbuffer_ PGMPMCRingBuffer;
+
+/**
+ * Creates and initializes a new multi-producer/multi-consumer record ring buffer.
+ *
+ * @param capacity the capacity of the ring buffer in bytes. The number of cells is rounded up to the next power
+ *                 of two.
+ * @param cellSize the size of each cell in bytes. If less than or equal to zero then the default is 64. This is
+ *                 rounded up to a multiple of eight. Records smaller than this waste the rest of their cell.
+ * @return the newly created ring buffer or `NULL` if `capacity` or `cellSize` is more than `LONG_MAX / 4`
+ *         (`errno` is set to `EINVAL`) or there was not enough memory.
+ */
+PG_EXPORT PGMPMCRingBuffer *PGCreateMPMCRingBuffer(long capacity, long cellSize);
+
+/**
+ * Deallocates an existing multi-producer/multi-consumer ring buffer. No thread may be using the buffer.
+ *
+ * @param buff the ring buffer to deallocate.
+ */
+PG_EXPORT void PGDiscardMPMCRingBuffer(PGMPMCRingBuffer *buff);
+
+/**
+ * Appends a single record to the ring buffer. May be called from any thread.
+ *
+ * @param buff the ring buffer.
+ * @param src the bytes of the record.
+ * @param length the number of bytes in the record.
+ * @return `true` if successful or `false` if the ring buffer is full or the record is larger than
+ *         `PGMPMCRingBufferMaxRecordLength(buff)`.
+ */
+PG_EXPORT bool PGAppendRecordToMPMCRingBuffer(PGMPMCRingBuffer *buff, const void *src, long length);
+
+/**
+ * Reads the next record from the ring buffer. May be called from any thread.
+ *
+ * @param buff the ring buffer.
+ * @param dest the destination buffer.
+ * @param maxLength the size of the destination buffer.
+ * @param length receives the length of the next record or zero if the ring buffer is empty.
+ * @return `true` if a record was read. `false` if the ring buffer is empty or the next record is larger than
+ *         `maxLength`. In the latter case the record is left in the buffer.
+ */
+PG_EXPORT bool PGReadRecordFromMPMCRingBuffer(PGMPMCRingBuffer *buff, void *dest, long maxLength, long *length);
+
+/**
+ * Returns the TOTAL capacity of the ring buffer in bytes.
+ *
+ * @param buff the ring buffer.
+ * @return the total capacity.
+ */
+PG_EXPORT long PGMPMCRingBufferCapacity(const PGMPMCRingBuffer *buff);
+
+/**
+ * Returns the size of the largest record that the ring buffer can hold.
+ *
+ * @param buff the ring buffer.
+ * @return the size of the largest record.
+ */
+PG_EXPORT long PGMPMCRingBufferMaxRecordLength(const PGMPMCRingBuffer *buff);
+
+__END_DECLS
+
+#endif /* PGMPMCRingBuffer_h */
+
+#pragma clang diagnostic pop
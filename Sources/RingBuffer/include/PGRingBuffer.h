@@ -21,16 +21,195 @@
 
 __BEGIN_DECLS
 
+/**
+ * A set of callbacks used to allocate a ring buffer's header and (heap) storage. The size of the block is passed
+ * back to `realloc` and `free` so that size-classed allocators don't need to keep their own headers. Mirrored,
+ * aligned, and huge page storage never comes from the allocator.
+ */
+typedef struct _st_pg_ringbuffer_allocator_ {
+    /**
+     * Allocates `size` bytes. Returns `NULL` if there is not enough memory.
+     */
+    void *(*alloc)(void *context, long size);
+    /**
+     * Resizes the block at `ptr` from `oldSize` bytes to `newSize` bytes, keeping its contents. Returns `NULL`,
+     * and leaves the original block alone, if there is not enough memory.
+     */
+    void *(*realloc)(void *context, void *ptr, long oldSize, long newSize);
+    /**
+     * Frees the `size` byte block at `ptr`.
+     */
+    void (*free)(void *context, void *ptr, long size);
+    /**
+     * Passed to each of the callbacks.
+     */
+    void *context;
+}               PGRingBufferAllocator;
+
+/**
+ * Controls how a ring buffer grows and shrinks. See `PGSetRingBufferPolicy`.
+ */
+typedef struct _st_pg_ringbuffer_policy_ {
+    /**
+     * The factor that the size of the buffer is multiplied by each time it needs to grow. Values less than or
+     * equal to one mean the default of two.
+     */
+    double growthFactor;
+    /**
+     * The largest capacity, in bytes, that the buffer is allowed to grow to. Anything that would need more than
+     * this fails instead. Zero means unlimited.
+     */
+    long   maxCapacity;
+    /**
+     * The fraction of the capacity below which the buffer counts as under used.
+     */
+    double shrinkWatermark;
+    /**
+     * The number of times in a row that the buffer has to be found under used, as it is read from, before it is
+     * automatically shrunk with `PGShrinkRingBuffer`. Zero turns automatic shrinking off.
+     */
+    long   shrinkAfter;
+}               PGRingBufferPolicy;
+
+#ifndef PG_RINGBUFFER_STATS
+/**
+ * Set to 1 to have every ring buffer keep the counters in `PGRingBufferStats`. This changes the layout of
+ * `PGRingBuffer` so the library and everything that uses it have to be compiled with the same setting. When it
+ * is zero (the default) the counters are not compiled in at all.
+ */
+#define PG_RINGBUFFER_STATS 0
+#endif
+
+/**
+ * Counters describing what a ring buffer has been doing. Only kept when the library is compiled with
+ * `PG_RINGBUFFER_STATS` set to 1. See `PGGetRingBufferStats`.
+ */
+typedef struct _st_pg_ringbuffer_stats_ {
+    /**
+     * The number of times the storage has been grown.
+     */
+    long resizes;
+    /**
+     * The number of times the storage has been shrunk, either by `PGShrinkRingBuffer` or by
+     * `PGClearRingBuffer`.
+     */
+    long shrinks;
+    /**
+     * The number of bytes that had to be copied or moved to grow or shrink the storage. Copies done inside the
+     * allocator's `realloc` are not counted.
+     */
+    long resizeBytesMoved;
+    /**
+     * The number of bytes moved by `PGDefragRingBuffer` and `PGMakeRingBufferContiguous`.
+     */
+    long defragBytesMoved;
+    /**
+     * The number of reads and writes that had to be split in two because they wrapped around the end of the
+     * storage.
+     */
+    long wrapCopies;
+    /**
+     * The most bytes that have been in the buffer at one time.
+     */
+    long peakCount;
+    /**
+     * The number of times that new storage could not be allocated.
+     */
+    long failedAllocations;
+}               PGRingBufferStats;
+
 typedef struct _st_pg_ringbuffer_ {
     long    initSize;
     long    size;
     long    head;
     long    tail;
+    long    mask;
+    int     flags;
+    int     fd;
     uint8_t *buffer;
+
+    const PGRingBufferAllocator *allocator;
+    PGRingBufferPolicy          policy;
+    long                        underUsed;
+    long                        dropped;
+#if PG_RINGBUFFER_STATS
+    PGRingBufferStats           stats;
+#endif
 }               PGRingBuffer;
 
+/**
+ * A contiguous run of bytes inside a ring buffer's storage.
+ */
+typedef struct _st_pg_ringbuffer_span_ {
+    uint8_t *bytes;
+    long    length;
+}               PGRingBufferSpan;
+
 #define PG_EXPORT extern __attribute__((__visibility__("default")))
 
+#define PG_ALWAYS_INLINE static inline __attribute__((__always_inline__))
+
+/**
+ * The default creation flags. The size of the buffer is whatever is needed and indexes are wrapped using
+ * modulo arithmetic.
+ */
+#define PG_RINGBUFFER_DEFAULT 0x0000
+/**
+ * The size of the buffer is always kept at a power of two so that indexes can be wrapped using a simple bit
+ * mask rather than an integer division.
+ */
+#define PG_RINGBUFFER_POW2    0x0001
+/**
+ * Once the buffer is large enough (see `PG_RINGBUFFER_MIRROR_MIN_SIZE`) the storage is mapped twice, back to
+ * back, in virtual memory so that the bytes from the head to the tail are always contiguous. Smaller buffers,
+ * and platforms that do not support it, use the normal heap storage. (Linux only)
+ */
+#define PG_RINGBUFFER_MIRRORED 0x0002
+/**
+ * The storage is aligned to a cache line boundary. It comes from `posix_memalign` rather than the ring
+ * buffer's allocator.
+ */
+#define PG_RINGBUFFER_CACHE_ALIGNED 0x0004
+/**
+ * The storage is aligned to a page boundary. It comes from `posix_memalign` rather than the ring buffer's
+ * allocator.
+ */
+#define PG_RINGBUFFER_PAGE_ALIGNED 0x0008
+/**
+ * Once the buffer is large enough (see `PG_RINGBUFFER_HUGEPAGE_MIN_SIZE`) the storage is mapped directly and
+ * backed by huge pages: pre-reserved ones (`MAP_HUGETLB`) if there are any, otherwise transparent huge pages
+ * (`madvise(MADV_HUGEPAGE)`) on a huge page aligned mapping. Smaller buffers are page aligned. (Linux only.
+ * Elsewhere this is the same as `PG_RINGBUFFER_PAGE_ALIGNED`.)
+ */
+#define PG_RINGBUFFER_HUGEPAGES 0x0010
+/**
+ * The buffer never grows. Appending to it when it is full drops the oldest bytes from the head instead, so
+ * appends never allocate and never fail, and the buffer always holds the most recent bytes - a flight recorder.
+ * The dropped bytes are counted (see `PGRingBufferDroppedBytes`). Records appended with
+ * `PGAppendRecordsToRingBuffer` are dropped whole. Prepending still fails if there isn't room.
+ */
+#define PG_RINGBUFFER_OVERWRITE 0x0020
+
+/**
+ * The policy that every ring buffer starts with: double on growth, no maximum capacity, and no automatic
+ * shrinking (watermark 25% but `shrinkAfter` is zero).
+ */
+#define PG_RINGBUFFER_DEFAULT_POLICY ((PGRingBufferPolicy){ 2.0, 0, 0.25, 0 })
+
+#ifndef PG_RINGBUFFER_HUGEPAGE_MIN_SIZE
+/**
+ * The smallest size, in bytes, at which a `PG_RINGBUFFER_HUGEPAGES` ring buffer switches to huge page storage.
+ */
+#define PG_RINGBUFFER_HUGEPAGE_MIN_SIZE (2 * 1024 * 1024)
+#endif
+
+#ifndef PG_RINGBUFFER_MIRROR_MIN_SIZE
+/**
+ * The smallest size, in bytes, at which a `PG_RINGBUFFER_MIRRORED` ring buffer switches to mirrored storage.
+ */
+#define PG_RINGBUFFER_MIRROR_MIN_SIZE (64 * 1024)
+#endif
+
 PG_EXPORT long PGHostByteOrder(void);
 
 PG_EXPORT long PGLittleEndianByteOrder(void);
@@ -45,6 +224,46 @@ PG_EXPORT long PGBigEndianByteOrder(void);
  */
 PG_EXPORT PGRingBuffer *PGCreateRingBuffer(long initialSize);
 
+/**
+ * Creates and initializes a new ring buffer using the given creation flags.
+ *
+ * @param initialSize the initial size of the ring buffer. If less then five then the default is five. If the
+ *                    `PG_RINGBUFFER_POW2` flag is given then the size is rounded up to the next power of two
+ *                    (minimum eight).
+ * @param flags the creation flags. (`PG_RINGBUFFER_DEFAULT`, `PG_RINGBUFFER_POW2`, `PG_RINGBUFFER_MIRRORED`,
+ *              `PG_RINGBUFFER_CACHE_ALIGNED`, `PG_RINGBUFFER_PAGE_ALIGNED`, `PG_RINGBUFFER_HUGEPAGES`,
+ *              `PG_RINGBUFFER_OVERWRITE`)
+ * @return the newly created ring buffer or `NULL` if `initialSize` is more than a ring buffer can hold (`errno` is
+ *         set to `EINVAL`) or there was not enough memory.
+ */
+PG_EXPORT PGRingBuffer *PGCreateRingBufferWithFlags(long initialSize, int flags);
+
+/**
+ * Creates and initializes a new ring buffer using the given creation flags and allocator. The ring buffer's
+ * header and storage are both allocated with the allocator, and are given back to it when the ring buffer is
+ * discarded, so the allocator must outlive the ring buffer.
+ *
+ * @param initialSize the initial size of the ring buffer. See `PGCreateRingBufferWithFlags`.
+ * @param flags the creation flags. (`PG_RINGBUFFER_DEFAULT`, `PG_RINGBUFFER_POW2`, `PG_RINGBUFFER_MIRRORED`,
+ *              `PG_RINGBUFFER_CACHE_ALIGNED`, `PG_RINGBUFFER_PAGE_ALIGNED`, `PG_RINGBUFFER_HUGEPAGES`,
+ *              `PG_RINGBUFFER_OVERWRITE`)
+ * @param allocator the allocator. If `NULL` then `malloc`, `realloc` and `free` are used.
+ * @return the newly created ring buffer or `NULL` if `initialSize` is more than a ring buffer can hold (`errno` is
+ *         set to `EINVAL`) or there was not enough memory.
+ */
+PG_EXPORT PGRingBuffer *PGCreateRingBufferWithAllocator(long initialSize, int flags, const PGRingBufferAllocator *allocator);
+
+/**
+ * Creates and initializes a new ring buffer whose size is always a power of two. This is the same as calling
+ * `PGCreateRingBufferWithFlags(initialSize, PG_RINGBUFFER_POW2)`.
+ *
+ * @param initialSize the initial size of the ring buffer. This will be rounded up to the next power of two
+ *                    (minimum eight).
+ * @return the newly created ring buffer or `NULL` if there is no power of two that big that a ring buffer can
+ *         hold (`errno` is set to `EINVAL`) or there was not enough memory.
+ */
+PG_EXPORT PGRingBuffer *PGCreateRingBufferPow2(long initialSize);
+
 /**
  * Deallocates an existing ring buffer.
  *
@@ -52,10 +271,110 @@ PG_EXPORT PGRingBuffer *PGCreateRingBuffer(long initialSize);
  */
 PG_EXPORT void PGDiscardRingBuffer(PGRingBuffer *buff);
 
+/**
+ * Sets the ring buffer's growth and shrink policy. The policy does not take effect until the next time the
+ * buffer needs to grow or is read from.
+ *
+ * @param buff the ring buffer.
+ * @param policy the new policy. If `NULL` then `PG_RINGBUFFER_DEFAULT_POLICY` is used.
+ */
+PG_EXPORT void PGSetRingBufferPolicy(PGRingBuffer *buff, const PGRingBufferPolicy *policy);
+
+/**
+ * Gets the ring buffer's growth and shrink policy.
+ *
+ * @param buff the ring buffer.
+ * @param policy receives the policy.
+ */
+PG_EXPORT void PGGetRingBufferPolicy(const PGRingBuffer *buff, PGRingBufferPolicy *policy);
+
+/**
+ * Shrinks the ring buffer's storage to twice the number of bytes in it, but never below its initial size,
+ * without losing any of them. Heap storage is compacted in place (see `PGDefragRingBuffer`) and then
+ * reallocated. Mirrored storage is copied to new, smaller, storage. Nothing happens if the storage would not
+ * get any smaller.
+ *
+ * @param buff the ring buffer.
+ * @return `true` if successful or `false` if the new storage could not be allocated, in which case the ring
+ *         buffer is left as it was.
+ */
+PG_EXPORT bool PGShrinkRingBuffer(PGRingBuffer *buff);
+
+/**
+ * Gets a snapshot of the ring buffer's counters.
+ *
+ * @param buff the ring buffer.
+ * @param stats receives the counters. If the library was compiled without `PG_RINGBUFFER_STATS` they are all
+ *              zero.
+ * @return `true` if the counters are being kept or `false` if the library was compiled without them.
+ */
+PG_EXPORT bool PGGetRingBufferStats(const PGRingBuffer *buff, PGRingBufferStats *stats);
+
+/**
+ * Sets all of the ring buffer's counters back to zero. The peak count starts again from the number of bytes
+ * currently in the buffer. Does nothing if the library was compiled without `PG_RINGBUFFER_STATS`.
+ *
+ * @param buff the ring buffer.
+ */
+PG_EXPORT void PGResetRingBufferStats(PGRingBuffer *buff);
+
+/**
+ * Returns the number of bytes that a `PG_RINGBUFFER_OVERWRITE` ring buffer has dropped to make room for new ones.
+ * This includes the start of any single append that was longer than the whole capacity.
+ *
+ * @param buff the ring buffer.
+ * @return the number of bytes dropped since the buffer was created or the count was last reset.
+ */
+PG_EXPORT long PGRingBufferDroppedBytes(const PGRingBuffer *buff);
+
+/**
+ * Sets the ring buffer's count of dropped bytes back to zero.
+ *
+ * @param buff the ring buffer.
+ * @return the count before it was reset.
+ */
+PG_EXPORT long PGResetRingBufferDroppedBytes(PGRingBuffer *buff);
+
+/**
+ * Moves the bytes in the ring buffer so that they are contiguous and start at the beginning of the storage.
+ * If the buffer is currently using mirrored storage then the bytes are already contiguous and nothing is moved.
+ * The bytes are rotated in place so no memory is allocated.
+ *
+ * @param buff the ring buffer.
+ * @return always `true`.
+ */
 PG_EXPORT bool PGDefragRingBuffer(PGRingBuffer *buff);
 
+/**
+ * Makes sure that at least the next `length` bytes in the ring buffer are contiguous and returns a pointer to
+ * the first of them. If they already are then nothing is moved. Otherwise, if the free space allows it, the
+ * bytes are slid back just far enough that the first `length` bytes end at the end of the storage. Only if
+ * there isn't enough free space for that is the whole buffer defragmented. No memory is allocated.
+ *
+ * @param buff the ring buffer.
+ * @param length the number of bytes that need to be contiguous. Limited to the number of bytes in the buffer.
+ * @return the pointer to the first byte in the buffer.
+ */
+PG_EXPORT uint8_t *PGMakeRingBufferContiguous(PGRingBuffer *buff, long length);
+
+/**
+ * Returns a pointer to the bytes in the ring buffer as a single contiguous block. If the bytes are not already
+ * contiguous then they are made so with `PGMakeRingBufferContiguous`.
+ *
+ * @param buff the ring buffer.
+ * @param size receives the number of bytes at the returned pointer.
+ * @return the pointer to the first byte.
+ */
 PG_EXPORT uint8_t *PGGetRingBufferBuffer(PGRingBuffer *buff, long *size);
 
+/**
+ * Returns `true` if the ring buffer is currently using mirrored storage.
+ *
+ * @param buff the ring buffer.
+ * @return `true` if the bytes from the head to the tail are always contiguous.
+ */
+PG_EXPORT bool PGRingBufferIsMirrored(const PGRingBuffer *buff);
+
 /**
  * Reads up to `maxLength` bytes from the ring buffer into `dest`. If `maxLength` is more then the number of
  * bytes in the ring buffer then those bytes will be read and the actual number read will be returned.
@@ -89,6 +408,19 @@ PG_EXPORT long PGReadLastFromRingBuffer(PGRingBuffer *buff, void *dest, long max
  */
 PG_EXPORT long PGPeekFromRingBuffer(PGRingBuffer *buff, void *dest, long maxLength);
 
+/**
+ * Get the bytes in the buffer, in place, without copying or removing them. The bytes are returned as two spans.
+ * The second span is the part that wraps around to the beginning of the storage and will have a length of zero
+ * if there is no wrap (which is always the case for mirrored storage). Once the bytes have been processed they
+ * can be released with `PGRingBufferConsume`. The spans are only valid until the next call that modifies the
+ * buffer.
+ *
+ * @param buff the buffer.
+ * @param spans receives the two readable spans.
+ * @return the total number of bytes in the two spans.
+ */
+PG_EXPORT long PGPeekSpansFromRingBuffer(const PGRingBuffer *buff, PGRingBufferSpan spans[2]);
+
 /**
  * Get a single byte from the buffer. This does not change the buffer nor it's indexes. If the offset is greater than the number of bytes in the buffer then the resulting offset is
  * the given offset MOD the number of bytes.  IE: (offset % count)
@@ -109,6 +441,43 @@ PG_EXPORT uint8_t PGGetByteFromRingBuffer(PGRingBuffer *buff, long offset);
  */
 PG_EXPORT void PGSetByteOnRingBuffer(PGRingBuffer *buff, long index, uint8_t byte);
 
+/**
+ * Finds the first occurrence of a byte in the ring buffer, looking at both parts of the storage in place. Use
+ * this rather than calling `PGGetByteFromRingBuffer` for each byte.
+ *
+ * @param buff the buffer.
+ * @param offset the offset from the head at which to start looking. Negative offsets are the same as zero.
+ * @param byte the byte to look for.
+ * @return the offset from the head of the first matching byte at or after `offset` or -1 if there isn't one.
+ */
+PG_EXPORT long PGFindByteInRingBuffer(const PGRingBuffer *buff, long offset, uint8_t byte);
+
+/**
+ * Finds the first byte in the ring buffer that is any one of the bytes in a set. Handy for protocols that can
+ * end a field with more than one delimiter (CR or LF for example).
+ *
+ * @param buff the buffer.
+ * @param offset the offset from the head at which to start looking. Negative offsets are the same as zero.
+ * @param set the bytes to look for.
+ * @param setLength the number of bytes in `set`.
+ * @return the offset from the head of the first matching byte at or after `offset` or -1 if there isn't one or
+ *         `set` is empty.
+ */
+PG_EXPORT long PGFindAnyByteInRingBuffer(const PGRingBuffer *buff, long offset, const uint8_t *set, long setLength);
+
+/**
+ * Finds the first occurrence of a sequence of bytes in the ring buffer. A match may start before the end of the
+ * storage and finish after wrapping around to the beginning of it.
+ *
+ * @param buff the buffer.
+ * @param offset the offset from the head at which to start looking. Negative offsets are the same as zero.
+ * @param pattern the bytes to look for.
+ * @param length the number of bytes in `pattern`.
+ * @return the offset from the head of the first byte of the first match starting at or after `offset` or -1 if
+ *         there isn't one or `pattern` is empty.
+ */
+PG_EXPORT long PGFindInRingBuffer(const PGRingBuffer *buff, long offset, const void *pattern, long length);
+
 /**
  * Ensures that the ring buffer has enough capacity to accept the `needed` number of new bytes.
  * If there is not enough capacity then the size of the buffer is doubled until there is enough.
@@ -116,12 +485,15 @@ PG_EXPORT void PGSetByteOnRingBuffer(PGRingBuffer *buff, long index, uint8_t byt
  * @param buff the buffer.
  * @param needed the number of new bytes to be added.
  * @return `true` if there is enough room or the resize was successful. `false` if there was not
- *         enough capacity and there was not enough memory to resize the buffer.
+ *         enough capacity and there was not enough memory to resize the buffer. Always `false` for a
+ *         `PG_RINGBUFFER_OVERWRITE` buffer without enough room since it never grows.
  */
 PG_EXPORT bool PGEnsureCapacity(PGRingBuffer *buff, long needed);
 
 /**
- * Append the given bytes to the end of the ring buffer - resizing the buffer if needed.
+ * Append the given bytes to the end of the ring buffer - resizing the buffer if needed. A
+ * `PG_RINGBUFFER_OVERWRITE` buffer drops its oldest bytes instead, and if `length` is more than its capacity then
+ * only the last bytes of `src` are kept.
  *
  * @param buff the buffer.
  * @param src the source bytes.
@@ -150,6 +522,79 @@ PG_EXPORT bool PGAppendRingBufferToRingBuffer(PGRingBuffer *dest, const PGRingBu
  */
 PG_EXPORT bool PGPrependRingBufferToRingBuffer(PGRingBuffer *dest, const PGRingBuffer *src);
 
+/**
+ * Moves the contents of the source ring buffer to the end of the destination ring buffer, leaving the source
+ * empty. If the destination is empty then the two buffers just trade storage and nothing is copied. Otherwise
+ * whichever of the two holds fewer bytes is the one that gets copied: either the source's bytes are appended to
+ * the destination, or the destination's bytes are prepended to the source and then the buffers trade storage.
+ *
+ * Storage is only traded between buffers that were created with the same allocator and the same storage flags
+ * (`PG_RINGBUFFER_POW2`, `PG_RINGBUFFER_MIRRORED`, and the alignment flags), that don't have the
+ * `PG_RINGBUFFER_OVERWRITE` flag, and that have the same maximum capacity in their policies. Otherwise
+ * this is the same as `PGAppendRingBufferToRingBuffer` followed by emptying the source.
+ *
+ * @param dest the destination ring buffer.
+ * @param src the source ring buffer.
+ * @return `true` if successful or `false` if buffer size could not be expanded due to lack of memory, in which
+ *         case neither buffer is changed.
+ */
+PG_EXPORT bool PGMoveRingBufferToRingBuffer(PGRingBuffer *dest, PGRingBuffer *src);
+
+/**
+ * Moves the contents of the source ring buffer to the beginning of the destination ring buffer, leaving the
+ * source empty. Works the same way as `PGMoveRingBufferToRingBuffer`.
+ *
+ * @param dest the destination ring buffer.
+ * @param src the source ring buffer.
+ * @return `true` if successful or `false` if buffer size could not be expanded due to lack of memory, in which
+ *         case neither buffer is changed.
+ */
+PG_EXPORT bool PGMoveRingBufferToFrontOfRingBuffer(PGRingBuffer *dest, PGRingBuffer *src);
+
+/**
+ * Splits the ring buffer in two. The first `offset` bytes are moved to a new ring buffer, with the same flags,
+ * allocator and policy, and the rest stay where they are. Only the smaller of the two parts is copied: if the
+ * bytes after `offset` are fewer then they are copied to new storage and the two buffers trade storage.
+ *
+ * @param buff the ring buffer.
+ * @param offset the number of bytes to split off. Limited to the number of bytes in the buffer.
+ * @return the new ring buffer holding the first `offset` bytes or `NULL` if there was not enough memory, in which
+ *         case `buff` is not changed.
+ */
+PG_EXPORT PGRingBuffer *PGSplitRingBuffer(PGRingBuffer *buff, long offset);
+
+/**
+ * Reserves room for up to `length` bytes at the end of the ring buffer - resizing the buffer if needed - so that
+ * the caller can write them in place. The room is returned as two spans. The second span is the part that wraps
+ * around to the beginning of the storage and will have a length of zero if there is no wrap. Nothing is added to
+ * the buffer until `PGRingBufferCommit` is called. The spans are only valid until the next call that modifies
+ * the buffer.
+ *
+ * A `PG_RINGBUFFER_OVERWRITE` buffer doesn't drop anything here. If there isn't enough free room then the spans
+ * run on over the oldest bytes, which stay in the buffer until `PGRingBufferCommit` drops just as many of them as
+ * the committed bytes need. Writing into that part of the spans overwrites them in place so ask for no more than
+ * `PGRingBufferRemaining` if they still have to be readable before the commit.
+ *
+ * @param buff the buffer.
+ * @param length the number of bytes wanted.
+ * @param spans receives the two writable spans.
+ * @return the total number of bytes in the two spans. This will be less than `length` only if the buffer could
+ *         not be expanded due to lack of memory or, for a `PG_RINGBUFFER_OVERWRITE` buffer, if `length` is more
+ *         than the capacity.
+ */
+PG_EXPORT long PGRingBufferReserve(PGRingBuffer *buff, long length, PGRingBufferSpan spans[2]);
+
+/**
+ * Adds `length` bytes, previously written into the spans returned by `PGRingBufferReserve`, to the end of the
+ * ring buffer. This never resizes the buffer. If `length` is more than the room remaining then only the room
+ * remaining is added, except that a `PG_RINGBUFFER_OVERWRITE` buffer drops as many of its oldest bytes as it
+ * takes to add them all, up to its capacity.
+ *
+ * @param buff the buffer.
+ * @param length the number of bytes actually written.
+ */
+PG_EXPORT void PGRingBufferCommit(PGRingBuffer *buff, long length);
+
 /**
  * Append a single byte to the end of the ring buffer - resizing the buffer if needed.
  *
@@ -406,6 +851,87 @@ PG_EXPORT void PGSwap64Alt(void *buffer, long length);
  */
 PG_EXPORT void PGSwap64AltAlt(void *buffer, long length);
 
+/**
+ * Reads up to `maxWords` whole 16-bit words from the beginning of the ring buffer into `dest`, converting them
+ * from `byteOrder` to the host byte order on the way. This is the same as `PGReadFromRingBuffer` followed by
+ * `PGSwap16` but the bytes are only gone over once. If `byteOrder` is already the host byte order then it's just
+ * a read. A trailing partial word is left in the buffer.
+ *
+ * @param buff the buffer.
+ * @param dest the destination.
+ * @param maxWords the most words to read.
+ * @param byteOrder the byte order of the words in the buffer. (`PGBigEndianByteOrder()`,
+ *                  `PGLittleEndianByteOrder()`)
+ * @return the number of words read.
+ */
+PG_EXPORT long PGReadWords16FromRingBuffer(PGRingBuffer *buff, uint16_t *dest, long maxWords, long byteOrder);
+
+/**
+ * Reads up to `maxWords` whole 32-bit words from the beginning of the ring buffer into `dest`, converting them
+ * from `byteOrder` to the host byte order on the way. See `PGReadWords16FromRingBuffer`.
+ *
+ * @param buff the buffer.
+ * @param dest the destination.
+ * @param maxWords the most words to read.
+ * @param byteOrder the byte order of the words in the buffer.
+ * @return the number of words read.
+ */
+PG_EXPORT long PGReadWords32FromRingBuffer(PGRingBuffer *buff, uint32_t *dest, long maxWords, long byteOrder);
+
+/**
+ * Reads up to `maxWords` whole 64-bit words from the beginning of the ring buffer into `dest`, converting them
+ * from `byteOrder` to the host byte order on the way. See `PGReadWords16FromRingBuffer`.
+ *
+ * @param buff the buffer.
+ * @param dest the destination.
+ * @param maxWords the most words to read.
+ * @param byteOrder the byte order of the words in the buffer.
+ * @return the number of words read.
+ */
+PG_EXPORT long PGReadWords64FromRingBuffer(PGRingBuffer *buff, uint64_t *dest, long maxWords, long byteOrder);
+
+/**
+ * Appends `count` 16-bit words to the end of the ring buffer - resizing the buffer if needed - converting them
+ * from the host byte order to `byteOrder` as they're copied in.
+ *
+ * @param buff the buffer.
+ * @param src the words, in host byte order.
+ * @param count the number of words.
+ * @param byteOrder the byte order to store the words in. (`PGBigEndianByteOrder()`, `PGLittleEndianByteOrder()`)
+ * @return `true` if successful or `false` if buffer size could not be expanded due to lack of memory or, for a
+ *         `PG_RINGBUFFER_OVERWRITE` buffer, if the words are more than its capacity. Nothing is appended or
+ *         dropped then.
+ */
+PG_EXPORT bool PGAppendWords16ToRingBuffer(PGRingBuffer *buff, const uint16_t *src, long count, long byteOrder);
+
+/**
+ * Appends `count` 32-bit words to the end of the ring buffer - resizing the buffer if needed - converting them
+ * from the host byte order to `byteOrder` as they're copied in.
+ *
+ * @param buff the buffer.
+ * @param src the words, in host byte order.
+ * @param count the number of words.
+ * @param byteOrder the byte order to store the words in.
+ * @return `true` if successful or `false` if buffer size could not be expanded due to lack of memory or, for a
+ *         `PG_RINGBUFFER_OVERWRITE` buffer, if the words are more than its capacity. Nothing is appended or
+ *         dropped then.
+ */
+PG_EXPORT bool PGAppendWords32ToRingBuffer(PGRingBuffer *buff, const uint32_t *src, long count, long byteOrder);
+
+/**
+ * Appends `count` 64-bit words to the end of the ring buffer - resizing the buffer if needed - converting them
+ * from the host byte order to `byteOrder` as they're copied in.
+ *
+ * @param buff the buffer.
+ * @param src the words, in host byte order.
+ * @param count the number of words.
+ * @param byteOrder the byte order to store the words in.
+ * @return `true` if successful or `false` if buffer size could not be expanded due to lack of memory or, for a
+ *         `PG_RINGBUFFER_OVERWRITE` buffer, if the words are more than its capacity. Nothing is appended or
+ *         dropped then.
+ */
+PG_EXPORT bool PGAppendWords64ToRingBuffer(PGRingBuffer *buff, const uint64_t *src, long count, long byteOrder);
+
 /**
  * Copies `length` bytes from `src` to `dst` as if first copied to an intermediate buffer.
  *
@@ -427,6 +953,275 @@ PG_EXPORT long PGMemCpy(void *dst, const void *src, long length);
  */
 PG_EXPORT long PGMemMove(void *dst, const void *src, long length);
 
+/*
+ * Inline fast paths.
+ *
+ * The single byte functions, and the count and remaining functions, are replaced by inline versions that work
+ * directly on the buffer's indexes. They only call into the library when the buffer has to grow (or, for get and
+ * set, when the offset has to be wrapped). Define PG_RINGBUFFER_NO_INLINE before including this header to always
+ * call the library instead. Either way the functions can still have their addresses taken.
+ */
+
+#if PG_RINGBUFFER_STATS
+    #define _PGRingBufferPeak(b) do { long _c = _PGRingBufferCountInline(b); if(_c > (b)->stats.peakCount) (b)->stats.peakCount = _c; } while(0)
+#else
+    #define _PGRingBufferPeak(b) do {} while(0)
+#endif
+
+/*
+ * Same as the `RBCC` macro in PGRingBuffer.c.
+ */
+PG_ALWAYS_INLINE long _PGRingBufferCountInline(const PGRingBuffer *buff) {
+    if(buff->mask) return ((buff->tail - buff->head) & buff->mask);
+    return ((buff->head <= buff->tail) ? (buff->tail - buff->head) : ((buff->size - buff->head) + buff->tail));
+}
+
+PG_ALWAYS_INLINE long _PGRingBufferRemainingInline(const PGRingBuffer *buff) {
+    return ((buff->size - 1) - _PGRingBufferCountInline(buff));
+}
+
+PG_ALWAYS_INLINE bool _PGAppendByteToRingBufferInline(PGRingBuffer *buff, uint8_t byte) {
+    long t = (buff->tail + 1);
+
+    if(buff->mask) t &= buff->mask;
+    else if(t == buff->size) t = 0;
+
+    // Full so it has to grow.
+    if(__builtin_expect((t == buff->head), 0)) return (PGAppendByteToRingBuffer)(buff, byte);
+
+    buff->buffer[buff->tail] = byte;
+    buff->tail = t;
+    _PGRingBufferPeak(buff);
+    return true;
+}
+
+PG_ALWAYS_INLINE bool _PGPrependByteToRingBufferInline(PGRingBuffer *buff, uint8_t byte) {
+    long h = ((buff->head ? buff->head : buff->size) - 1);
+
+    if(__builtin_expect((h == buff->tail), 0)) return (PGPrependByteToRingBuffer)(buff, byte);
+
+    buff->buffer[h] = byte;
+    buff->head = h;
+    _PGRingBufferPeak(buff);
+    return true;
+}
+
+PG_ALWAYS_INLINE uint8_t _PGGetByteFromRingBufferInline(PGRingBuffer *buff, long offset) {
+    if(__builtin_expect(((unsigned long)offset >= (unsigned long)_PGRingBufferCountInline(buff)), 0)) return (PGGetByteFromRingBuffer)(buff, offset);
+
+    long i = (buff->head + offset);
+    return buff->buffer[(buff->mask ? (i & buff->mask) : ((i >= buff->size) ? (i - buff->size) : i))];
+}
+
+PG_ALWAYS_INLINE void _PGSetByteOnRingBufferInline(PGRingBuffer *buff, long index, uint8_t byte) {
+    if(__builtin_expect(((unsigned long)index >= (unsigned long)_PGRingBufferCountInline(buff)), 0)) {
+        (PGSetByteOnRingBuffer)(buff, index, byte);
+    }
+    else {
+        long i = (buff->head + index);
+        buff->buffer[(buff->mask ? (i & buff->mask) : ((i >= buff->size) ? (i - buff->size) : i))] = byte;
+    }
+}
+
+/*
+ * Appends or reads `length` (2, 4, or 8) bytes with a single fixed size copy when they don't wrap and, for reads,
+ * when there's no shrink policy to check. Otherwise it's the normal append or read.
+ */
+PG_ALWAYS_INLINE bool _PGAppendWordInline(PGRingBuffer *buff, const void *src, long length) {
+    long t = buff->tail;
+
+    if(__builtin_expect(((_PGRingBufferRemainingInline(buff) >= length) && (((buff->fd >= 0) ? buff->size : (buff->size - t)) >= length)), 1)) {
+        memcpy((buff->buffer + t), src, (size_t)length);
+        t += length;
+        buff->tail = ((t >= buff->size) ? (t - buff->size) : t);
+        _PGRingBufferPeak(buff);
+        return true;
+    }
+
+    return PGAppendToRingBuffer(buff, src, length);
+}
+
+PG_ALWAYS_INLINE bool _PGReadWordInline(PGRingBuffer *buff, void *dest, long length) {
+    long h = buff->head;
+
+    if(__builtin_expect(((_PGRingBufferCountInline(buff) >= length) && (((buff->fd >= 0) ? buff->size : (buff->size - h)) >= length) && (buff->policy.shrinkAfter == 0)), 1)) {
+        memcpy(dest, (buff->buffer + h), (size_t)length);
+        h += length;
+        buff->head = ((h >= buff->size) ? (h - buff->size) : h);
+        return true;
+    }
+
+    if(_PGRingBufferCountInline(buff) < length) return false;
+    return (PGReadFromRingBuffer(buff, dest, length) == length);
+}
+
+/**
+ * Appends a 16-bit word to the end of the ring buffer, as is, in host byte order - resizing the buffer if needed.
+ *
+ * @param buff the buffer.
+ * @param word the word.
+ * @return `true` if successful or `false` if buffer size could not be expanded due to lack of memory.
+ */
+PG_ALWAYS_INLINE bool PGAppendWord16ToRingBuffer(PGRingBuffer *buff, uint16_t word) {
+    return _PGAppendWordInline(buff, &word, 2);
+}
+
+/**
+ * Appends a 32-bit word to the end of the ring buffer, as is, in host byte order - resizing the buffer if needed.
+ *
+ * @param buff the buffer.
+ * @param word the word.
+ * @return `true` if successful or `false` if buffer size could not be expanded due to lack of memory.
+ */
+PG_ALWAYS_INLINE bool PGAppendWord32ToRingBuffer(PGRingBuffer *buff, uint32_t word) {
+    return _PGAppendWordInline(buff, &word, 4);
+}
+
+/**
+ * Appends a 64-bit word to the end of the ring buffer, as is, in host byte order - resizing the buffer if needed.
+ *
+ * @param buff the buffer.
+ * @param word the word.
+ * @return `true` if successful or `false` if buffer size could not be expanded due to lack of memory.
+ */
+PG_ALWAYS_INLINE bool PGAppendWord64ToRingBuffer(PGRingBuffer *buff, uint64_t word) {
+    return _PGAppendWordInline(buff, &word, 8);
+}
+
+/**
+ * Reads a 16-bit word, as is, from the beginning of the ring buffer.
+ *
+ * @param buff the buffer.
+ * @param word receives the word.
+ * @return `true` if successful or `false` if there are fewer than two bytes in the buffer, in which case nothing
+ *         is read.
+ */
+PG_ALWAYS_INLINE bool PGReadWord16FromRingBuffer(PGRingBuffer *buff, uint16_t *word) {
+    return _PGReadWordInline(buff, word, 2);
+}
+
+/**
+ * Reads a 32-bit word, as is, from the beginning of the ring buffer.
+ *
+ * @param buff the buffer.
+ * @param word receives the word.
+ * @return `true` if successful or `false` if there are fewer than four bytes in the buffer, in which case nothing
+ *         is read.
+ */
+PG_ALWAYS_INLINE bool PGReadWord32FromRingBuffer(PGRingBuffer *buff, uint32_t *word) {
+    return _PGReadWordInline(buff, word, 4);
+}
+
+/**
+ * Reads a 64-bit word, as is, from the beginning of the ring buffer.
+ *
+ * @param buff the buffer.
+ * @param word receives the word.
+ * @return `true` if successful or `false` if there are fewer than eight bytes in the buffer, in which case nothing
+ *         is read.
+ */
+PG_ALWAYS_INLINE bool PGReadWord64FromRingBuffer(PGRingBuffer *buff, uint64_t *word) {
+    return _PGReadWordInline(buff, word, 8);
+}
+
+/*
+ * Typed integers in a given byte order. `byteOrder` is compared with the value `PGHostByteOrder()` returns so
+ * when it's a constant the check, and the swap when it matches, compile away.
+ */
+
+/**
+ * Appends a 16-bit unsigned integer to the end of the ring buffer in the given byte order - resizing the buffer
+ * if needed.
+ *
+ * @param buff the buffer.
+ * @param value the value.
+ * @param byteOrder the byte order. (`PGBigEndianByteOrder()`, `PGLittleEndianByteOrder()`, `PGHostByteOrder()`)
+ * @return `true` if successful or `false` if buffer size could not be expanded due to lack of memory.
+ */
+PG_ALWAYS_INLINE bool PGAppendUInt16ToRingBuffer(PGRingBuffer *buff, uint16_t value, long byteOrder) {
+    return PGAppendWord16ToRingBuffer(buff, ((byteOrder == __BYTE_ORDER__) ? value : __builtin_bswap16(value)));
+}
+
+/**
+ * Appends a 32-bit unsigned integer to the end of the ring buffer in the given byte order - resizing the buffer
+ * if needed.
+ *
+ * @param buff the buffer.
+ * @param value the value.
+ * @param byteOrder the byte order.
+ * @return `true` if successful or `false` if buffer size could not be expanded due to lack of memory.
+ */
+PG_ALWAYS_INLINE bool PGAppendUInt32ToRingBuffer(PGRingBuffer *buff, uint32_t value, long byteOrder) {
+    return PGAppendWord32ToRingBuffer(buff, ((byteOrder == __BYTE_ORDER__) ? value : __builtin_bswap32(value)));
+}
+
+/**
+ * Appends a 64-bit unsigned integer to the end of the ring buffer in the given byte order - resizing the buffer
+ * if needed.
+ *
+ * @param buff the buffer.
+ * @param value the value.
+ * @param byteOrder the byte order.
+ * @return `true` if successful or `false` if buffer size could not be expanded due to lack of memory.
+ */
+PG_ALWAYS_INLINE bool PGAppendUInt64ToRingBuffer(PGRingBuffer *buff, uint64_t value, long byteOrder) {
+    return PGAppendWord64ToRingBuffer(buff, ((byteOrder == __BYTE_ORDER__) ? value : __builtin_bswap64(value)));
+}
+
+/**
+ * Reads a 16-bit unsigned integer, stored in the given byte order, from the beginning of the ring buffer.
+ *
+ * @param buff the buffer.
+ * @param value receives the value in host byte order.
+ * @param byteOrder the byte order it's stored in.
+ * @return `true` if successful or `false` if there are fewer than two bytes in the buffer, in which case nothing
+ *         is read.
+ */
+PG_ALWAYS_INLINE bool PGReadUInt16FromRingBuffer(PGRingBuffer *buff, uint16_t *value, long byteOrder) {
+    if(!PGReadWord16FromRingBuffer(buff, value)) return false;
+    if(byteOrder != __BYTE_ORDER__) *value = __builtin_bswap16(*value);
+    return true;
+}
+
+/**
+ * Reads a 32-bit unsigned integer, stored in the given byte order, from the beginning of the ring buffer.
+ *
+ * @param buff the buffer.
+ * @param value receives the value in host byte order.
+ * @param byteOrder the byte order it's stored in.
+ * @return `true` if successful or `false` if there are fewer than four bytes in the buffer, in which case nothing
+ *         is read.
+ */
+PG_ALWAYS_INLINE bool PGReadUInt32FromRingBuffer(PGRingBuffer *buff, uint32_t *value, long byteOrder) {
+    if(!PGReadWord32FromRingBuffer(buff, value)) return false;
+    if(byteOrder != __BYTE_ORDER__) *value = __builtin_bswap32(*value);
+    return true;
+}
+
+/**
+ * Reads a 64-bit unsigned integer, stored in the given byte order, from the beginning of the ring buffer.
+ *
+ * @param buff the buffer.
+ * @param value receives the value in host byte order.
+ * @param byteOrder the byte order it's stored in.
+ * @return `true` if successful or `false` if there are fewer than eight bytes in the buffer, in which case nothing
+ *         is read.
+ */
+PG_ALWAYS_INLINE bool PGReadUInt64FromRingBuffer(PGRingBuffer *buff, uint64_t *value, long byteOrder) {
+    if(!PGReadWord64FromRingBuffer(buff, value)) return false;
+    if(byteOrder != __BYTE_ORDER__) *value = __builtin_bswap64(*value);
+    return true;
+}
+
+#ifndef PG_RINGBUFFER_NO_INLINE
+    #define PGRingBufferCount(b)                _PGRingBufferCountInline(b)
+    #define PGRingBufferRemaining(b)            _PGRingBufferRemainingInline(b)
+    #define PGAppendByteToRingBuffer(b, x)      _PGAppendByteToRingBufferInline((b), (x))
+    #define PGPrependByteToRingBuffer(b, x)     _PGPrependByteToRingBufferInline((b), (x))
+    #define PGGetByteFromRingBuffer(b, o)       _PGGetByteFromRingBufferInline((b), (o))
+    #define PGSetByteOnRingBuffer(b, i, x)      _PGSetByteOnRingBufferInline((b), (i), (x))
+#endif
+
 __END_DECLS
 
 #endif /* PGRingBuffer_h */
@@ -0,0 +1,662 @@
+//
+//  PGRingBuffer.hpp
+//  PGRingBuffer
+//
+//  Created by Galen Rhodes on 10/16/26.
+//  Copyright © 2020 Project Galen. All rights reserved.
+//
+//  A header-only C++17 counterpart to PGRingBuffer for typed elements. Everything is a template so every
+//  operation can be inlined into the caller, and with a compile time capacity the index wrapping is a constant
+//  mask.
+//
+
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "OCUnusedGlobalDeclarationInspection"
+#ifndef PGRingBuffer_hpp
+#define PGRingBuffer_hpp
+// Tools that gather up every header in the include directory (SwiftPM, Xcode module maps) may read this as C.
+#if defined(__cplusplus)
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace pg {
+
+/**
+ * Pass as the capacity to get a ring buffer whose storage is allocated on the heap and can grow.
+ */
+inline constexpr std::size_t DynamicCapacity = 0;
+
+/**
+ * Rounds `v` up to the next power of two (minimum eight), just like `PG_RINGBUFFER_POW2` does. Returns zero if
+ * `v` is more than the largest power of two a `std::size_t` can hold.
+ */
+constexpr std::size_t nextPow2(std::size_t v) noexcept {
+    std::size_t p = 8;
+    if(v > ((SIZE_MAX / 2) + 1)) return 0;
+    while(p < v) p <<= 1;
+    return p;
+}
+
+// ---------------------------------------------------------------------------------------------------------------
+// Growth policies. `next(size, needed)` returns the new size for storage of `size` elements that has to hold
+// `needed` elements, or zero if it may not grow. The ring buffer rounds the result up to a power of two.
+// ---------------------------------------------------------------------------------------------------------------
+
+/**
+ * Multiplies the size by `Num / Den` until there is enough room. The default doubles, like `PGRingBuffer`.
+ */
+template <unsigned Num = 2, unsigned Den = 1>
+struct GrowByFactor {
+    static_assert(Num > Den, "The growth factor has to be more than one.");
+
+    static constexpr std::size_t next(std::size_t size, std::size_t needed) noexcept {
+        // Jump straight to what's needed rather than let the multiplication overflow.
+        while(size < needed) size = ((size > (SIZE_MAX / Num)) ? needed : std::max((size + 1), ((size * Num) / Den)));
+        return size;
+    }
+};
+
+/**
+ * Never grows. Appends that don't fit fail instead.
+ */
+struct NoGrowth {
+    static constexpr std::size_t next(std::size_t, std::size_t) noexcept { return 0; }
+};
+
+// ---------------------------------------------------------------------------------------------------------------
+// Concurrency policies.
+// ---------------------------------------------------------------------------------------------------------------
+
+namespace detail {
+    struct NoLock {
+        void lock() const noexcept {}
+
+        void unlock() const noexcept {}
+    };
+}
+
+/**
+ * No synchronization at all. The ring buffer may only be used by one thread at a time.
+ */
+struct SingleThreaded {
+    using index_type = std::size_t;
+    using lock_type  = detail::NoLock;
+
+    static constexpr bool        spsc      = false;
+    static constexpr std::size_t alignment = alignof(index_type);
+
+    static std::size_t relaxed(const index_type &i) noexcept { return i; }
+
+    static std::size_t acquire(const index_type &i) noexcept { return i; }
+
+    static void release(index_type &i, std::size_t v) noexcept { i = v; }
+};
+
+/**
+ * Every operation holds a `std::mutex` so any number of threads can share the ring buffer.
+ */
+struct Locked : SingleThreaded {
+    using lock_type = std::mutex;
+};
+
+/**
+ * Lock-free single-producer/single-consumer, like `PGSPSCRingBuffer`. The append functions may only be called
+ * from the producer thread and the read, peek, and consume functions from the consumer thread. Only allowed with
+ * a fixed capacity since the storage can't be moved while the other thread is using it. Functions that touch the
+ * wrong end (prepend, readLast, clear, defrag) will not compile.
+ */
+struct SPSC {
+    using index_type = std::atomic<std::size_t>;
+    using lock_type  = detail::NoLock;
+
+    static constexpr bool        spsc      = true;
+    static constexpr std::size_t alignment = 64;
+
+    static std::size_t relaxed(const index_type &i) noexcept { return i.load(std::memory_order_relaxed); }
+
+    static std::size_t acquire(const index_type &i) noexcept { return i.load(std::memory_order_acquire); }
+
+    static void release(index_type &i, std::size_t v) noexcept { i.store(v, std::memory_order_release); }
+};
+
+/**
+ * A contiguous run of elements inside a ring buffer's storage. The C++ counterpart of `PGRingBufferSpan`.
+ */
+template <typename T>
+struct Span {
+    T           *data;
+    std::size_t size;
+
+    T *begin() const noexcept { return data; }
+
+    T *end() const noexcept { return (data + size); }
+
+    bool empty() const noexcept { return (size == 0); }
+
+    T &operator[](std::size_t i) const noexcept { return data[i]; }
+};
+
+namespace detail {
+    /*
+     * Fixed capacity storage lives inside the ring buffer object itself and its mask is a compile time constant.
+     */
+    template <typename T, std::size_t N>
+    struct Storage {
+        static constexpr std::size_t count = nextPow2(N);
+        static_assert(count != 0, "The capacity is too big to round up to a power of two.");
+
+        alignas(T) unsigned char bytes[sizeof(T) * count];
+
+        T *data() noexcept { return std::launder(reinterpret_cast<T *>(bytes)); }
+
+        const T *data() const noexcept { return std::launder(reinterpret_cast<const T *>(bytes)); }
+
+        static constexpr std::size_t size() noexcept { return count; }
+
+        static constexpr std::size_t mask() noexcept { return (count - 1); }
+    };
+
+    template <typename T>
+    struct Storage<T, DynamicCapacity> {
+        T           *ptr  = nullptr;
+        std::size_t count = 0;
+
+        T *data() noexcept { return ptr; }
+
+        const T *data() const noexcept { return ptr; }
+
+        std::size_t size() const noexcept { return count; }
+
+        std::size_t mask() const noexcept { return (count - 1); }
+    };
+}
+
+/**
+ * A ring buffer of `T`.
+ *
+ * The head and tail are free running counters and the storage is always a power of two in size, so every index is
+ * wrapped with a mask and all of the storage can be used (unlike `PGRingBuffer`, which keeps one byte free).
+ * Elements are constructed in place when added and destroyed when removed so types that can only be moved work.
+ *
+ * @tparam T the element type.
+ * @tparam Capacity the number of elements, rounded up to a power of two, or `DynamicCapacity` for heap storage
+ *         that grows under the `Growth` policy.
+ * @tparam Growth how dynamic storage grows. (`GrowByFactor<...>`, `NoGrowth`) Ignored for a fixed capacity.
+ * @tparam Concurrency how the ring buffer may be shared. (`SingleThreaded`, `Locked`, `SPSC`)
+ */
+template <typename T, std::size_t Capacity = DynamicCapacity, typename Growth = GrowByFactor<>, typename Concurrency = SingleThreaded>
+class RingBuffer {
+    static_assert(!(Concurrency::spsc && (Capacity == DynamicCapacity)), "SPSC ring buffers need a fixed capacity.");
+
+    template <bool Const>
+    class Iter;
+
+public:
+    using value_type      = T;
+    using size_type       = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference       = T &;
+    using const_reference = const T &;
+    using iterator        = Iter<false>;
+    using const_iterator  = Iter<true>;
+
+    static constexpr bool isDynamic = (Capacity == DynamicCapacity);
+
+    /**
+     * Creates a ring buffer. For dynamic storage `initialSize` is rounded up to a power of two (minimum eight),
+     * and `std::length_error` is thrown if there is no such power of two. For a fixed capacity it is ignored.
+     */
+    explicit RingBuffer(size_type initialSize = 8) {
+        if constexpr(isDynamic) {
+            if((_st.count = _initSize = nextPow2(initialSize)) == 0) throw std::length_error("pg::RingBuffer");
+            _st.ptr = std::allocator<T>().allocate(_st.count);
+        }
+        else {
+            (void)initialSize;
+        }
+    }
+
+    RingBuffer(const RingBuffer &) = delete;
+
+    RingBuffer &operator=(const RingBuffer &) = delete;
+
+    ~RingBuffer() {
+        destroy(Concurrency::relaxed(_head), Concurrency::relaxed(_tail));
+        if constexpr(isDynamic) std::allocator<T>().deallocate(_st.ptr, _st.count);
+    }
+
+    /**
+     * The number of elements the ring buffer can hold without growing.
+     */
+    size_type capacity() const noexcept { return _st.size(); }
+
+    /**
+     * The number of elements in the ring buffer. From a thread other than the producer or consumer of an SPSC
+     * ring buffer this is only a snapshot.
+     */
+    size_type count() const noexcept {
+        Guard g(_lock);
+        return (Concurrency::acquire(_tail) - Concurrency::acquire(_head));
+    }
+
+    size_type size() const noexcept { return count(); }
+
+    bool empty() const noexcept { return (count() == 0); }
+
+    /**
+     * The number of elements that can be added without growing.
+     */
+    size_type remaining() const noexcept { return (capacity() - count()); }
+
+    /**
+     * Makes sure that `needed` more elements can be added. See `PGEnsureCapacity`.
+     *
+     * @return `true` if there is room or the storage grew, `false` if it may not grow that far.
+     */
+    bool ensureCapacity(size_type needed) {
+        Guard g(_lock);
+        return ensure(needed);
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    // Adding elements.
+    // -----------------------------------------------------------------------------------------------------------
+
+    /**
+     * Constructs an element in place at the end of the ring buffer.
+     *
+     * @return `true` if successful or `false` if the ring buffer is full and may not grow.
+     */
+    template <typename... Args>
+    bool emplace(Args &&... args) {
+        Guard g(_lock);
+        if(!ensure(1)) return false;
+
+        size_type t = Concurrency::relaxed(_tail);
+        ::new(static_cast<void *>(slot(t))) T(std::forward<Args>(args)...);
+        Concurrency::release(_tail, (t + 1));
+        return true;
+    }
+
+    bool append(const T &v) { return emplace(v); }
+
+    bool append(T &&v) { return emplace(std::move(v)); }
+
+    /**
+     * Copies `n` elements to the end of the ring buffer. Either all of them are added or none of them are.
+     */
+    bool append(const T *src, size_type n) {
+        Guard g(_lock);
+        if(!ensure(n)) return false;
+
+        size_type t = Concurrency::relaxed(_tail);
+        size_type l = std::min(n, contig(t));
+
+        std::uninitialized_copy_n(src, l, slot(t));
+        std::uninitialized_copy_n((src + l), (n - l), _st.data());
+        Concurrency::release(_tail, (t + n));
+        return true;
+    }
+
+    /**
+     * Constructs an element in place at the beginning of the ring buffer.
+     */
+    template <typename... Args>
+    bool emplaceFront(Args &&... args) {
+        static_assert(!Concurrency::spsc, "The producer of an SPSC ring buffer can only append.");
+        Guard g(_lock);
+        if(!ensure(1)) return false;
+
+        ::new(static_cast<void *>(slot(_head - 1))) T(std::forward<Args>(args)...);
+        --_head;
+        return true;
+    }
+
+    bool prepend(const T &v) { return emplaceFront(v); }
+
+    bool prepend(T &&v) { return emplaceFront(std::move(v)); }
+
+    /**
+     * Reserves room for `n` elements at the end of the ring buffer and returns it as two spans, like
+     * `PGRingBufferReserve`. The room is not initialized so this is only for trivially copyable types.
+     */
+    std::array<Span<T>, 2> reserve(size_type n) {
+        static_assert(std::is_trivially_copyable<T>::value, "Reserved room is uninitialized.");
+        Guard g(_lock);
+        if(!ensure(n)) n = (capacity() - (Concurrency::relaxed(_tail) - Concurrency::acquire(_head)));
+
+        size_type t = Concurrency::relaxed(_tail);
+        size_type l = std::min(n, contig(t));
+        return { Span<T>{ slot(t), l }, Span<T>{ _st.data(), (n - l) }};
+    }
+
+    /**
+     * Adds `n` elements previously written into the spans returned by `reserve`.
+     */
+    void commit(size_type n) noexcept {
+        Guard     g(_lock);
+        size_type t = Concurrency::relaxed(_tail);
+        Concurrency::release(_tail, (t + std::min(n, (capacity() - (t - Concurrency::acquire(_head))))));
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    // Removing elements.
+    // -----------------------------------------------------------------------------------------------------------
+
+    /**
+     * Moves the first element into `dest` and removes it.
+     *
+     * @return `true` if there was an element to read.
+     */
+    bool read(T &dest) {
+        Guard     g(_lock);
+        size_type h = Concurrency::relaxed(_head);
+
+        if(h == Concurrency::acquire(_tail)) return false;
+        T *p = slot(h);
+        dest = std::move(*p);
+        p->~T();
+        Concurrency::release(_head, (h + 1));
+        return true;
+    }
+
+    /**
+     * Moves up to `maxCount` elements into `dest` and removes them.
+     *
+     * @return the number of elements read.
+     */
+    size_type read(T *dest, size_type maxCount) {
+        Guard     g(_lock);
+        size_type h = Concurrency::relaxed(_head);
+        size_type n = std::min(maxCount, (Concurrency::acquire(_tail) - h));
+        size_type l = std::min(n, contig(h));
+
+        moveOut(slot(h), l, dest);
+        moveOut(_st.data(), (n - l), (dest + l));
+        Concurrency::release(_head, (h + n));
+        return n;
+    }
+
+    /**
+     * Moves the last element into `dest` and removes it.
+     */
+    bool readLast(T &dest) {
+        static_assert(!Concurrency::spsc, "The consumer of an SPSC ring buffer can only read from the front.");
+        Guard g(_lock);
+
+        if(_head == _tail) return false;
+        T *p = slot(_tail - 1);
+        dest = std::move(*p);
+        p->~T();
+        --_tail;
+        return true;
+    }
+
+    /**
+     * Copies up to `maxCount` elements into `dest` without removing them.
+     */
+    size_type peek(T *dest, size_type maxCount) const {
+        Guard     g(_lock);
+        size_type h = Concurrency::relaxed(_head);
+        size_type n = std::min(maxCount, (Concurrency::acquire(_tail) - h));
+        size_type l = std::min(n, contig(h));
+
+        std::copy_n(slot(h), l, dest);
+        std::copy_n(_st.data(), (n - l), (dest + l));
+        return n;
+    }
+
+    /**
+     * Removes up to `n` elements from the front without reading them.
+     *
+     * @return the number of elements removed.
+     */
+    size_type consume(size_type n) noexcept {
+        Guard     g(_lock);
+        size_type h = Concurrency::relaxed(_head);
+
+        n = std::min(n, (Concurrency::acquire(_tail) - h));
+        destroy(h, (h + n));
+        Concurrency::release(_head, (h + n));
+        return n;
+    }
+
+    /**
+     * Removes all of the elements. If `keepCapacity` is `false` then dynamic storage goes back to its initial
+     * size.
+     */
+    void clear(bool keepCapacity = true) {
+        static_assert(!Concurrency::spsc, "An SPSC ring buffer can only be emptied by the consumer with consume().");
+        Guard g(_lock);
+
+        destroy(_head, _tail);
+        _head = _tail = 0;
+        if constexpr(isDynamic) {
+            if(!keepCapacity && (_st.count != _initSize)) {
+                std::allocator<T>().deallocate(_st.ptr, _st.count);
+                _st.count = _initSize;
+                _st.ptr   = std::allocator<T>().allocate(_st.count);
+            }
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------
+    // In place access.
+    // -----------------------------------------------------------------------------------------------------------
+
+    /**
+     * The element `i` places from the front. Unlike `PGGetByteFromRingBuffer` the offset is not wrapped; it must
+     * be less than `count()`. No locking is done.
+     */
+    T &operator[](size_type i) noexcept { return *slot(Concurrency::relaxed(_head) + i); }
+
+    const T &operator[](size_type i) const noexcept { return *slot(Concurrency::relaxed(_head) + i); }
+
+    T &at(size_type i) {
+        if(i >= count()) throw std::out_of_range("pg::RingBuffer::at");
+        return (*this)[i];
+    }
+
+    T &front() noexcept { return (*this)[0]; }
+
+    T &back() noexcept {
+        static_assert(!Concurrency::spsc, "The back of an SPSC ring buffer belongs to the producer.");
+        return *slot(_tail - 1);
+    }
+
+    /**
+     * The elements as two spans, like `PGPeekSpansFromRingBuffer`. The second span is the part that wraps around
+     * to the beginning of the storage. Only valid until the ring buffer is next modified.
+     */
+    std::array<Span<T>, 2> spans() noexcept {
+        size_type h = Concurrency::relaxed(_head);
+        size_type n = (Concurrency::acquire(_tail) - h);
+        size_type l = std::min(n, contig(h));
+        return { Span<T>{ slot(h), l }, Span<T>{ _st.data(), (n - l) }};
+    }
+
+    /**
+     * Moves the elements so they are contiguous and start at the beginning of the storage, like
+     * `PGDefragRingBuffer`. The elements are moved as bytes, in place, so this is only for trivially copyable
+     * types.
+     *
+     * @return a span over all of the elements.
+     */
+    Span<T> defrag() {
+        static_assert(std::is_trivially_copyable<T>::value, "Elements are moved as bytes.");
+        static_assert(!Concurrency::spsc, "An SPSC ring buffer can't be moved while it's in use.");
+        Guard         g(_lock);
+        size_type     n  = (_tail - _head);
+        size_type     h  = (_head & _st.mask());
+        size_type     hs = std::min(n, contig(h));
+        unsigned char *b = reinterpret_cast<unsigned char *>(_st.data());
+
+        if(hs < n) {
+            // Close the gap and then rotate the two segments into place.
+            size_type t = (n - hs);
+            std::memmove((b + (t * sizeof(T))), (b + (h * sizeof(T))), (hs * sizeof(T)));
+            std::rotate(b, (b + (t * sizeof(T))), (b + (n * sizeof(T))));
+        }
+        else if(h) {
+            std::memmove(b, (b + (h * sizeof(T))), (n * sizeof(T)));
+        }
+
+        _head = 0;
+        _tail = n;
+        return Span<T>{ _st.data(), n };
+    }
+
+    iterator begin() noexcept { return iterator(this, 0); }
+
+    iterator end() noexcept { return iterator(this, (Concurrency::acquire(_tail) - Concurrency::relaxed(_head))); }
+
+    const_iterator begin() const noexcept { return const_iterator(this, 0); }
+
+    const_iterator end() const noexcept { return const_iterator(this, (Concurrency::acquire(_tail) - Concurrency::relaxed(_head))); }
+
+private:
+    using Guard = std::lock_guard<typename Concurrency::lock_type>;
+
+    detail::Storage<T, Capacity>                               _st;
+    size_type                                                  _initSize = _st.size();
+    alignas(Concurrency::alignment) typename Concurrency::index_type _head{ 0 };
+    alignas(Concurrency::alignment) typename Concurrency::index_type _tail{ 0 };
+    mutable typename Concurrency::lock_type                    _lock;
+
+    T *slot(size_type i) noexcept { return (_st.data() + (i & _st.mask())); }
+
+    const T *slot(size_type i) const noexcept { return (_st.data() + (i & _st.mask())); }
+
+    /*
+     * The number of slots from `i` to the end of the storage.
+     */
+    size_type contig(size_type i) const noexcept { return (capacity() - (i & _st.mask())); }
+
+    static void moveOut(T *src, size_type n, T *dest) {
+        if constexpr(std::is_trivially_copyable<T>::value) {
+            if(n) std::memcpy(static_cast<void *>(dest), src, (n * sizeof(T)));
+        }
+        else {
+            for(size_type i = 0; i < n; ++i) {
+                dest[i] = std::move(src[i]);
+                src[i].~T();
+            }
+        }
+    }
+
+    void destroy(size_type from, size_type to) noexcept {
+        if constexpr(!std::is_trivially_destructible<T>::value) for(; from != to; ++from) slot(from)->~T();
+    }
+
+    /*
+     * Called with the lock held. The SPSC producer only ever sees less room than there really is so this is safe
+     * without a lock.
+     */
+    bool ensure(size_type needed) {
+        size_type cc = (Concurrency::relaxed(_tail) - Concurrency::acquire(_head));
+
+        if((capacity() - cc) >= needed) return true;
+        if constexpr(isDynamic) {
+            size_type ns = Growth::next(_st.count, (cc + needed));
+            if((ns < (cc + needed)) || ((ns = nextPow2(ns)) == 0)) return false;
+
+            T         *nb = std::allocator<T>().allocate(ns);
+            size_type h   = _head;
+
+            for(size_type i = 0; i < cc; ++i) {
+                T *p = slot(h + i);
+                ::new(static_cast<void *>(nb + i)) T(std::move_if_noexcept(*p));
+                p->~T();
+            }
+
+            std::allocator<T>().deallocate(_st.ptr, _st.count);
+            _st.ptr   = nb;
+            _st.count = ns;
+            _head     = 0;
+            _tail     = cc;
+            return true;
+        }
+        else {
+            return false;
+        }
+    }
+
+    /*
+     * A random access iterator over the elements from the front to the back.
+     */
+    template <bool Const>
+    class Iter {
+        using Ring = std::conditional_t<Const, const RingBuffer, RingBuffer>;
+
+        Ring      *_r;
+        size_type _i;
+
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type        = T;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = std::conditional_t<Const, const T *, T *>;
+        using reference         = std::conditional_t<Const, const T &, T &>;
+
+        Iter() noexcept: _r(nullptr), _i(0) {}
+
+        Iter(Ring *r, size_type i) noexcept: _r(r), _i(i) {}
+
+        reference operator*() const noexcept { return (*_r)[_i]; }
+
+        pointer operator->() const noexcept { return &(*_r)[_i]; }
+
+        reference operator[](difference_type n) const noexcept { return (*_r)[_i + n]; }
+
+        Iter &operator++() noexcept { ++_i; return *this; }
+
+        Iter operator++(int) noexcept { Iter t = *this; ++_i; return t; }
+
+        Iter &operator--() noexcept { --_i; return *this; }
+
+        Iter operator--(int) noexcept { Iter t = *this; --_i; return t; }
+
+        Iter &operator+=(difference_type n) noexcept { _i += n; return *this; }
+
+        Iter &operator-=(difference_type n) noexcept { _i -= n; return *this; }
+
+        Iter operator+(difference_type n) const noexcept { return Iter(_r, (_i + n)); }
+
+        friend Iter operator+(difference_type n, const Iter &it) noexcept { return (it + n); }
+
+        Iter operator-(difference_type n) const noexcept { return Iter(_r, (_i - n)); }
+
+        difference_type operator-(const Iter &o) const noexcept { return (difference_type)(_i - o._i); }
+
+        bool operator==(const Iter &o) const noexcept { return (_i == o._i); }
+
+        bool operator!=(const Iter &o) const noexcept { return (_i != o._i); }
+
+        bool operator<(const Iter &o) const noexcept { return (_i < o._i); }
+
+        bool operator>(const Iter &o) const noexcept { return (_i > o._i); }
+
+        bool operator<=(const Iter &o) const noexcept { return (_i <= o._i); }
+
+        bool operator>=(const Iter &o) const noexcept { return (_i >= o._i); }
+    };
+};
+
+}
+
+#endif /* __cplusplus */
+#endif /* PGRingBuffer_hpp */
+
+#pragma clang diagnostic pop
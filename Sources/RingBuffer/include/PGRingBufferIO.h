@@ -0,0 +1,54 @@
+//
+//  PGRingBufferIO.h
+//  PGRingBuffer
+//
+//  Created by Galen Rhodes on 10/16/26.
+//  Copyright © 2020 Project Galen. All rights reserved.
+//
+
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "OCUnusedGlobalDeclarationInspection"
+#ifndef PGRingBufferIO_h
+#define PGRingBufferIO_h
+
+#include "PGRingBuffer.h"
+
+__BEGIN_DECLS
+
+/**
+ * Reads up to `maxLength` bytes from the file descriptor directly into the ring buffer - resizing the buffer if
+ * needed. The free space, including the part that wraps around to the beginning of the storage, is filled with a
+ * single `readv` call so there is no intermediate copy. Calls interrupted by a signal are retried. A
+ * `PG_RINGBUFFER_OVERWRITE` buffer reads at most its capacity and drops only as many of its oldest bytes as the
+ * bytes actually read need, so nothing is dropped if the read fails.
+ *
+ * @param buff the ring buffer.
+ * @param fd the file descriptor to read from.
+ * @param maxLength the maximum number of bytes to read.
+ * @return the number of bytes read, zero at end of file (or if `maxLength` is less than one), or -1 if there
+ *         was an error, in which case `errno` is set. If the file descriptor is non-blocking and has no data then
+ *         -1 is returned with `errno` set to `EAGAIN` (or `EWOULDBLOCK`) and the buffer is unchanged. If the
+ *         buffer could not be expanded due to lack of memory then -1 is returned with `errno` set to `ENOMEM`.
+ */
+PG_EXPORT long PGRingBufferReadFromFd(PGRingBuffer *buff, int fd, long maxLength);
+
+/**
+ * Writes up to `maxLength` bytes from the ring buffer directly to the file descriptor and removes the bytes that
+ * were written from the buffer. All of the bytes, including the part that wraps around to the beginning of the
+ * storage, are written with a single `writev` call so there is no intermediate copy. Calls interrupted by a
+ * signal are retried.
+ *
+ * @param buff the ring buffer.
+ * @param fd the file descriptor to write to.
+ * @param maxLength the maximum number of bytes to write. If less than one then all of the bytes in the buffer.
+ * @return the number of bytes written, which may be less than requested, or -1 if there was an error, in which
+ *         case `errno` is set. If the file descriptor is non-blocking and cannot accept any data then -1 is
+ *         returned with `errno` set to `EAGAIN` (or `EWOULDBLOCK`) and the buffer is unchanged.
+ */
+PG_EXPORT long PGRingBufferWriteToFd(PGRingBuffer *buff, int fd, long maxLength);
+
+__END_DECLS
+
+#endif /* PGRingBufferIO_h */
+
+#pragma clang diagnostic pop
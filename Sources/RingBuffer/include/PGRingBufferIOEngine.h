@@ -0,0 +1,156 @@
+//
+//  PGRingBufferIOEngine.h
+//  PGRingBuffer
+//
+//  Created by Galen Rhodes on 10/16/26.
+//  Copyright © 2020 Project Galen. All rights reserved.
+//
+
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "OCUnusedGlobalDeclarationInspection"
+#ifndef PGRingBufferIOEngine_h
+#define PGRingBufferIOEngine_h
+
+#include "PGRingBufferIO.h"
+
+__BEGIN_DECLS
+
+/**
+ * Drives batched, asynchronous reads into and writes out of many ring buffers through a single io_uring
+ * instance. Where io_uring is not available (not Linux, too old a kernel, or blocked by a sandbox) the engine
+ * falls back to performing each operation immediately with `PGRingBufferReadFromFd` or `PGRingBufferWriteToFd`
+ * and reporting it at the next call to `PGRingBufferIOEngineComplete`.
+ *
+ * A read fills the free space after the tail and moves the tail when it completes. A write sends the bytes from
+ * the head and moves the head when it completes. So while a read is in flight nothing may touch the tail side of
+ * its ring buffer: no appends, reserves, commits, or anything else that adds bytes. While a write is in flight
+ * nothing may touch the head side: no reads, consumes, or anything else that removes bytes. While either is in
+ * flight the ring buffer must not be resized, defragmented, cleared, or discarded either. Only one read and one
+ * write may be in flight for each ring buffer. Because they work on different sides one of each can be in flight
+ * at the same time. The engine itself is not thread safe.
+ */
+typedef struct _st_pg_ringbuffer_io_engine_ PGRingBufferIOEngine;
+
+/**
+ * Called by `PGRingBufferIOEngineComplete` for each finished operation after the ring buffer's tail (for a read)
+ * or head (for a write) has been advanced by the number of bytes transferred.
+ *
+ * @param buff the ring buffer.
+ * @param fd the file descriptor.
+ * @param isWrite `true` if the operation was a write, `false` if it was a read.
+ * @param result the number of bytes transferred, zero at end of file, or a negated `errno` value.
+ * @param context the context given when the operation was submitted.
+ */
+typedef void (*PGRingBufferIOCallback)(PGRingBuffer *buff, int fd, bool isWrite, long result, void *context);
+
+/**
+ * Creates a new I/O engine.
+ *
+ * @param entries the maximum number of operations that can be queued at once. Rounded up to a power of two.
+ * @param useFallback if `true` then io_uring is not used even if it is available.
+ * @return the new engine or `NULL` if `entries` is less than one (`errno` is set to `EINVAL`) or there was not
+ *         enough memory.
+ */
+PG_EXPORT PGRingBufferIOEngine *PGCreateRingBufferIOEngine(int entries, bool useFallback);
+
+/**
+ * Discards an I/O engine. Any operations still in flight are waited for first but their callbacks are not
+ * called.
+ *
+ * @param engine the engine.
+ */
+PG_EXPORT void PGDiscardRingBufferIOEngine(PGRingBufferIOEngine *engine);
+
+/**
+ * Returns `true` if the engine is using io_uring or `false` if it is using the `readv`/`writev` fallback.
+ *
+ * @param engine the engine.
+ * @return `true` if the engine is using io_uring.
+ */
+PG_EXPORT bool PGRingBufferIOEngineIsAsync(const PGRingBufferIOEngine *engine);
+
+/**
+ * Registers the ring buffer's storage with the kernel so that its pages do not have to be pinned for every
+ * operation. If the ring buffer is later resized the registration is refreshed automatically the next time
+ * there are no operations in flight. A ring buffer must be unregistered before it is discarded. Does nothing in
+ * fallback mode.
+ *
+ * @param engine the engine.
+ * @param buff the ring buffer.
+ * @return `true` if successful or `false` if there was not enough memory.
+ */
+PG_EXPORT bool PGRingBufferIOEngineRegister(PGRingBufferIOEngine *engine, PGRingBuffer *buff);
+
+/**
+ * Removes a ring buffer's registration. The ring buffer must not have any operations in flight.
+ *
+ * @param engine the engine.
+ * @param buff the ring buffer.
+ */
+PG_EXPORT void PGRingBufferIOEngineUnregister(PGRingBufferIOEngine *engine, PGRingBuffer *buff);
+
+/**
+ * Queues a read of up to `maxLength` bytes from the file descriptor into the free space of the ring buffer. The
+ * ring buffer is resized now, if needed, so that the whole read can be accepted. If the ring buffer already has a
+ * write in flight then it can't be resized so the read is limited to the room remaining instead. So is a read into
+ * a `PG_RINGBUFFER_OVERWRITE` ring buffer, whose oldest bytes can't be dropped before the read completes. The
+ * read is not started until `PGRingBufferIOEngineSubmit` or `PGRingBufferIOEngineComplete` is called.
+ *
+ * @param engine the engine.
+ * @param buff the ring buffer.
+ * @param fd the file descriptor.
+ * @param maxLength the maximum number of bytes to read.
+ * @param callback the function to call when the read has finished. May be `NULL`.
+ * @param context passed to the callback.
+ * @return `true` if the read was queued or `false` if the queue is full, the ring buffer could not be expanded
+ *         due to lack of memory, or the ring buffer has a write in flight, or overwrites, and has no room
+ *         remaining.
+ */
+PG_EXPORT bool PGRingBufferIOEngineSubmitRead(PGRingBufferIOEngine *engine, PGRingBuffer *buff, int fd, long maxLength, PGRingBufferIOCallback callback, void *context);
+
+/**
+ * Queues a write of up to `maxLength` bytes from the ring buffer to the file descriptor. The write is not
+ * started until `PGRingBufferIOEngineSubmit` or `PGRingBufferIOEngineComplete` is called.
+ *
+ * @param engine the engine.
+ * @param buff the ring buffer.
+ * @param fd the file descriptor.
+ * @param maxLength the maximum number of bytes to write. If less than one then all of the bytes in the buffer.
+ * @param callback the function to call when the write has finished. May be `NULL`.
+ * @param context passed to the callback.
+ * @return `true` if the write was queued or `false` if the queue is full or the ring buffer is empty.
+ */
+PG_EXPORT bool PGRingBufferIOEngineSubmitWrite(PGRingBufferIOEngine *engine, PGRingBuffer *buff, int fd, long maxLength, PGRingBufferIOCallback callback, void *context);
+
+/**
+ * Starts all of the queued operations without waiting for any of them to finish.
+ *
+ * @param engine the engine.
+ * @return the number of operations started or -1 if there was an error, in which case `errno` is set.
+ */
+PG_EXPORT int PGRingBufferIOEngineSubmit(PGRingBufferIOEngine *engine);
+
+/**
+ * Starts all of the queued operations and then waits for at least `minComplete` operations to finish. Every
+ * finished operation has its ring buffer updated and its callback called.
+ *
+ * @param engine the engine.
+ * @param minComplete the minimum number of operations to wait for. Zero means do not wait.
+ * @return the number of operations finished or -1 if there was an error, in which case `errno` is set.
+ */
+PG_EXPORT int PGRingBufferIOEngineComplete(PGRingBufferIOEngine *engine, int minComplete);
+
+/**
+ * Returns the number of operations that have been queued but have not yet been reported by
+ * `PGRingBufferIOEngineComplete`.
+ *
+ * @param engine the engine.
+ * @return the number of operations in flight.
+ */
+PG_EXPORT long PGRingBufferIOEngineInFlight(const PGRingBufferIOEngine *engine);
+
+__END_DECLS
+
+#endif /* PGRingBufferIOEngine_h */
+
+#pragma clang diagnostic pop
@@ -0,0 +1,145 @@
+//
+//  PGRingBufferJournal.h
+//  PGRingBuffer
+//
+//  Created by Galen Rhodes on 10/16/26.
+//  Copyright © 2020 Project Galen. All rights reserved.
+//
+
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "OCUnusedGlobalDeclarationInspection"
+#ifndef PGRingBufferJournal_h
+#define PGRingBufferJournal_h
+
+#include "PGRingBuffer.h"
+
+__BEGIN_DECLS
+
+/**
+ * A bounded, durable ring of records kept in a memory mapped file, for use as a write-ahead journal. The records,
+ * the head, and the tail all live in the file. Appending and consuming only touch memory. Nothing is durable until
+ * `PGCommitRingBufferJournal` is called, which flushes everything appended and consumed since the last commit with
+ * a single sync (group commit).
+ *
+ * Every record carries a checksum of its position, its generation, its length, and its bytes. The generation goes
+ * up every time the journal is reopened. After a crash, reopening the journal starts from the tail saved in the file
+ * and walks forward over the records whose checksums are good and whose generations don't go down, so it recovers
+ * everything up to the last consistent record without scanning the whole file and never picks up a record left
+ * over from before an earlier recovery. Consumed records whose consumption wasn't committed are read again after a
+ * crash.
+ *
+ * The storage is mapped twice, back to back, so every record is contiguous and can be read in place. A journal can
+ * only be open in one process at a time and, like `PGRingBuffer`, is not thread safe.
+ */
+typedef struct _st_pg_ringbuffer_journal_ PGRingBufferJournal;
+
+/**
+ * The version of the file layout. A journal can only be opened by a library with the same version.
+ */
+#define PG_RINGBUFFER_JOURNAL_VERSION (2)
+
+/**
+ * The number of bytes of framing in front of each record. Records are also padded to a multiple of eight bytes.
+ */
+#define PG_RINGBUFFER_JOURNAL_FRAMING (16)
+
+/**
+ * Opens a journal, creating it if the file doesn't exist or is empty. An existing journal is recovered.
+ *
+ * @param path the path of the file.
+ * @param capacity the capacity of a new journal, including framing. This will be rounded up to the next power of
+ *                 two that is at least the page size. Ignored if the journal already exists.
+ * @return the journal or `NULL` if it could not be opened, in which case `errno` says why. `errno` is `EPROTO` if
+ *         the file isn't a journal with this library's layout version and `EWOULDBLOCK` if it is already open.
+ */
+PG_EXPORT PGRingBufferJournal *PGOpenRingBufferJournal(const char *path, long capacity);
+
+/**
+ * Commits the journal and closes it.
+ *
+ * @param buff the journal.
+ * @return `true` if the final commit succeeded.
+ */
+PG_EXPORT bool PGCloseRingBufferJournal(PGRingBufferJournal *buff);
+
+/**
+ * Appends a record to the end of the journal. The record can be read straight away but isn't durable until the
+ * next commit.
+ *
+ * @param buff the journal.
+ * @param src the bytes of the record.
+ * @param length the length of the record. May be zero.
+ * @return `true` if successful or `false` if there isn't room, in which case nothing is appended. The room freed by
+ *         consuming records can't be reused until the consumption has been committed.
+ */
+PG_EXPORT bool PGAppendToRingBufferJournal(PGRingBufferJournal *buff, const void *src, long length);
+
+/**
+ * Makes everything appended and consumed so far durable with one sync of the file.
+ *
+ * @param buff the journal.
+ * @return `true` if successful or `false` if the sync failed, in which case `errno` says why and nothing since the
+ *         last successful commit can be assumed to be durable.
+ */
+PG_EXPORT bool PGCommitRingBufferJournal(PGRingBufferJournal *buff);
+
+/**
+ * Gets the next record in place without copying or removing it. The span is only valid until the next call that
+ * modifies the journal.
+ *
+ * @param buff the journal.
+ * @param record receives the record.
+ * @return the length of the record or -1 if the journal is empty.
+ */
+PG_EXPORT long PGPeekRecordFromRingBufferJournal(const PGRingBufferJournal *buff, PGRingBufferSpan *record);
+
+/**
+ * Reads the next record into `dest` and consumes it.
+ *
+ * @param buff the journal.
+ * @param dest the destination buffer.
+ * @param maxLength the size of the destination buffer.
+ * @return the length of the record or -1 if the journal is empty or the record is longer than `maxLength`, in
+ *         which case nothing is consumed.
+ */
+PG_EXPORT long PGReadRecordFromRingBufferJournal(PGRingBufferJournal *buff, void *dest, long maxLength);
+
+/**
+ * Consumes up to `count` records without reading them. The consumption isn't durable until the next commit.
+ *
+ * @param buff the journal.
+ * @param count the number of records to consume.
+ * @return the number of records actually consumed.
+ */
+PG_EXPORT long PGRingBufferJournalConsume(PGRingBufferJournal *buff, long count);
+
+/**
+ * Returns the TOTAL capacity of the journal, including framing.
+ *
+ * @param buff the journal.
+ * @return the total capacity.
+ */
+PG_EXPORT long PGRingBufferJournalCapacity(const PGRingBufferJournal *buff);
+
+/**
+ * Returns the number of bytes, including framing, taken up by the records in the journal.
+ *
+ * @param buff the journal.
+ * @return the number of bytes in the journal.
+ */
+PG_EXPORT long PGRingBufferJournalCount(const PGRingBufferJournal *buff);
+
+/**
+ * Returns the number of bytes, including framing, that can be appended before the journal is full. This doesn't
+ * include the room freed by consumption that hasn't been committed yet.
+ *
+ * @param buff the journal.
+ * @return the number of bytes that can be appended.
+ */
+PG_EXPORT long PGRingBufferJournalRemaining(const PGRingBufferJournal *buff);
+
+__END_DECLS
+
+#endif /* PGRingBufferJournal_h */
+
+#pragma clang diagnostic pop
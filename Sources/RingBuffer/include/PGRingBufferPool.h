@@ -0,0 +1,104 @@
+//
+//  PGRingBufferPool.h
+//  PGRingBuffer
+//
+//  Created by Galen Rhodes on 10/16/26.
+//  Copyright © 2020 Project Galen. All rights reserved.
+//
+
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "OCUnusedGlobalDeclarationInspection"
+#ifndef PGRingBufferPool_h
+#define PGRingBufferPool_h
+
+#include "PGRingBuffer.h"
+
+__BEGIN_DECLS
+
+/**
+ * A size-classed pool of memory blocks that can be used as a ring buffer allocator (see
+ * `PGRingBufferPoolAllocator`). Blocks are rounded up to the next power of two and, when they are freed, are
+ * kept on a per-size free list so that the next ring buffer to be created can reuse them without going back to
+ * `malloc`. This covers both the ring buffer headers and their storage. The pool may be shared by any number of
+ * threads.
+ */
+typedef struct _st_pg_ringbuffer_pool_ PGRingBufferPool;
+
+/**
+ * A snapshot of a pool's counters.
+ */
+typedef struct _st_pg_ringbuffer_pool_stats_ {
+    /**
+     * The number of allocations that were satisfied from a free list.
+     */
+    long hits;
+    /**
+     * The number of allocations that had to go to `malloc`, including those too big to be pooled.
+     */
+    long misses;
+    /**
+     * The number of freed blocks that were kept for reuse.
+     */
+    long recycled;
+    /**
+     * The number of freed blocks that were given back to the system because their free list was full or they
+     * were too big to be pooled.
+     */
+    long released;
+    /**
+     * The number of blocks currently waiting on the free lists.
+     */
+    long cachedBlocks;
+    /**
+     * The total size, in bytes, of the blocks currently waiting on the free lists.
+     */
+    long cachedBytes;
+}               PGRingBufferPoolStats;
+
+/**
+ * Creates a new pool.
+ *
+ * @param maxBlocksPerClass the most blocks that will be kept on each free list. If less than one then the
+ *                          default is 64.
+ * @param maxBlockSize the largest block that will be pooled. Larger blocks always come straight from `malloc`.
+ *                     If less than one then the default is 1MiB.
+ * @return the new pool or `NULL` if there was not enough memory.
+ */
+PG_EXPORT PGRingBufferPool *PGCreateRingBufferPool(long maxBlocksPerClass, long maxBlockSize);
+
+/**
+ * Discards a pool and frees all of the blocks on its free lists. Every ring buffer created with the pool's
+ * allocator must already have been discarded.
+ *
+ * @param pool the pool.
+ */
+PG_EXPORT void PGDiscardRingBufferPool(PGRingBufferPool *pool);
+
+/**
+ * Returns the allocator to pass to `PGCreateRingBufferWithAllocator`. The allocator lives as long as the pool.
+ *
+ * @param pool the pool.
+ * @return the pool's allocator.
+ */
+PG_EXPORT const PGRingBufferAllocator *PGRingBufferPoolAllocator(PGRingBufferPool *pool);
+
+/**
+ * Frees all of the blocks currently on the pool's free lists.
+ *
+ * @param pool the pool.
+ */
+PG_EXPORT void PGTrimRingBufferPool(PGRingBufferPool *pool);
+
+/**
+ * Gets a snapshot of the pool's counters. The hit rate is `hits / (hits + misses)`.
+ *
+ * @param pool the pool.
+ * @param stats receives the counters.
+ */
+PG_EXPORT void PGGetRingBufferPoolStats(PGRingBufferPool *pool, PGRingBufferPoolStats *stats);
+
+__END_DECLS
+
+#endif /* PGRingBufferPool_h */
+
+#pragma clang diagnostic pop
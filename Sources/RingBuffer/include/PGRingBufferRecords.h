@@ -0,0 +1,124 @@
+//
+//  PGRingBufferRecords.h
+//  PGRingBuffer
+//
+//  Created by Galen Rhodes on 10/16/26.
+//  Copyright © 2020 Project Galen. All rights reserved.
+//
+
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "OCUnusedGlobalDeclarationInspection"
+#ifndef PGRingBufferRecords_h
+#define PGRingBufferRecords_h
+
+#include "PGRingBuffer.h"
+
+__BEGIN_DECLS
+
+/**
+ * Each record is prefixed with its length as an unsigned LEB128 varint (7 bits per byte, least significant group
+ * first). Records shorter than 128 bytes cost a single byte of framing.
+ */
+#define PG_RECORD_VARINT  0
+/**
+ * Each record is prefixed with its length as a 16-bit little endian integer. Records can be at most 65535 bytes.
+ */
+#define PG_RECORD_FIXED16 2
+/**
+ * Each record is prefixed with its length as a 32-bit little endian integer. Records can be at most 4294967295
+ * bytes.
+ */
+#define PG_RECORD_FIXED32 4
+
+/**
+ * The longest varint length prefix, in bytes. Anything longer is treated as corrupt.
+ */
+#define PG_RECORD_MAX_VARINT 9
+
+/**
+ * Returns the number of bytes that a record of `length` bytes takes up in the ring buffer, including its length
+ * prefix.
+ *
+ * @param format the length prefix format. (`PG_RECORD_VARINT`, `PG_RECORD_FIXED16`, `PG_RECORD_FIXED32`)
+ * @param length the length of the record.
+ * @return the number of bytes or -1 if the format can't hold a record that long.
+ */
+PG_EXPORT long PGRecordFramedSize(int format, long length);
+
+/**
+ * Appends a single record to the end of the ring buffer - resizing the buffer if needed.
+ *
+ * @param buff the buffer.
+ * @param format the length prefix format.
+ * @param src the bytes of the record.
+ * @param length the length of the record. May be zero.
+ * @return `true` if successful or `false` if the record is too long for the format or the buffer could not be
+ *         expanded due to lack of memory, in which case nothing is appended. A `PG_RINGBUFFER_OVERWRITE` buffer
+ *         drops whole records to make room (see `PGAppendRecordsToRingBuffer`).
+ */
+PG_EXPORT bool PGAppendRecordToRingBuffer(PGRingBuffer *buff, int format, const void *src, long length);
+
+/**
+ * Appends any number of records to the end of the ring buffer. The room for all of them is made in one go and
+ * they are written straight into the storage so this is much cheaper than appending them one at a time. Either
+ * all of the records are appended or none of them are.
+ *
+ * If the buffer was created with `PG_RINGBUFFER_OVERWRITE` then, rather than growing, whole records are dropped
+ * from the head until there is room, so that a reader never sees part of a record.
+ *
+ * @param buff the buffer.
+ * @param format the length prefix format.
+ * @param records the records.
+ * @param count the number of records.
+ * @return `true` if successful or `false` if any of the records is too long for the format, the buffer could
+ *         not be expanded due to lack of memory, or the records won't fit in an overwriting buffer even when it
+ *         is empty. Nothing is appended or dropped if it fails.
+ */
+PG_EXPORT bool PGAppendRecordsToRingBuffer(PGRingBuffer *buff, int format, const PGRingBufferSpan *records, long count);
+
+/**
+ * Returns the length of the next record in the ring buffer without removing it. Only the length prefix is
+ * looked at so this is cheap enough to call before every read.
+ *
+ * @param buff the buffer.
+ * @param format the length prefix format.
+ * @return the length of the next record, -1 if the buffer does not hold a complete record yet, or -2 if the
+ *         length prefix is corrupt. A prefix giving a length that the buffer could never hold, because of its
+ *         policy's maximum capacity or, for a `PG_RINGBUFFER_OVERWRITE` buffer, its capacity, is corrupt.
+ */
+PG_EXPORT long PGNextRecordSize(const PGRingBuffer *buff, int format);
+
+/**
+ * Reads the next record from the ring buffer into `dest` and removes it.
+ *
+ * @param buff the buffer.
+ * @param format the length prefix format.
+ * @param dest the destination buffer.
+ * @param maxLength the size of the destination buffer.
+ * @return the length of the record, -1 if the buffer does not hold a complete record yet or the record is longer
+ *         than `maxLength` (see `PGNextRecordSize`), or -2 if the length prefix is corrupt. Nothing is removed
+ *         unless the record was read.
+ */
+PG_EXPORT long PGReadRecordFromRingBuffer(PGRingBuffer *buff, int format, void *dest, long maxLength);
+
+/**
+ * Removes up to `maxRecords` complete records from the ring buffer without copying them. Each record is returned
+ * as a span pointing into the buffer's storage. The spans are only valid until the next call that modifies the
+ * buffer. If a record wraps around the end of the storage then it is first moved so that it doesn't (see
+ * `PGMakeRingBufferContiguous`). Because that would invalidate the records already returned, the batch stops
+ * just before such a record unless it is the first one.
+ *
+ * @param buff the buffer.
+ * @param format the length prefix format.
+ * @param records receives the records.
+ * @param maxRecords the most records to remove.
+ * @return the number of records removed, or -2 if the first record's length prefix is corrupt. A corrupt prefix
+ *         after the first record just ends the batch.
+ */
+PG_EXPORT long PGPopRecordsFromRingBuffer(PGRingBuffer *buff, int format, PGRingBufferSpan *records, long maxRecords);
+
+__END_DECLS
+
+#endif /* PGRingBufferRecords_h */
+
+#pragma clang diagnostic pop
@@ -0,0 +1,112 @@
+//
+//  PGSPSCRingBuffer.h
+//  PGRingBuffer
+//
+//  Created by Galen Rhodes on 10/16/26.
+//  Copyright © 2020 Project Galen. All rights reserved.
+//
+
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "OCUnusedGlobalDeclarationInspection"
+#ifndef PGSPSCRingBuffer_h
+#define PGSPSCRingBuffer_h
+
+#include "PGRingBuffer.h"
+
+__BEGIN_DECLS
+
+/**
+ * A fixed capacity, lock-free ring buffer for passing bytes from exactly one producer thread to exactly one
+ * consumer thread. The append functions may only be called from the producer thread and the read, peek, and
+ * consume functions may only be called from the consumer thread. The buffer never grows.
+ */
+typedef struct _st_pg_spsc_ringbuffer_ PGSPSCRingBuffer;
+
+/**
+ * Creates and initializes a new single-producer/single-consumer ring buffer.
+ *
+ * @param capacity the capacity of the ring buffer. This will be rounded up to the next power of two (minimum
+ *                 eight).
+ * @return the newly created ring buffer or `NULL` if there is no power of two that big that a `long` can hold
+ *         (`errno` is set to `EINVAL`) or there was not enough memory.
+ */
+PG_EXPORT PGSPSCRingBuffer *PGCreateSPSCRingBuffer(long capacity);
+
+/**
+ * Deallocates an existing single-producer/single-consumer ring buffer. Neither thread may be using the buffer.
+ *
+ * @param buff the ring buffer to deallocate.
+ */
+PG_EXPORT void PGDiscardSPSCRingBuffer(PGSPSCRingBuffer *buff);
+
+/**
+ * Append the given bytes to the end of the ring buffer. Either all of the bytes are appended or none of them
+ * are. Producer thread only.
+ *
+ * @param buff the buffer.
+ * @param src the source bytes.
+ * @param length the number of bytes to append.
+ * @return `true` if successful or `false` if there is not currently enough room for all of the bytes.
+ */
+PG_EXPORT bool PGAppendToSPSCRingBuffer(PGSPSCRingBuffer *buff, const void *src, long length);
+
+/**
+ * Reads up to `maxLength` bytes from the ring buffer into `dest`. Consumer thread only.
+ *
+ * @param buff the ring buffer.
+ * @param dest the destination buffer.
+ * @param maxLength the size of the destination buffer.
+ * @return the number of bytes actually read.
+ */
+PG_EXPORT long PGReadFromSPSCRingBuffer(PGSPSCRingBuffer *buff, void *dest, long maxLength);
+
+/**
+ * Get bytes from the buffer without removing them. Consumer thread only.
+ *
+ * @param buff the buffer.
+ * @param dest the destination buffer.
+ * @param maxLength the length of the destination buffer.
+ * @return the number of bytes read.
+ */
+PG_EXPORT long PGPeekFromSPSCRingBuffer(PGSPSCRingBuffer *buff, void *dest, long maxLength);
+
+/**
+ * Effectively reads and forgets the next `length` bytes from the buffer. Consumer thread only.
+ *
+ * @param buff the buffer.
+ * @param length the number of bytes to consume from the buffer.
+ * @return the number of bytes actually consumed.
+ */
+PG_EXPORT long PGSPSCRingBufferConsume(PGSPSCRingBuffer *buff, long length);
+
+/**
+ * Returns the TOTAL capacity of the ring buffer.
+ *
+ * @param buff the buffer.
+ * @return the total capacity.
+ */
+PG_EXPORT long PGSPSCRingBufferCapacity(const PGSPSCRingBuffer *buff);
+
+/**
+ * Returns the number of bytes currently in the ring buffer. When called from the consumer thread this is the
+ * minimum number that can be read. From any other thread the value is only a snapshot.
+ *
+ * @param buff the buffer.
+ * @return the number of bytes in the buffer.
+ */
+PG_EXPORT long PGSPSCRingBufferCount(const PGSPSCRingBuffer *buff);
+
+/**
+ * Returns the number of bytes that the ring buffer can currently accept. When called from the producer thread
+ * this is the minimum number that can be appended. From any other thread the value is only a snapshot.
+ *
+ * @param buff the buffer.
+ * @return the number of bytes the buffer can currently accept.
+ */
+PG_EXPORT long PGSPSCRingBufferRemaining(const PGSPSCRingBuffer *buff);
+
+__END_DECLS
+
+#endif /* PGSPSCRingBuffer_h */
+
+#pragma clang diagnostic pop
@@ -0,0 +1,192 @@
+//
+//  PGSharedRingBuffer.h
+//  PGRingBuffer
+//
+//  Created by Galen Rhodes on 10/16/26.
+//  Copyright © 2020 Project Galen. All rights reserved.
+//
+
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "OCUnusedGlobalDeclarationInspection"
+#ifndef PGSharedRingBuffer_h
+#define PGSharedRingBuffer_h
+
+#include "PGRingBuffer.h"
+
+__BEGIN_DECLS
+
+/**
+ * A fixed capacity, lock-free ring buffer for passing bytes from exactly one producer to exactly one consumer that
+ * can be in different processes. The head, the tail, and the bytes all live in a shared memory object so nothing
+ * goes through the kernel once both sides are attached. Each process has its own `PGSharedRingBuffer` handle to
+ * the same shared memory. As with `PGSPSCRingBuffer`, the append and reserve functions may only be called by the
+ * producer and the read, peek, and consume functions only by the consumer.
+ *
+ * The storage is mapped twice, back to back, so the bytes are always contiguous, the same as a
+ * `PG_RINGBUFFER_MIRRORED` ring buffer.
+ */
+typedef struct _st_pg_shared_ringbuffer_ PGSharedRingBuffer;
+
+/**
+ * The version of the shared memory layout. A buffer can only be attached to by a library with the same version.
+ */
+#define PG_SHARED_RINGBUFFER_VERSION (1)
+
+/**
+ * Creates a new shared memory object and a ring buffer in it, and attaches to it.
+ *
+ * @param name the name of the shared memory object, as given to `shm_open` (e.g. "/capture"). It must not
+ *             already exist. If `NULL` then the object is anonymous and the only way for another process to
+ *             attach to it is through its file descriptor (see `PGSharedRingBufferFD`), either inherited or passed
+ *             over a Unix socket.
+ * @param capacity the capacity of the ring buffer. This will be rounded up to the next power of two that is at
+ *                 least the page size.
+ * @return the newly created ring buffer or `NULL` if it could not be created, in which case `errno` says why.
+ */
+PG_EXPORT PGSharedRingBuffer *PGCreateSharedRingBuffer(const char *name, long capacity);
+
+/**
+ * Attaches to a ring buffer that was created by `PGCreateSharedRingBuffer`, usually in another process.
+ *
+ * @param name the name of the shared memory object.
+ * @return the ring buffer or `NULL` if it could not be attached to, in which case `errno` says why. `errno` is
+ *         `EPROTO` if the object doesn't hold a ring buffer with this library's layout version, which includes a
+ *         ring buffer that is still being created.
+ */
+PG_EXPORT PGSharedRingBuffer *PGAttachSharedRingBuffer(const char *name);
+
+/**
+ * Attaches to a ring buffer through a file descriptor for its shared memory object. The file descriptor is
+ * duplicated so the caller still owns `fd`.
+ *
+ * @param fd the file descriptor.
+ * @return the ring buffer or `NULL` if it could not be attached to. See `PGAttachSharedRingBuffer`.
+ */
+PG_EXPORT PGSharedRingBuffer *PGAttachSharedRingBufferFD(int fd);
+
+/**
+ * Detaches from a ring buffer and frees the handle. The shared memory itself, and any bytes still in it, stay
+ * around for as long as another process is attached or the object still has a name.
+ *
+ * @param buff the ring buffer to detach from.
+ */
+PG_EXPORT void PGDetachSharedRingBuffer(PGSharedRingBuffer *buff);
+
+/**
+ * Removes the name of a shared memory object created by `PGCreateSharedRingBuffer`. Processes that are already
+ * attached are not affected and the memory is freed once the last one detaches.
+ *
+ * @param name the name of the shared memory object.
+ * @return `true` if successful or `false` if not, in which case `errno` says why.
+ */
+PG_EXPORT bool PGUnlinkSharedRingBuffer(const char *name);
+
+/**
+ * Returns the file descriptor of the ring buffer's shared memory object. It belongs to the handle and is closed
+ * by `PGDetachSharedRingBuffer`.
+ *
+ * @param buff the buffer.
+ * @return the file descriptor.
+ */
+PG_EXPORT int PGSharedRingBufferFD(const PGSharedRingBuffer *buff);
+
+/**
+ * Append the given bytes to the end of the ring buffer. Either all of the bytes are appended or none of them
+ * are. Producer only.
+ *
+ * @param buff the buffer.
+ * @param src the source bytes.
+ * @param length the number of bytes to append.
+ * @return `true` if successful or `false` if there is not currently enough room for all of the bytes.
+ */
+PG_EXPORT bool PGAppendToSharedRingBuffer(PGSharedRingBuffer *buff, const void *src, long length);
+
+/**
+ * Reserves room for `length` bytes at the end of the ring buffer so that the producer can write them in place.
+ * Nothing is added to the buffer until `PGSharedRingBufferCommit` is called. Producer only.
+ *
+ * @param buff the buffer.
+ * @param length the number of bytes wanted.
+ * @return where to write the bytes or `NULL` if there is not currently room for all of them.
+ */
+PG_EXPORT void *PGSharedRingBufferReserve(PGSharedRingBuffer *buff, long length);
+
+/**
+ * Adds `length` bytes, previously written to the room returned by `PGSharedRingBufferReserve`, to the end of the
+ * ring buffer and makes them visible to the consumer. Producer only.
+ *
+ * @param buff the buffer.
+ * @param length the number of bytes actually written. This must not be more than was reserved.
+ */
+PG_EXPORT void PGSharedRingBufferCommit(PGSharedRingBuffer *buff, long length);
+
+/**
+ * Reads up to `maxLength` bytes from the ring buffer into `dest`. Consumer only.
+ *
+ * @param buff the ring buffer.
+ * @param dest the destination buffer.
+ * @param maxLength the size of the destination buffer.
+ * @return the number of bytes actually read.
+ */
+PG_EXPORT long PGReadFromSharedRingBuffer(PGSharedRingBuffer *buff, void *dest, long maxLength);
+
+/**
+ * Get bytes from the buffer without removing them. Consumer only.
+ *
+ * @param buff the buffer.
+ * @param dest the destination buffer.
+ * @param maxLength the length of the destination buffer.
+ * @return the number of bytes read.
+ */
+PG_EXPORT long PGPeekFromSharedRingBuffer(PGSharedRingBuffer *buff, void *dest, long maxLength);
+
+/**
+ * Get the bytes in the buffer, in place, without copying or removing them. Once they have been processed they can
+ * be released with `PGSharedRingBufferConsume`. Consumer only.
+ *
+ * @param buff the buffer.
+ * @param span receives the readable bytes, which are always contiguous.
+ * @return the number of bytes in the span.
+ */
+PG_EXPORT long PGPeekSpanFromSharedRingBuffer(PGSharedRingBuffer *buff, PGRingBufferSpan *span);
+
+/**
+ * Effectively reads and forgets the next `length` bytes from the buffer. Consumer only.
+ *
+ * @param buff the buffer.
+ * @param length the number of bytes to consume from the buffer.
+ * @return the number of bytes actually consumed.
+ */
+PG_EXPORT long PGSharedRingBufferConsume(PGSharedRingBuffer *buff, long length);
+
+/**
+ * Returns the TOTAL capacity of the ring buffer.
+ *
+ * @param buff the buffer.
+ * @return the total capacity.
+ */
+PG_EXPORT long PGSharedRingBufferCapacity(const PGSharedRingBuffer *buff);
+
+/**
+ * Returns the number of bytes currently in the ring buffer. When called by the consumer this is the minimum
+ * number that can be read. Anywhere else the value is only a snapshot.
+ *
+ * @param buff the buffer.
+ * @return the number of bytes in the buffer.
+ */
+PG_EXPORT long PGSharedRingBufferCount(const PGSharedRingBuffer *buff);
+
+/**
+ * Returns the number of bytes that the ring buffer can currently accept. When called by the producer this is the
+ * minimum number that can be appended. Anywhere else the value is only a snapshot.
+ *
+ * @param buff the buffer.
+ * @return the number of bytes the buffer can currently accept.
+ */
+PG_EXPORT long PGSharedRingBufferRemaining(const PGSharedRingBuffer *buff);
+
+__END_DECLS
+
+#endif /* PGSharedRingBuffer_h */
+
+#pragma clang diagnostic pop